@@ -19,6 +19,9 @@
 #include <unordered_map>
 #include <vector>
 
+#include "rcu.h"
+#include "route_table.h"
+
 using asio::ip::tcp;
 
 template <class T>
@@ -59,10 +62,18 @@ class BasicSession : public std::enable_shared_from_this<BasicSession<T>> {
   T* user_context_ = nullptr;
 };
 
-template <class T = void>
+/**
+ * Routes为编译期路由表 RouteTable<Route<...>...>，在运行期注册的处理函数
+ * 之前匹配，命中时直接调用处理函数，不经过哈希表和 std::function
+ */
+template <class T = void, class Routes = RouteTable<>>
 class HttpServer {
  public:
   using Session = BasicSession<T>;
+  using Handler =
+      std::function<int(std::shared_ptr<Session>, std::string&, bool&)>;
+  using HandlerMap = std::unordered_map<std::string, Handler>;
+
   HttpServer(asio::io_context& io_context, unsigned short port)
       : io_context_(io_context),
         acceptor_(io_context, tcp::endpoint(tcp::v4(), port)) {
@@ -108,10 +119,22 @@ class HttpServer {
   }
 
   void Start() { Accept(); }
-  void RegisterHandler(const std::string& url,
-                       const std::function<int(std::shared_ptr<Session>,
-                                               std::string&, bool&)>& handler) {
-    handlers_[url] = handler;
+
+  /**
+   * 以下路由修改可以在服务器运行期间从任意线程调用：
+   * 复制当前路由表、修改副本后原子替换，正在处理的请求继续使用旧表
+   */
+  void RegisterHandler(const std::string& url, const Handler& handler) {
+    handlers_.Update([&](HandlerMap& handlers) { handlers[url] = handler; });
+  }
+
+  void UnregisterHandler(const std::string& url) {
+    handlers_.Update([&](HandlerMap& handlers) { handlers.erase(url); });
+  }
+
+  // 一次替换整张路由表，例如推送新的配置
+  void ReplaceHandlers(HandlerMap handlers) {
+    handlers_.Store(std::make_unique<HandlerMap>(std::move(handlers)));
   }
 
  private:
@@ -149,14 +172,38 @@ class HttpServer {
                      request_data.size());
 
       if (session->is_complete_) {
-        auto handler = handlers_.find(session->url_);
-        if (handler != handlers_.end()) {
-          std::string response_data;
-          bool keep_alive = true;
-          if (session->headers_.count("Connection:") &&
-              session->headers_["Connection:"] == "close") {
-            keep_alive = false;
+        bool keep_alive = true;
+        if (session->headers_.count("Connection:") &&
+            session->headers_["Connection:"] == "close") {
+          keep_alive = false;
+        }
+
+        // 先匹配编译期路由表
+        if constexpr (Routes::kRouteCount > 0) {
+          int route = Routes::Find(session->url_);
+          if (route >= 0) {
+            std::string response_data;
+            if (Routes::Invoke(route, session, response_data, keep_alive) !=
+                0) {
+              SendResponsePartition(
+                  session, response_data,
+                  [route](std::shared_ptr<Session> session,
+                          std::string& response_data, bool& keep_alive) {
+                    return Routes::Invoke(route, session, response_data,
+                                          keep_alive);
+                  });
+            } else {
+              SendResponseComplete(session, response_data, keep_alive);
+            }
+            return;
           }
+        }
+
+        // 读路由表快照，不加锁；持有期间旧表不会被释放
+        auto handlers = handlers_.Read();
+        auto handler = handlers->find(session->url_);
+        if (handler != handlers->end()) {
+          std::string response_data;
           if (handler->second(session, response_data, keep_alive) != 0) {
             SendResponsePartition(session, response_data, handler->second);
           } else {
@@ -279,9 +326,7 @@ class HttpServer {
 
   asio::io_context& io_context_;
   asio::ip::tcp::acceptor acceptor_;
-  std::unordered_map<std::string, std::function<int(std::shared_ptr<Session>,
-                                                    std::string&, bool&)>>
-      handlers_;
+  RcuPtr<HandlerMap> handlers_;
 };
 
 #endif
\ No newline at end of file
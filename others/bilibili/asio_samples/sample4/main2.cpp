@@ -1,24 +1,29 @@
 #include "httpserver2.h"
 
+// 编译期路由的处理函数，无状态，可以被内联
+struct HelloHandler {
+  template <class SessionPtr>
+  int operator()(SessionPtr session, std::string& response_data,
+                 bool& keep_alive) const {
+    response_data =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 13\r\n"
+        "Content-Type: text/plain\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n"
+        "Hello, world!";
+    keep_alive = true;
+    return 0;
+  }
+};
+
 int main() {
   try {
     asio::io_context io_context;
 
-    // 创建HTTP服务器
-    HttpServer<> server(io_context, 80);  // HTTP标准端口为80
-    server.RegisterHandler(
-        "/hello",
-        [](auto session, std::string& response_data, bool& keep_alive) {
-          response_data =
-              "HTTP/1.1 200 OK\r\n"
-              "Content-Length: 13\r\n"
-              "Content-Type: text/plain\r\n"
-              "Connection: keep-alive\r\n"
-              "\r\n"
-              "Hello, world!";
-          keep_alive = true;
-          return 0;
-        });
+    // 创建HTTP服务器，/hello 在编译期路由表中，直接调用 HelloHandler
+    HttpServer<void, RouteTable<Route<"/hello", HelloHandler>>> server(
+        io_context, 80);  // HTTP标准端口为80
     server.Start();
 
     // 创建一个线程池
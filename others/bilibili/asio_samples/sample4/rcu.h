@@ -0,0 +1,194 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * RCU风格的只读快照指针
+ *
+ * 读者通过 Read() 拿到当前对象的快照，期间只做几次原子读写，
+ * 不加锁、不等待；写者复制当前对象，在副本上修改后原子地替换指针，
+ * 旧对象交给基于epoch的回收：只有在替换前进入的读者全部退出后才释放。
+ * 适合读远多于写的场景，例如运行期可热更新的路由表和配置。
+ */
+
+// 全局的epoch域，记录每个读线程当前所处的epoch
+class EpochDomain {
+ public:
+  static constexpr int kMaxThreads = 256;        // 最多的读线程数
+  static constexpr uint64_t kIdle = UINT64_MAX;  // 线程不在读临界区
+
+  static EpochDomain& Global() {
+    static EpochDomain domain;
+    return domain;
+  }
+
+  // 进入读临界区，可以嵌套
+  void Enter() {
+    ThreadState& state = GetThreadState();
+    if (state.depth++ == 0) {
+      // 读epoch、写槽位、随后读受保护的指针，与写者的exchange、Advance和
+      // IsQuiescent中的读取都是seq_cst，处于同一个全序中：读到旧指针的
+      // 读者，槽位写入必然先于写者的检查，且写入的epoch不大于退役epoch
+      state.slot->epoch.store(epoch_.load(std::memory_order_seq_cst),
+                              std::memory_order_seq_cst);
+    }
+  }
+
+  // 退出读临界区
+  void Exit() {
+    ThreadState& state = GetThreadState();
+    if (--state.depth == 0) {
+      state.slot->epoch.store(kIdle, std::memory_order_release);
+    }
+  }
+
+  // 推进epoch，返回推进前的epoch，之前退役的对象以它为界回收
+  uint64_t Advance() {
+    return epoch_.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  // 是否所有在retire_epoch及之前进入的读者都已退出
+  bool IsQuiescent(uint64_t retire_epoch) const {
+    for (const Slot& slot : slots_) {
+      uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+      if (epoch != kIdle && epoch <= retire_epoch) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // 每个读线程独占一个缓存行，避免伪共享
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{kIdle};
+    std::atomic<bool> in_use{false};
+  };
+
+  // 线程退出时归还槽位
+  struct ThreadState {
+    Slot* slot = nullptr;
+    int depth = 0;
+
+    ~ThreadState() {
+      if (slot) {
+        slot->epoch.store(kIdle, std::memory_order_release);
+        slot->in_use.store(false, std::memory_order_release);
+      }
+    }
+  };
+
+  EpochDomain() = default;
+
+  ThreadState& GetThreadState() {
+    thread_local ThreadState state;
+    if (!state.slot) {
+      state.slot = AcquireSlot();
+    }
+    return state;
+  }
+
+  Slot* AcquireSlot() {
+    for (;;) {
+      for (Slot& slot : slots_) {
+        bool expected = false;
+        if (!slot.in_use.load(std::memory_order_relaxed) &&
+            slot.in_use.compare_exchange_strong(expected, true,
+                                                std::memory_order_acq_rel)) {
+          return &slot;
+        }
+      }
+      // 槽位用尽，等待其他线程退出；线程池场景下不会发生
+      std::this_thread::yield();
+    }
+  }
+
+  std::atomic<uint64_t> epoch_{0};  // 全局epoch
+  Slot slots_[kMaxThreads];         // 读线程的epoch槽位
+};
+
+template <class T>
+class RcuPtr {
+ public:
+  // 读快照，存活期间指向的对象不会被释放
+  class ReadGuard {
+   public:
+    explicit ReadGuard(const RcuPtr& owner) {
+      EpochDomain::Global().Enter();
+      ptr_ = owner.current_.load(std::memory_order_seq_cst);
+    }
+    ~ReadGuard() { EpochDomain::Global().Exit(); }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    const T* operator->() const { return ptr_; }
+    const T& operator*() const { return *ptr_; }
+
+   private:
+    const T* ptr_;
+  };
+
+  explicit RcuPtr(std::unique_ptr<T> initial = std::make_unique<T>())
+      : current_(initial.release()) {}
+
+  ~RcuPtr() {
+    // 析构时不应再有读者
+    delete current_.load(std::memory_order_relaxed);
+  }
+
+  RcuPtr(const RcuPtr&) = delete;
+  RcuPtr& operator=(const RcuPtr&) = delete;
+
+  // 获取当前对象的读快照，无锁且不等待
+  ReadGuard Read() const { return ReadGuard(*this); }
+
+  // 复制当前对象，用mutate修改副本后发布，写者之间互斥
+  template <class F>
+  void Update(F&& mutate) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto next = std::make_unique<T>(*current_.load(std::memory_order_relaxed));
+    mutate(*next);
+    Publish(std::move(next));
+  }
+
+  // 直接发布一个新对象
+  void Store(std::unique_ptr<T> next) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    Publish(std::move(next));
+  }
+
+ private:
+  // 替换指针并退役旧对象，调用者持有写锁
+  void Publish(std::unique_ptr<T> next) {
+    std::unique_ptr<const T> old(
+        current_.exchange(next.release(), std::memory_order_seq_cst));
+    uint64_t retire_epoch = EpochDomain::Global().Advance();
+    retired_.emplace_back(retire_epoch, std::move(old));
+    Reclaim();
+  }
+
+  // 释放所有读者都已离开的旧对象
+  void Reclaim() {
+    auto it = retired_.begin();
+    while (it != retired_.end() &&
+           EpochDomain::Global().IsQuiescent(it->first)) {
+      ++it;
+    }
+    retired_.erase(retired_.begin(), it);
+  }
+
+  std::atomic<T*> current_;  // 当前发布的对象
+  std::mutex write_mutex_;   // 写者之间互斥
+  std::vector<std::pair<uint64_t, std::unique_ptr<const T>>>
+      retired_;              // 等待回收的旧对象，按epoch递增
+};
+
+#endif
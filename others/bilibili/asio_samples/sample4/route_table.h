@@ -0,0 +1,277 @@
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * 编译期路由表
+ *
+ * 路由在编译期以 Route<"/path", Handler> 的形式列出，RouteTable 在编译期
+ * 为这些路径生成完美哈希：请求URL只做一次哈希，两次查表得到唯一的
+ * 候选路由，再做一次字符串比较。路由的长度和首尾8字节足以区分彼此时，
+ * 哈希只读取这16个字节，开销与URL长度无关。处理函数是无状态的函数对象类型，
+ * 通过展开的分支直接调用，可以被内联，没有 std::function 的类型擦除。
+ *
+ * 用法：
+ *   struct Hello {
+ *     int operator()(std::shared_ptr<Session>, std::string&, bool&) const;
+ *   };
+ *   using Routes = RouteTable<Route<"/hello", Hello>, Route<"/info", Info>>;
+ *   int index = Routes::Find(url);
+ *   if (index >= 0) Routes::Invoke(index, session, response, keep_alive);
+ */
+
+// 可以作为模板参数的字符串字面量
+template <std::size_t N>
+struct FixedString {
+  constexpr FixedString(const char (&str)[N]) {
+    for (std::size_t i = 0; i < N; ++i) {
+      data[i] = str[i];
+    }
+  }
+
+  constexpr std::string_view View() const { return {data, N - 1}; }
+
+  char data[N];
+};
+
+// 一条编译期路由
+template <FixedString Path, class Handler>
+struct Route {
+  static constexpr std::string_view kPath = Path.View();
+  using HandlerType = Handler;
+};
+
+namespace route_table_detail {
+
+// 按小端序读取从pos开始最多8个字节，不足8字节时高位补0
+constexpr uint64_t Load(std::string_view str, std::size_t pos) {
+  std::size_t end = pos + 8 < str.size() ? pos + 8 : str.size();
+  // 运行期的完整8字节直接读取，编译期和其余情况逐字节拼接，两者结果一致
+  if (!std::is_constant_evaluated() && end - pos == 8 &&
+      std::endian::native == std::endian::little) {
+    uint64_t word;
+    std::memcpy(&word, str.data() + pos, 8);
+    return word;
+  }
+
+  uint64_t word = 0;
+  for (std::size_t i = end; i > pos; --i) {
+    word = (word << 8) | static_cast<unsigned char>(str[i - 1]);
+  }
+  return word;
+}
+
+// 64位整数的终结混合，使低位也充分打散
+constexpr uint64_t Finalize(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// 完整哈希：按8字节分块的乘法-异或
+constexpr uint64_t FullHash(std::string_view str) {
+  constexpr uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+  uint64_t hash = str.size() * kMul;
+  for (std::size_t pos = 0; pos < str.size(); pos += 8) {
+    hash = (hash ^ Load(str, pos)) * kMul;
+    hash ^= hash >> 29;
+  }
+  return Finalize(hash);
+}
+
+// 快速哈希：只看长度、开头8字节和末尾8字节，与URL长度无关
+// 只要求能区分表中的路由，是否真正命中由最后的字符串比较决定
+constexpr uint64_t FastHash(std::string_view str) {
+  uint64_t head = Load(str, 0);
+  uint64_t tail = str.size() > 8 ? Load(str, str.size() - 8) : 0;
+  return Finalize(head * 0x9E3779B97F4A7C15ULL ^
+                  tail * 0xC2B2AE3D27D4EB4FULL ^ str.size());
+}
+
+// 用桶的位移值重新打散哈希，得到最终的槽位
+constexpr uint64_t Mix(uint64_t hash, uint32_t displacement) {
+  return Finalize(hash ^ displacement * 0x9E3779B97F4A7C15ULL);
+}
+
+// 不小于n的2的幂
+constexpr std::size_t NextPowerOfTwo(std::size_t n) {
+  std::size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace route_table_detail
+
+template <class... Routes>
+class RouteTable {
+ public:
+  static constexpr std::size_t kRouteCount = sizeof...(Routes);
+
+  // 查找URL对应的路由下标，未匹配时返回-1
+  static constexpr int Find(std::string_view url) {
+    if constexpr (kRouteCount == 0) {
+      return -1;
+    } else {
+      uint64_t hash = Hash(url);
+      uint32_t displacement = kTables.displacements[hash & (kBucketCount - 1)];
+      int index =
+          kTables.slots[route_table_detail::Mix(hash, displacement) &
+                        (kSlotCount - 1)];
+      return index >= 0 && kPaths[index] == url ? index : -1;
+    }
+  }
+
+  // 调用下标对应路由的处理函数，所有处理函数的返回值类型必须相同
+  template <class... Args>
+  static decltype(auto) Invoke(int index, Args&&... args) {
+    return InvokeImpl(std::make_index_sequence<kRouteCount>(), index,
+                      std::forward<Args>(args)...);
+  }
+
+  // 获取下标对应路由的路径
+  static constexpr std::string_view GetPath(int index) {
+    return kPaths[index];
+  }
+
+ private:
+  static constexpr std::size_t kBucketCount =
+      route_table_detail::NextPowerOfTwo(kRouteCount);
+  static constexpr std::size_t kSlotCount =
+      route_table_detail::NextPowerOfTwo(kRouteCount * 2);
+  static constexpr std::array<std::string_view, kRouteCount> kPaths = {
+      Routes::kPath...};
+
+  // 所有路由的快速哈希互不相同时使用快速哈希，否则退回完整哈希
+  static constexpr bool UseFastHash() {
+    for (std::size_t i = 0; i < kRouteCount; ++i) {
+      for (std::size_t j = 0; j < i; ++j) {
+        if (route_table_detail::FastHash(kPaths[i]) ==
+            route_table_detail::FastHash(kPaths[j])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static constexpr bool kUseFastHash = UseFastHash();
+
+  static constexpr uint64_t Hash(std::string_view url) {
+    return kUseFastHash ? route_table_detail::FastHash(url)
+                        : route_table_detail::FullHash(url);
+  }
+
+  // 完美哈希的两级表：桶的位移值和槽位对应的路由下标
+  struct Tables {
+    std::array<uint32_t, kBucketCount> displacements{};
+    std::array<int, kSlotCount> slots{};
+  };
+
+  // 编译期构建完美哈希（hash-and-displace）：
+  // 路由先按哈希分桶，从大桶开始为每个桶寻找一个位移值，
+  // 使桶内所有路由都落到互不相同的空槽位
+  static constexpr Tables BuildTables() {
+    Tables tables;
+    for (auto& slot : tables.slots) {
+      slot = -1;
+    }
+
+    std::array<uint64_t, kRouteCount> hashes{};
+    std::array<std::size_t, kBucketCount> bucket_sizes{};
+    for (std::size_t i = 0; i < kRouteCount; ++i) {
+      hashes[i] = Hash(kPaths[i]);
+      ++bucket_sizes[hashes[i] & (kBucketCount - 1)];
+      for (std::size_t j = 0; j < i; ++j) {
+        if (kPaths[i] == kPaths[j]) {
+          throw "duplicate route";
+        }
+      }
+    }
+
+    std::array<bool, kBucketCount> done{};
+    for (std::size_t round = 0; round < kBucketCount; ++round) {
+      // 选出剩余的最大桶
+      std::size_t bucket = 0;
+      std::size_t largest = 0;
+      for (std::size_t b = 0; b < kBucketCount; ++b) {
+        if (!done[b] && bucket_sizes[b] >= largest) {
+          bucket = b;
+          largest = bucket_sizes[b];
+        }
+      }
+      done[bucket] = true;
+      if (largest == 0) {
+        continue;
+      }
+
+      bool placed = false;
+      for (uint32_t displacement = 0; !placed && displacement < 1000000;
+           ++displacement) {
+        std::array<std::size_t, kRouteCount> candidate{};
+        std::size_t count = 0;
+        placed = true;
+        for (std::size_t i = 0; i < kRouteCount && placed; ++i) {
+          if ((hashes[i] & (kBucketCount - 1)) != bucket) {
+            continue;
+          }
+          std::size_t slot = route_table_detail::Mix(hashes[i], displacement) &
+                             (kSlotCount - 1);
+          if (tables.slots[slot] >= 0) {
+            placed = false;
+          }
+          for (std::size_t k = 0; k < count && placed; ++k) {
+            if (candidate[k] == slot) {
+              placed = false;
+            }
+          }
+          candidate[count++] = slot;
+        }
+
+        if (placed) {
+          tables.displacements[bucket] = displacement;
+          count = 0;
+          for (std::size_t i = 0; i < kRouteCount; ++i) {
+            if ((hashes[i] & (kBucketCount - 1)) == bucket) {
+              tables.slots[candidate[count++]] = static_cast<int>(i);
+            }
+          }
+        }
+      }
+      if (!placed) {
+        throw "no perfect hash found";
+      }
+    }
+    return tables;
+  }
+
+  static constexpr Tables kTables = BuildTables();
+
+  template <std::size_t... I, class... Args>
+  static decltype(auto) InvokeImpl(std::index_sequence<I...>, int index,
+                                   Args&&... args) {
+    using Result = std::common_type_t<
+        std::invoke_result_t<typename Routes::HandlerType, Args...>...>;
+    // 展开为按下标的分支，编译器通常生成跳转表并内联处理函数
+    Result result{};
+    ((index == static_cast<int>(I)
+          ? (result = typename Routes::HandlerType{}(
+                 std::forward<Args>(args)...),
+             true)
+          : false) ||
+     ...);
+    return result;
+  }
+};
+
+#endif
@@ -0,0 +1,127 @@
+// 编译期路由表与 unordered_map + std::function 分发的对比
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "route_table.h"
+
+namespace {
+
+// 模拟一个网关服务的固定路由
+const char* const kPaths[] = {
+    "/",
+    "/hello",
+    "/info",
+    "/health",
+    "/metrics",
+    "/login",
+    "/logout",
+    "/api/v1/users",
+    "/api/v1/orders",
+    "/api/v1/products",
+    "/api/v1/cart",
+    "/api/v1/search",
+    "/api/v1/recommend",
+    "/api/v2/users",
+    "/api/v2/orders",
+    "/api/v2/products",
+    "/static/app.js",
+    "/static/app.css",
+    "/favicon.ico",
+    "/robots.txt",
+};
+
+constexpr int kRouteCount = sizeof(kPaths) / sizeof(kPaths[0]);
+
+// 处理函数：写入一小段响应，返回0表示响应完整
+template <int N>
+struct Handler {
+  int operator()(std::string& response) const {
+    response.assign(kPaths[N]);
+    return 0;
+  }
+};
+
+using Routes = RouteTable<
+    Route<"/", Handler<0>>, Route<"/hello", Handler<1>>,
+    Route<"/info", Handler<2>>, Route<"/health", Handler<3>>,
+    Route<"/metrics", Handler<4>>, Route<"/login", Handler<5>>,
+    Route<"/logout", Handler<6>>, Route<"/api/v1/users", Handler<7>>,
+    Route<"/api/v1/orders", Handler<8>>,
+    Route<"/api/v1/products", Handler<9>>, Route<"/api/v1/cart", Handler<10>>,
+    Route<"/api/v1/search", Handler<11>>,
+    Route<"/api/v1/recommend", Handler<12>>,
+    Route<"/api/v2/users", Handler<13>>, Route<"/api/v2/orders", Handler<14>>,
+    Route<"/api/v2/products", Handler<15>>,
+    Route<"/static/app.js", Handler<16>>,
+    Route<"/static/app.css", Handler<17>>, Route<"/favicon.ico", Handler<18>>,
+    Route<"/robots.txt", Handler<19>>>;
+
+static_assert(Routes::kRouteCount == kRouteCount);
+static_assert(Routes::Find("/api/v1/cart") == 10);
+static_assert(Routes::Find("/api/v1/car") == -1);
+
+template <int... N>
+void RegisterAll(
+    std::unordered_map<std::string, std::function<int(std::string&)>>* map,
+    std::integer_sequence<int, N...>) {
+  (((*map)[kPaths[N]] = Handler<N>{}), ...);
+}
+
+// 请求URL序列：命中的路由轮流出现，每8个请求有1个未命中
+std::vector<std::string> MakeUrls() {
+  std::vector<std::string> urls;
+  for (int i = 0; i < 1024; ++i) {
+    if (i % 8 == 7) {
+      urls.push_back("/api/v1/unknown" + std::to_string(i));
+    } else {
+      urls.push_back(kPaths[(i * 7) % kRouteCount]);
+    }
+  }
+  return urls;
+}
+
+// 当前 HttpServer 的分发方式
+void BM_MapDispatch(benchmark::State& state) {
+  std::unordered_map<std::string, std::function<int(std::string&)>> handlers;
+  RegisterAll(&handlers, std::make_integer_sequence<int, kRouteCount>());
+  std::vector<std::string> urls = MakeUrls();
+  std::string response;
+  response.reserve(64);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    const std::string& url = urls[i++ & (urls.size() - 1)];
+    auto handler = handlers.find(url);
+    int result = handler != handlers.end() ? handler->second(response) : -1;
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(response.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MapDispatch);
+
+// 编译期路由表
+void BM_RouteTableDispatch(benchmark::State& state) {
+  std::vector<std::string> urls = MakeUrls();
+  std::string response;
+  response.reserve(64);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    const std::string& url = urls[i++ & (urls.size() - 1)];
+    int route = Routes::Find(url);
+    int result = route >= 0 ? Routes::Invoke(route, response) : -1;
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(response.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouteTableDispatch);
+
+}  // namespace
+
+BENCHMARK_MAIN();
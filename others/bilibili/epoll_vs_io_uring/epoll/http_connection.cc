@@ -2,15 +2,35 @@
 #include "http_connection.h"
 
 #include <errno.h>
-#include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "http_server.h"
 
-HttpConnection::HttpConnection(int sockfd, HttpServer* server)
-    : sockfd_(sockfd), server_(server), read_index_(0), write_index_(0) {}
+namespace {
+
+// 合并等待的结果经服务器按描述符和序号找回连接，连接已关闭或描述符
+// 被复用时丢弃结果
+RequestCoalescer::Waiter MakeCoalescedHandler(HttpServer* server, int fd,
+                                              uint64_t serial) {
+  return [server, fd, serial](std::shared_ptr<const SharedBuffer> wire) {
+    if (HttpConnection* conn = server->FindConnection(fd, serial)) {
+      conn->OnCoalescedResponse(std::move(wire));
+    }
+  };
+}
+
+}  // namespace
+
+HttpConnection::HttpConnection(int sockfd, uint64_t serial, HttpServer* server)
+    : sockfd_(sockfd),
+      serial_(serial),
+      server_(server),
+      events_(EPOLLIN),
+      pipeline_(server->GetCompletionQueue(), sockfd, serial,
+                MakeCoalescedHandler(server, sockfd, serial)) {}
 
 HttpConnection::~HttpConnection() {
   if (sockfd_ >= 0) {
@@ -21,38 +41,13 @@ HttpConnection::~HttpConnection() {
 
 void HttpConnection::OnRead() {
   // 读取数据
-  ssize_t n =
-      read(sockfd_, read_buffer_ + read_index_, kBufferSize - read_index_);
+  ssize_t n = read(sockfd_, pipeline_.GetInputSpace(),
+                   pipeline_.GetInputSpaceSize());
 
   if (n > 0) {
-    read_index_ += n;
-
-    // 解析HTTP请求
-    if (request_.Parse(read_buffer_, read_index_)) {
-      // 请求解析完成，生成响应
-      HttpResponse response;
-
-      // 调用回调函数处理请求
-      if (request_callback_) {
-        request_callback_(request_, &response);
-      } else {
-        // 默认响应
-        response.SetStatusCode(HttpStatusCode::k404NotFound);
-        response.SetBody("<html><body><h1>404 Not Found</h1></body></html>");
-        response.SetHeader("Content-Type", "text/html");
-      }
-
-      // 生成响应字符串
-      write_buffer_ = response.ToString();
-      write_index_ = 0;
-
-      // 触发写事件
-      server_->ModifyEvent(sockfd_, EPOLLOUT);
-
-      // 重置请求，准备处理下一个请求
-      request_.Reset();
-      read_index_ = 0;
-    }
+    // 处理已完整到达的请求，从本轮事件循环醒来时开始排队
+    pipeline_.OnInput(n, server_->GetLoopTime());
+    UpdateEvents();
   } else if (n == 0) {
     // 对端关闭连接
     Close();
@@ -65,20 +60,31 @@ void HttpConnection::OnRead() {
 }
 
 void HttpConnection::OnWrite() {
-  // 发送数据
-  ssize_t n = write(sockfd_, write_buffer_.c_str() + write_index_,
-                    write_buffer_.size() - write_index_);
+  const OutputQueue& output = pipeline_.GetOutput();
+  if (output.IsEmpty()) {
+    UpdateEvents();
+    return;
+  }
+
+  // 把发送队列中的多段数据用writev一次发送
+  OutputSegment segments[kMaxWriteSegments];
+  struct iovec iov[kMaxWriteSegments];
+  int count = output.GetSegments(segments, kMaxWriteSegments);
+  for (int i = 0; i < count; ++i) {
+    iov[i].iov_base = const_cast<char*>(segments[i].data);
+    iov[i].iov_len = segments[i].size;
+  }
+
+  ssize_t n = writev(sockfd_, iov, count);
 
   if (n > 0) {
-    write_index_ += n;
-
-    // 检查是否发送完毕
-    if (write_index_ >= write_buffer_.size()) {
-      // 发送完毕，重新注册读事件
-      server_->ModifyEvent(sockfd_, EPOLLIN);
-      write_buffer_.clear();
-      write_index_ = 0;
+    pipeline_.OnOutputSent(n);
+    // 无法解析的请求已回答400，发送完毕后关闭
+    if (pipeline_.ShouldClose()) {
+      Close();
+      return;
     }
+    UpdateEvents();
   } else {
     // 写入错误
     if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -97,6 +103,37 @@ int HttpConnection::GetFd() const {
   return sockfd_;
 }
 
-void HttpConnection::SetRequestCallback(const RequestCallback& cb) {
-  request_callback_ = cb;
-}
\ No newline at end of file
+uint64_t HttpConnection::GetSerial() const {
+  return serial_;
+}
+
+void HttpConnection::OnAsyncComplete(HttpResponse* response) {
+  pipeline_.OnAsyncComplete(response);
+  UpdateEvents();
+}
+
+void HttpConnection::OnCoalescedResponse(
+    std::shared_ptr<const SharedBuffer> wire) {
+  pipeline_.OnCoalescedResponse(std::move(wire));
+  UpdateEvents();
+}
+
+RequestPipeline* HttpConnection::GetPipeline() {
+  return &pipeline_;
+}
+
+void HttpConnection::UpdateEvents() {
+  // 有数据待发送时关注可写；暂停期间不再读取新请求，由TCP窗口反压客户端
+  int events = 0;
+  if (!pipeline_.GetOutput().IsEmpty()) {
+    events |= EPOLLOUT;
+  }
+  if (pipeline_.CanProcessRequests()) {
+    events |= EPOLLIN;
+  }
+
+  if (events != events_) {
+    events_ = events;
+    server_->ModifyEvent(sockfd_, events);
+  }
+}
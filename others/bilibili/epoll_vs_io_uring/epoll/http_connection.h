@@ -2,24 +2,24 @@
 #ifndef HTTP_CONNECTION_H_
 #define HTTP_CONNECTION_H_
 
-#include <functional>
+#include <stdint.h>
 #include <memory>
-#include <string>
 
-#include "http_request.h"
-#include "http_response.h"
+#include "request_pipeline.h"
 
 // 前向声明
 class HttpServer;
 
 // HTTP连接类
+// 请求的解析和处理交给RequestPipeline，这里只负责套接字的读写和
+// epoll关注的事件。
 class HttpConnection {
  public:
   // 回调函数类型定义
-  using RequestCallback =
-      std::function<void(const HttpRequest&, HttpResponse*)>;
+  using RequestCallback = RequestPipeline::RequestCallback;
 
-  HttpConnection(int sockfd, HttpServer* server);
+  // serial是服务器分配的连接序号，异步请求完成时用来确认连接没有被替换
+  HttpConnection(int sockfd, uint64_t serial, HttpServer* server);
   ~HttpConnection();
 
   // 处理读事件
@@ -34,20 +34,29 @@ class HttpConnection {
   // 获取套接字描述符
   int GetFd() const;
 
-  // 设置请求回调函数
-  void SetRequestCallback(const RequestCallback& cb);
+  // 获取连接序号
+  uint64_t GetSerial() const;
+
+  // 异步请求完成，发送响应并继续处理后续请求
+  void OnAsyncComplete(HttpResponse* response);
+
+  // 合并等待的请求得到结果，wire为nullptr时计算被放弃，自行处理请求
+  void OnCoalescedResponse(std::shared_ptr<const SharedBuffer> wire);
+
+  // 获取请求处理流水线，用于设置各处理阶段
+  RequestPipeline* GetPipeline();
 
  private:
-  static const size_t kBufferSize = 4096;  // 缓冲区大小
-
-  int sockfd_;                        // 套接字描述符
-  HttpServer* server_;                // 所属的HTTP服务器
-  char read_buffer_[kBufferSize];     // 读缓冲区
-  size_t read_index_;                 // 读缓冲区中已读取的数据长度
-  std::string write_buffer_;          // 写缓冲区
-  size_t write_index_;                // 写缓冲区中已写入的数据长度
-  HttpRequest request_;               // HTTP请求
-  RequestCallback request_callback_;  // 请求回调函数
+  static const int kMaxWriteSegments = 16;  // 单次writev的最大段数
+
+  // 根据发送队列和流水线状态更新关注的事件
+  void UpdateEvents();
+
+  int sockfd_;                // 套接字描述符
+  uint64_t serial_;           // 连接序号
+  HttpServer* server_;        // 所属的HTTP服务器
+  int events_;                // 当前关注的epoll事件
+  RequestPipeline pipeline_;  // 请求处理流水线
 };
 
-#endif  // HTTP_CONNECTION_H_
\ No newline at end of file
+#endif  // HTTP_CONNECTION_H_
@@ -10,7 +10,19 @@
 #include <iostream>
 
 HttpServer::HttpServer(const std::string& ip, int port)
-    : ip_(ip), port_(port), listen_fd_(-1), epoll_fd_(-1), running_(false) {}
+    : ip_(ip),
+      port_(port),
+      listen_fd_(-1),
+      epoll_fd_(-1),
+      running_(false),
+      next_serial_(0),
+      loop_time_ns_(0),
+      compressor_(nullptr),
+      static_cache_(nullptr),
+      admission_(nullptr),
+      rate_limiter_(nullptr),
+      response_cache_(nullptr),
+      coalescer_(nullptr) {}
 
 HttpServer::~HttpServer() {
   Stop();
@@ -64,8 +76,17 @@ bool HttpServer::Start() {
     return false;
   }
 
-  // 添加监听套接字到epoll
+  // 创建完成队列，工作线程通过它的eventfd唤醒事件循环
+  if (!completions_.Init()) {
+    std::cerr << "创建eventfd失败: " << strerror(errno) << std::endl;
+    close(epoll_fd_);
+    close(listen_fd_);
+    return false;
+  }
+
+  // 添加监听套接字和完成队列到epoll
   AddEvent(listen_fd_, EPOLLIN);
+  AddEvent(completions_.GetEventFd(), EPOLLIN);
 
   running_ = true;
   std::cout << "HTTP服务器启动成功，监听 " << ip_ << ":" << port_ << std::endl;
@@ -76,8 +97,10 @@ bool HttpServer::Start() {
 void HttpServer::Stop() {
   running_ = false;
 
-  // 关闭所有连接
-  connections_.clear();
+  // 关闭所有连接，先从表中取出，析构时放弃的缓存计算不会再找到其他连接
+  std::map<int, std::unique_ptr<HttpConnection>> connections;
+  connections.swap(connections_);
+  connections.clear();
 
   // 关闭epoll实例
   if (epoll_fd_ >= 0) {
@@ -96,7 +119,9 @@ void HttpServer::Stop() {
 
 void HttpServer::EventLoop() {
   while (running_) {
-    int num_events = epoll_wait(epoll_fd_, events_, kMaxEvents, -1);
+    // 有合并等待的请求时，最迟在最早的等待超时时醒来
+    int timeout = coalescer_ ? coalescer_->GetWaitTimeout() : -1;
+    int num_events = epoll_wait(epoll_fd_, events_, kMaxEvents, timeout);
 
     if (num_events < 0) {
       if (errno == EINTR) {
@@ -106,6 +131,11 @@ void HttpServer::EventLoop() {
       break;
     }
 
+    // 本轮就绪的请求都从现在开始排队，处理越慢，排在后面的请求等得越久
+    if (admission_) {
+      loop_time_ns_ = AdmissionController::NowNanos();
+    }
+
     for (int i = 0; i < num_events; ++i) {
       int fd = events_[i].data.fd;
 
@@ -115,6 +145,12 @@ void HttpServer::EventLoop() {
         continue;
       }
 
+      // 处理完成的异步请求
+      if (fd == completions_.GetEventFd()) {
+        HandleCompletions();
+        continue;
+      }
+
       // 处理错误事件
       if (events_[i].events & (EPOLLERR | EPOLLHUP)) {
         RemoveConnection(fd);
@@ -131,6 +167,11 @@ void HttpServer::EventLoop() {
         HandleWrite(fd);
       }
     }
+
+    // 本轮完成的计算已交给等待者，剩下超时的回答504
+    if (coalescer_) {
+      coalescer_->ExpireWaiters();
+    }
   }
 }
 
@@ -153,10 +194,21 @@ void HttpServer::RemoveEvent(int fd) {
 }
 
 void HttpServer::RemoveConnection(int fd) {
-  if (connections_.find(fd) != connections_.end()) {
+  auto it = connections_.find(fd);
+  if (it != connections_.end()) {
     RemoveEvent(fd);
-    connections_.erase(fd);
+    // 先从表中取出再析构，析构时可能通知其他连接，表要保持一致
+    std::unique_ptr<HttpConnection> conn = std::move(it->second);
+    connections_.erase(it);
+  }
+}
+
+HttpConnection* HttpServer::FindConnection(int fd, uint64_t serial) {
+  auto it = connections_.find(fd);
+  if (it != connections_.end() && it->second->GetSerial() == serial) {
+    return it->second.get();
   }
+  return nullptr;
 }
 
 void HttpServer::HandleNewConnection() {
@@ -170,6 +222,16 @@ void HttpServer::HandleNewConnection() {
     return;
   }
 
+  // 连接数达到上限，回答503后立即关闭，不为它分配连接对象
+  if (admission_ && !admission_->AcceptConnection(connections_.size())) {
+    // 新连接的发送缓冲区是空的，非阻塞发送一次即可，发不完也不等待
+    const PreSerializedResponse* reject = admission_->GetRejectResponse();
+    send(client_fd, reject->wire.data(), reject->wire.size(),
+         MSG_NOSIGNAL | MSG_DONTWAIT);
+    close(client_fd);
+    return;
+  }
+
   // 设置非阻塞模式
   int flags = fcntl(client_fd, F_GETFL, 0);
   fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
@@ -178,8 +240,16 @@ void HttpServer::HandleNewConnection() {
   AddEvent(client_fd, EPOLLIN);
 
   // 创建连接对象
-  auto conn = std::make_unique<HttpConnection>(client_fd, this);
-  conn->SetRequestCallback(request_callback_);
+  auto conn =
+      std::make_unique<HttpConnection>(client_fd, next_serial_++, this);
+  conn->GetPipeline()->SetRequestCallback(request_callback_);
+  conn->GetPipeline()->SetResponseCompressor(compressor_);
+  conn->GetPipeline()->SetStaticResponseCache(static_cache_);
+  conn->GetPipeline()->SetAdmissionController(admission_);
+  conn->GetPipeline()->SetRateLimiter(rate_limiter_);
+  conn->GetPipeline()->SetResponseCache(response_cache_);
+  conn->GetPipeline()->SetRequestCoalescer(coalescer_);
+  conn->GetPipeline()->SetRemoteIp(ntohl(client_addr.sin_addr.s_addr));
   connections_[client_fd] = std::move(conn);
 
   char client_ip[INET_ADDRSTRLEN];
@@ -202,11 +272,83 @@ void HttpServer::HandleWrite(int fd) {
   }
 }
 
+void HttpServer::HandleCompletions() {
+  completions_.Drain([this](std::unique_ptr<AsyncCompletion> completion) {
+    // 连接可能已经关闭，描述符也可能已被新连接复用，此时丢弃响应
+    HttpConnection* conn = FindConnection(completion->fd, completion->serial);
+    if (conn) {
+      conn->OnAsyncComplete(&completion->response);
+    }
+  });
+}
+
 void HttpServer::SetRequestCallback(const RequestCallback& cb) {
   request_callback_ = cb;
 
   // 为现有连接设置回调
   for (auto& conn : connections_) {
-    conn.second->SetRequestCallback(cb);
+    conn.second->GetPipeline()->SetRequestCallback(cb);
   }
-}
\ No newline at end of file
+}
+
+void HttpServer::SetResponseCompressor(ResponseCompressor* compressor) {
+  compressor_ = compressor;
+
+  // 为现有连接设置压缩器
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetResponseCompressor(compressor);
+  }
+}
+
+void HttpServer::SetStaticResponseCache(StaticResponseCache* cache) {
+  static_cache_ = cache;
+
+  // 为现有连接设置静态响应缓存
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetStaticResponseCache(cache);
+  }
+}
+
+void HttpServer::SetAdmissionController(AdmissionController* admission) {
+  admission_ = admission;
+
+  // 为现有连接设置准入控制器
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetAdmissionController(admission);
+  }
+}
+
+void HttpServer::SetRateLimiter(RateLimiter* limiter) {
+  rate_limiter_ = limiter;
+
+  // 为现有连接设置请求限速
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetRateLimiter(limiter);
+  }
+}
+
+void HttpServer::SetResponseCache(ResponseCache* cache) {
+  response_cache_ = cache;
+
+  // 为现有连接设置响应缓存
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetResponseCache(cache);
+  }
+}
+
+void HttpServer::SetRequestCoalescer(RequestCoalescer* coalescer) {
+  coalescer_ = coalescer;
+
+  // 为现有连接设置请求合并
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetRequestCoalescer(coalescer);
+  }
+}
+
+CompletionQueue* HttpServer::GetCompletionQueue() {
+  return &completions_;
+}
+
+uint64_t HttpServer::GetLoopTime() const {
+  return loop_time_ns_;
+}
@@ -2,12 +2,15 @@
 #ifndef HTTP_SERVER_H_
 #define HTTP_SERVER_H_
 
+#include <stdint.h>
 #include <sys/epoll.h>
 #include <functional>
 #include <map>
 #include <memory>
 #include <string>
 
+#include "admission_controller.h"
+#include "completion_queue.h"
 #include "http_connection.h"
 
 // HTTP服务器类
@@ -40,9 +43,36 @@ class HttpServer {
   // 移除连接
   void RemoveConnection(int fd);
 
+  // 查找描述符对应的连接，连接已关闭或描述符已被新连接复用时返回nullptr
+  HttpConnection* FindConnection(int fd, uint64_t serial);
+
   // 设置请求回调函数
   void SetRequestCallback(const RequestCallback& cb);
 
+  // 设置响应压缩器，为nullptr时不压缩
+  void SetResponseCompressor(ResponseCompressor* compressor);
+
+  // 设置静态响应缓存，为nullptr时所有请求都交给请求回调函数
+  void SetStaticResponseCache(StaticResponseCache* cache);
+
+  // 设置准入控制器，为nullptr时不限制连接和请求
+  void SetAdmissionController(AdmissionController* admission);
+
+  // 设置请求限速，为nullptr时不限速
+  void SetRateLimiter(RateLimiter* limiter);
+
+  // 设置响应缓存，为nullptr时不缓存动态响应
+  void SetResponseCache(ResponseCache* cache);
+
+  // 设置请求合并，为nullptr时不合并相同请求
+  void SetRequestCoalescer(RequestCoalescer* coalescer);
+
+  // 获取异步请求的完成队列
+  CompletionQueue* GetCompletionQueue();
+
+  // 本轮事件循环醒来的时间，作为请求开始排队的时间，只在设置准入控制器时更新
+  uint64_t GetLoopTime() const;
+
  private:
   static const int kMaxEvents = 1024;  // 最大事件数
 
@@ -55,14 +85,26 @@ class HttpServer {
   // 处理写事件
   void HandleWrite(int fd);
 
+  // 把完成的异步请求交还给对应的连接
+  void HandleCompletions();
+
   std::string ip_;                         // 服务器IP地址
   int port_;                               // 服务器端口
   int listen_fd_;                          // 监听套接字
   int epoll_fd_;                           // epoll文件描述符
   bool running_;                           // 服务器运行状态
   struct epoll_event events_[kMaxEvents];  // epoll事件数组
+  uint64_t next_serial_;                   // 下一个连接的序号
+  CompletionQueue completions_;            // 异步请求的完成队列
+  uint64_t loop_time_ns_;                  // 本轮事件循环醒来的时间
   std::map<int, std::unique_ptr<HttpConnection>> connections_;  // 连接映射表
   RequestCallback request_callback_;                            // 请求回调函数
+  ResponseCompressor* compressor_;                              // 响应压缩器
+  StaticResponseCache* static_cache_;                           // 静态响应缓存
+  AdmissionController* admission_;                              // 准入控制器
+  RateLimiter* rate_limiter_;                                   // 请求限速
+  ResponseCache* response_cache_;                               // 响应缓存
+  RequestCoalescer* coalescer_;                                 // 请求合并
 };
 
 #endif  // HTTP_SERVER_H_
\ No newline at end of file
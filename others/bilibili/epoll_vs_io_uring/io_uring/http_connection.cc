@@ -1,16 +1,34 @@
 // HTTP连接类实现
 #include "http_connection.h"
 
-#include <errno.h>
 #include <string.h>
-#include <sys/socket.h>
-#include <sys/types.h>
 #include <unistd.h>
 
 #include "http_server.h"
 
-HttpConnection::HttpConnection(int sockfd, HttpServer* server)
-    : sockfd_(sockfd), server_(server), read_index_(0), write_index_(0) {}
+namespace {
+
+// 合并等待的结果经服务器按描述符和序号找回连接，连接已关闭或描述符
+// 被复用时丢弃结果
+RequestCoalescer::Waiter MakeCoalescedHandler(HttpServer* server, int fd,
+                                              uint64_t serial) {
+  return [server, fd, serial](std::shared_ptr<const SharedBuffer> wire) {
+    if (HttpConnection* conn = server->FindConnection(fd, serial)) {
+      conn->OnCoalescedResponse(std::move(wire));
+    }
+  };
+}
+
+}  // namespace
+
+HttpConnection::HttpConnection(int sockfd, uint64_t serial, HttpServer* server)
+    : sockfd_(sockfd),
+      serial_(serial),
+      server_(server),
+      read_pending_(false),
+      write_pending_(false),
+      pipeline_(server->GetCompletionQueue(), sockfd, serial,
+                MakeCoalescedHandler(server, sockfd, serial)) {}
 
 HttpConnection::~HttpConnection() {
   if (sockfd_ >= 0) {
@@ -19,60 +37,42 @@ HttpConnection::~HttpConnection() {
   }
 }
 
+void HttpConnection::Start() {
+  SubmitPending();
+}
+
 void HttpConnection::OnReadData(const char* data, int bytes_read) {
-  // 将数据复制到读缓冲区
-  if (bytes_read > 0 && read_index_ + bytes_read <= kBufferSize) {
-    memcpy(read_buffer_ + read_index_, data, bytes_read);
-    read_index_ += bytes_read;
-
-    // 解析HTTP请求
-    if (request_.Parse(read_buffer_, read_index_)) {
-      // 请求解析完成，生成响应
-      HttpResponse response;
-
-      // 调用回调函数处理请求
-      if (request_callback_) {
-        request_callback_(request_, &response);
-      } else {
-        // 默认响应
-        response.SetStatusCode(HttpStatusCode::k404NotFound);
-        response.SetBody("<html><body><h1>404 Not Found</h1></body></html>");
-        response.SetHeader("Content-Type", "text/html");
-      }
-
-      // 生成响应字符串
-      write_buffer_ = response.ToString();
-      write_index_ = 0;
-
-      // 提交写请求
-      server_->SubmitWrite(sockfd_, write_buffer_.c_str(),
-                           write_buffer_.size());
-
-      // 重置请求，准备处理下一个请求
-      request_.Reset();
-      read_index_ = 0;
-    }
+  read_pending_ = false;
+
+  // 读请求最多读取读缓冲区的剩余空间，这里只做防御性检查
+  if (bytes_read <= 0 ||
+      static_cast<size_t>(bytes_read) > pipeline_.GetInputSpaceSize()) {
+    Close();
+    return;
   }
+
+  // 将数据复制到读缓冲区，处理已完整到达的请求，
+  // 从本轮事件循环醒来时开始排队
+  memcpy(pipeline_.GetInputSpace(), data, bytes_read);
+  pipeline_.OnInput(bytes_read, server_->GetLoopTime());
+
+  // 读缓冲区已满仍不是完整请求，请求头过大，无法继续解析
+  if (pipeline_.IsInputOverflowed()) {
+    Close();
+    return;
+  }
+  SubmitPending();
 }
 
 void HttpConnection::OnWriteComplete(int bytes_written) {
-  if (bytes_written > 0) {
-    write_index_ += bytes_written;
-
-    // 检查是否发送完毕
-    if (write_index_ < write_buffer_.size()) {
-      // 继续发送剩余数据
-      server_->SubmitWrite(sockfd_, write_buffer_.c_str() + write_index_,
-                           write_buffer_.size() - write_index_);
-    } else {
-      // 发送完毕，重置写缓冲区
-      write_buffer_.clear();
-      write_index_ = 0;
-
-      // 提交新的读请求
-      server_->SubmitRead(sockfd_);
-    }
+  write_pending_ = false;
+  pipeline_.OnOutputSent(bytes_written);
+  // 无法解析的请求已回答400，发送完毕后关闭，未完成的读请求按序号丢弃
+  if (pipeline_.ShouldClose()) {
+    Close();
+    return;
   }
+  SubmitPending();
 }
 
 void HttpConnection::Close() {
@@ -85,14 +85,37 @@ int HttpConnection::GetFd() const {
   return sockfd_;
 }
 
-void HttpConnection::SetRequestCallback(const RequestCallback& cb) {
-  request_callback_ = cb;
+uint64_t HttpConnection::GetSerial() const {
+  return serial_;
+}
+
+void HttpConnection::OnAsyncComplete(HttpResponse* response) {
+  pipeline_.OnAsyncComplete(response);
+  SubmitPending();
+}
+
+void HttpConnection::OnCoalescedResponse(
+    std::shared_ptr<const SharedBuffer> wire) {
+  pipeline_.OnCoalescedResponse(std::move(wire));
+  SubmitPending();
 }
 
-const char* HttpConnection::GetWriteBuffer() const {
-  return write_buffer_.c_str();
+RequestPipeline* HttpConnection::GetPipeline() {
+  return &pipeline_;
 }
 
-size_t HttpConnection::GetWriteBufferSize() const {
-  return write_buffer_.size();
-}
\ No newline at end of file
+void HttpConnection::SubmitPending() {
+  // 有数据待发送时提交写请求
+  const OutputQueue& output = pipeline_.GetOutput();
+  if (!write_pending_ && !output.IsEmpty()) {
+    write_pending_ = true;
+    server_->SubmitWrite(sockfd_, serial_, output);
+  }
+
+  // 暂停期间不再读取新请求，由TCP窗口反压客户端
+  size_t space = pipeline_.GetInputSpaceSize();
+  if (!read_pending_ && pipeline_.CanProcessRequests() && space > 0) {
+    read_pending_ = true;
+    server_->SubmitRead(sockfd_, serial_, space);
+  }
+}
@@ -2,26 +2,29 @@
 #ifndef HTTP_CONNECTION_H_
 #define HTTP_CONNECTION_H_
 
-#include <functional>
+#include <stdint.h>
 #include <memory>
-#include <string>
 
-#include "http_request.h"
-#include "http_response.h"
+#include "request_pipeline.h"
 
 // 前向声明
 class HttpServer;
 
 // HTTP连接类
+// 请求的解析和处理交给RequestPipeline，这里只负责按需提交io_uring的
+// 读请求和写请求。
 class HttpConnection {
  public:
   // 回调函数类型定义
-  using RequestCallback =
-      std::function<void(const HttpRequest&, HttpResponse*)>;
+  using RequestCallback = RequestPipeline::RequestCallback;
 
-  HttpConnection(int sockfd, HttpServer* server);
+  // serial是服务器分配的连接序号，异步请求完成时用来确认连接没有被替换
+  HttpConnection(int sockfd, uint64_t serial, HttpServer* server);
   ~HttpConnection();
 
+  // 提交第一个读请求，开始处理连接
+  void Start();
+
   // 处理io_uring读取的数据
   void OnReadData(const char* data, int bytes_read);
 
@@ -34,26 +37,28 @@ class HttpConnection {
   // 获取套接字描述符
   int GetFd() const;
 
-  // 设置请求回调函数
-  void SetRequestCallback(const RequestCallback& cb);
+  // 获取连接序号
+  uint64_t GetSerial() const;
+
+  // 异步请求完成，发送响应并继续处理后续请求
+  void OnAsyncComplete(HttpResponse* response);
 
-  // 获取写缓冲区数据
-  const char* GetWriteBuffer() const;
-  
-  // 获取写缓冲区大小
-  size_t GetWriteBufferSize() const;
+  // 合并等待的请求得到结果，wire为nullptr时计算被放弃，自行处理请求
+  void OnCoalescedResponse(std::shared_ptr<const SharedBuffer> wire);
+
+  // 获取请求处理流水线，用于设置各处理阶段
+  RequestPipeline* GetPipeline();
 
  private:
-  static const size_t kBufferSize = 4096;  // 缓冲区大小
-
-  int sockfd_;                        // 套接字描述符
-  HttpServer* server_;                // 所属的HTTP服务器
-  char read_buffer_[kBufferSize];     // 读缓冲区
-  size_t read_index_;                 // 读缓冲区中已读取的数据长度
-  std::string write_buffer_;          // 写缓冲区
-  size_t write_index_;                // 写缓冲区中已写入的数据长度
-  HttpRequest request_;               // HTTP请求
-  RequestCallback request_callback_;  // 请求回调函数
+  // 按需提交读请求和写请求，每种请求同时最多一个
+  void SubmitPending();
+
+  int sockfd_;                // 套接字描述符
+  uint64_t serial_;           // 连接序号
+  HttpServer* server_;        // 所属的HTTP服务器
+  bool read_pending_;         // 是否有未完成的读请求
+  bool write_pending_;        // 是否有未完成的写请求
+  RequestPipeline pipeline_;  // 请求处理流水线
 };
 
-#endif  // HTTP_CONNECTION_H_
\ No newline at end of file
+#endif  // HTTP_CONNECTION_H_
@@ -2,11 +2,13 @@
 #include "http_server.h"
 
 #include <arpa/inet.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <liburing.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <iostream>
 
@@ -14,21 +16,42 @@
 enum {
   ACCEPT,
   READ,
-  WRITE
+  WRITE,
+  COMPLETION
 };
 
+// 单个写请求的最大段数
+const int kMaxWriteSegments = 16;
+
 // 请求结构体
 struct io_request {
   int type;
   int fd;
+  // 读写请求所属连接的序号，连接关闭后描述符可能被新连接复用，
+  // 完成时序号不符的请求属于已关闭的连接
+  uint64_t serial;
   char* buf;
   size_t len;
   struct sockaddr_in client_addr;
   socklen_t client_len;
+  // 写请求的各段数据，以及写完成前持有的共享缓冲区
+  struct iovec iov[kMaxWriteSegments];
+  std::shared_ptr<const SharedBuffer> holds[kMaxWriteSegments];
 };
 
 HttpServer::HttpServer(const std::string& ip, int port)
-    : ip_(ip), port_(port), listen_fd_(-1), running_(false) {}
+    : ip_(ip),
+      port_(port),
+      listen_fd_(-1),
+      running_(false),
+      next_serial_(0),
+      loop_time_ns_(0),
+      compressor_(nullptr),
+      static_cache_(nullptr),
+      admission_(nullptr),
+      rate_limiter_(nullptr),
+      response_cache_(nullptr),
+      coalescer_(nullptr) {}
 
 HttpServer::~HttpServer() {
   Stop();
@@ -84,11 +107,20 @@ bool HttpServer::Start() {
     return false;
   }
 
+  // 创建完成队列，工作线程通过它的eventfd唤醒事件循环
+  if (!completions_.Init()) {
+    std::cerr << "创建eventfd失败: " << strerror(errno) << std::endl;
+    io_uring_queue_exit(&ring_);
+    close(listen_fd_);
+    return false;
+  }
+
   running_ = true;
   std::cout << "HTTP服务器启动成功，监听 " << ip_ << ":" << port_ << std::endl;
 
-  // 提交第一个接受连接请求
+  // 提交第一个接受连接请求和完成队列的读请求
   SubmitAccept();
+  SubmitCompletionRead();
 
   return true;
 }
@@ -96,8 +128,10 @@ bool HttpServer::Start() {
 void HttpServer::Stop() {
   running_ = false;
 
-  // 关闭所有连接
-  connections_.clear();
+  // 关闭所有连接，先从表中取出，析构时放弃的缓存计算不会再找到其他连接
+  std::map<int, std::unique_ptr<HttpConnection>> connections;
+  connections.swap(connections_);
+  connections.clear();
 
   // 关闭io_uring实例
   io_uring_queue_exit(&ring_);
@@ -124,12 +158,13 @@ void HttpServer::SubmitAccept() {
   io_uring_submit(&ring_);
 }
 
-void HttpServer::SubmitRead(int fd) {
+void HttpServer::SubmitRead(int fd, uint64_t serial, size_t len) {
   struct io_request* req = new io_request;
   req->type = READ;
   req->fd = fd;
-  req->buf = new char[kReadSize];
-  req->len = kReadSize;
+  req->serial = serial;
+  req->buf = new char[len];
+  req->len = len;
 
   struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
   io_uring_prep_read(sqe, fd, req->buf, req->len, 0);
@@ -137,16 +172,55 @@ void HttpServer::SubmitRead(int fd) {
   io_uring_submit(&ring_);
 }
 
-void HttpServer::SubmitWrite(int fd, const void* buf, size_t len) {
+void HttpServer::SubmitWrite(int fd, uint64_t serial,
+                             const OutputQueue& output) {
+  OutputSegment segments[kMaxWriteSegments];
+  int count = output.GetSegments(segments, kMaxWriteSegments);
+
   struct io_request* req = new io_request;
   req->type = WRITE;
   req->fd = fd;
-  req->buf = new char[len];
-  memcpy(req->buf, buf, len);
-  req->len = len;
+  req->serial = serial;
+
+  // 写请求完成前发送队列仍可能追加数据，普通段复制到写请求自己的缓冲区
+  size_t copy_size = 0;
+  for (int i = 0; i < count; ++i) {
+    if (!segments[i].shared) {
+      copy_size += segments[i].size;
+    }
+  }
+  req->buf = new char[copy_size];
+  req->len = copy_size;
+
+  // 共享缓冲区不复制，写请求持有引用直到完成
+  char* copy = req->buf;
+  for (int i = 0; i < count; ++i) {
+    if (segments[i].shared) {
+      req->iov[i].iov_base = const_cast<char*>(segments[i].data);
+      req->holds[i] = *segments[i].shared;
+    } else {
+      memcpy(copy, segments[i].data, segments[i].size);
+      req->iov[i].iov_base = copy;
+      copy += segments[i].size;
+    }
+    req->iov[i].iov_len = segments[i].size;
+  }
+
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+  io_uring_prep_writev(sqe, fd, req->iov, count, 0);
+  io_uring_sqe_set_data(sqe, req);
+  io_uring_submit(&ring_);
+}
+
+void HttpServer::SubmitCompletionRead() {
+  struct io_request* req = new io_request;
+  req->type = COMPLETION;
+  req->fd = completions_.GetEventFd();
+  req->len = sizeof(uint64_t);
+  req->buf = new char[req->len];
 
   struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
-  io_uring_prep_write(sqe, fd, req->buf, len, 0);
+  io_uring_prep_read(sqe, req->fd, req->buf, req->len, 0);
   io_uring_sqe_set_data(sqe, req);
   io_uring_submit(&ring_);
 }
@@ -154,8 +228,27 @@ void HttpServer::SubmitWrite(int fd, const void* buf, size_t len) {
 void HttpServer::EventLoop() {
   while (running_) {
     struct io_uring_cqe* cqe;
-    int ret = io_uring_wait_cqe(&ring_, &cqe);
-    
+    // 完成队列为空时才是新一轮醒来，积压的完成事件属于同一轮
+    bool idle = io_uring_cq_ready(&ring_) == 0;
+
+    // 有合并等待的请求时，最迟在最早的等待超时时醒来
+    int timeout = coalescer_ ? coalescer_->GetWaitTimeout() : -1;
+    int ret;
+    if (timeout >= 0) {
+      struct __kernel_timespec ts;
+      ts.tv_sec = timeout / 1000;
+      ts.tv_nsec = static_cast<long long>(timeout % 1000) * 1000000;
+      ret = io_uring_wait_cqe_timeout(&ring_, &cqe, &ts);
+    } else {
+      ret = io_uring_wait_cqe(&ring_, &cqe);
+    }
+
+    // 等待超时，没有完成事件，只需回答超时的合并请求
+    if (ret == -ETIME) {
+      coalescer_->ExpireWaiters();
+      continue;
+    }
+
     if (ret < 0) {
       if (errno == EINTR) {
         continue;  // 被信号中断，继续循环
@@ -164,6 +257,11 @@ void HttpServer::EventLoop() {
       break;
     }
 
+    // 本轮的完成事件都从醒来时开始排队，处理越慢，排在后面的请求等得越久
+    if (idle && admission_) {
+      loop_time_ns_ = AdmissionController::NowNanos();
+    }
+
     struct io_request* req = (struct io_request*)io_uring_cqe_get_data(cqe);
     int res = cqe->res;
     
@@ -175,7 +273,10 @@ void HttpServer::EventLoop() {
         SubmitAccept();
       } else if (req->type == READ || req->type == WRITE) {
         std::cerr << "I/O操作失败: " << strerror(-res) << " fd=" << req->fd << std::endl;
-        RemoveConnection(req->fd);
+        HandleIoError(req->fd, req->serial);
+      } else if (req->type == COMPLETION) {
+        std::cerr << "读取eventfd失败: " << strerror(-res) << std::endl;
+        SubmitCompletionRead();
       }
     } else {
       // 处理成功的I/O操作
@@ -190,44 +291,74 @@ void HttpServer::EventLoop() {
         case READ: {
           if (res == 0) {
             // 连接关闭
-            RemoveConnection(req->fd);
+            HandleIoError(req->fd, req->serial);
           } else {
             // 处理读取的数据
-            HandleRead(req->fd, req->buf, res);
+            HandleRead(req->fd, req->serial, req->buf, res);
           }
           break;
         }
         case WRITE: {
           // 处理写完成
-          HandleWrite(req->fd, res);
+          HandleWrite(req->fd, req->serial, res);
+          break;
+        }
+        case COMPLETION: {
+          // eventfd已被读空，取出完成的请求后继续等待
+          HandleCompletions();
+          SubmitCompletionRead();
           break;
         }
       }
     }
 
     // 释放请求资源
-    if (req->type == READ || req->type == WRITE) {
+    if (req->type != ACCEPT) {
       delete[] req->buf;
     }
     delete req;
 
     // 标记完成队列条目为已处理
     io_uring_cqe_seen(&ring_, cqe);
+
+    // 已完成的计算交给了等待者，剩下超时的回答504
+    if (coalescer_) {
+      coalescer_->ExpireWaiters();
+    }
   }
 }
 
 void HttpServer::HandleNewConnection(int client_fd, struct sockaddr_in* client_addr) {
+  // 连接数达到上限，回答503后立即关闭，不为它分配连接对象
+  if (admission_ && !admission_->AcceptConnection(connections_.size())) {
+    // 新连接的发送缓冲区是空的，非阻塞发送一次即可，发不完也不等待
+    const PreSerializedResponse* reject = admission_->GetRejectResponse();
+    send(client_fd, reject->wire.data(), reject->wire.size(),
+         MSG_NOSIGNAL | MSG_DONTWAIT);
+    close(client_fd);
+    return;
+  }
+
   // 设置非阻塞模式
   int flags = fcntl(client_fd, F_GETFL, 0);
   fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
 
   // 创建连接对象
-  auto conn = std::make_unique<HttpConnection>(client_fd, this);
-  conn->SetRequestCallback(request_callback_);
+  auto conn =
+      std::make_unique<HttpConnection>(client_fd, next_serial_++, this);
+  conn->GetPipeline()->SetRequestCallback(request_callback_);
+  conn->GetPipeline()->SetResponseCompressor(compressor_);
+  conn->GetPipeline()->SetStaticResponseCache(static_cache_);
+  conn->GetPipeline()->SetAdmissionController(admission_);
+  conn->GetPipeline()->SetRateLimiter(rate_limiter_);
+  conn->GetPipeline()->SetResponseCache(response_cache_);
+  conn->GetPipeline()->SetRequestCoalescer(coalescer_);
+  conn->GetPipeline()->SetRemoteIp(ntohl(client_addr->sin_addr.s_addr));
+  HttpConnection* raw = conn.get();
   connections_[client_fd] = std::move(conn);
 
-  // 提交读请求
-  SubmitRead(client_fd);
+  // 提交第一个读请求
+  raw->Start();
 
   char client_ip[INET_ADDRSTRLEN];
   inet_ntop(AF_INET, &client_addr->sin_addr, client_ip, sizeof(client_ip));
@@ -235,30 +366,58 @@ void HttpServer::HandleNewConnection(int client_fd, struct sockaddr_in* client_a
             << std::endl;
 }
 
-void HttpServer::HandleRead(int fd, const char* data, int bytes_read) {
-  auto it = connections_.find(fd);
-  if (it != connections_.end()) {
-    // 需要修改HttpConnection类以适应新的数据传递方式
-    it->second->OnReadData(data, bytes_read);
-    
-    // 继续提交读请求
-    SubmitRead(fd);
+void HttpServer::HandleRead(int fd, uint64_t serial, const char* data,
+                            int bytes_read) {
+  // 描述符已被新连接复用时，读到的数据属于已关闭的连接，丢弃
+  if (HttpConnection* conn = FindConnection(fd, serial)) {
+    // 连接自己决定何时提交下一个读请求
+    conn->OnReadData(data, bytes_read);
   }
 }
 
-void HttpServer::HandleWrite(int fd, int bytes_written) {
+void HttpServer::HandleWrite(int fd, uint64_t serial, int bytes_written) {
+  // 已关闭连接的写完成不能算到复用同一描述符的新连接上
+  if (HttpConnection* conn = FindConnection(fd, serial)) {
+    conn->OnWriteComplete(bytes_written);
+  }
+}
+
+void HttpServer::HandleIoError(int fd, uint64_t serial) {
+  // 只移除提交请求的连接，不误关复用同一描述符的新连接
+  if (FindConnection(fd, serial)) {
+    RemoveConnection(fd);
+  }
+}
+
+void HttpServer::HandleCompletions() {
+  completions_.Drain(
+      [this](std::unique_ptr<AsyncCompletion> completion) {
+        // 连接可能已经关闭，描述符也可能已被新连接复用，此时丢弃响应
+        HttpConnection* conn =
+            FindConnection(completion->fd, completion->serial);
+        if (conn) {
+          conn->OnAsyncComplete(&completion->response);
+        }
+      },
+      true);
+}
+
+void HttpServer::RemoveConnection(int fd) {
   auto it = connections_.find(fd);
   if (it != connections_.end()) {
-    // 需要修改HttpConnection类以适应新的数据传递方式
-    it->second->OnWriteComplete(bytes_written);
+    // 先从表中取出再析构，析构时可能通知其他连接，表要保持一致；
+    // 描述符由连接的析构函数关闭
+    std::unique_ptr<HttpConnection> conn = std::move(it->second);
+    connections_.erase(it);
   }
 }
 
-void HttpServer::RemoveConnection(int fd) {
-  if (connections_.find(fd) != connections_.end()) {
-    connections_.erase(fd);
-    close(fd);
+HttpConnection* HttpServer::FindConnection(int fd, uint64_t serial) {
+  auto it = connections_.find(fd);
+  if (it != connections_.end() && it->second->GetSerial() == serial) {
+    return it->second.get();
   }
+  return nullptr;
 }
 
 void HttpServer::SetRequestCallback(const RequestCallback& cb) {
@@ -266,6 +425,68 @@ void HttpServer::SetRequestCallback(const RequestCallback& cb) {
 
   // 为现有连接设置回调
   for (auto& conn : connections_) {
-    conn.second->SetRequestCallback(cb);
+    conn.second->GetPipeline()->SetRequestCallback(cb);
+  }
+}
+
+void HttpServer::SetResponseCompressor(ResponseCompressor* compressor) {
+  compressor_ = compressor;
+
+  // 为现有连接设置压缩器
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetResponseCompressor(compressor);
   }
-}
\ No newline at end of file
+}
+
+void HttpServer::SetStaticResponseCache(StaticResponseCache* cache) {
+  static_cache_ = cache;
+
+  // 为现有连接设置静态响应缓存
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetStaticResponseCache(cache);
+  }
+}
+
+void HttpServer::SetAdmissionController(AdmissionController* admission) {
+  admission_ = admission;
+
+  // 为现有连接设置准入控制器
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetAdmissionController(admission);
+  }
+}
+
+void HttpServer::SetRateLimiter(RateLimiter* limiter) {
+  rate_limiter_ = limiter;
+
+  // 为现有连接设置请求限速
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetRateLimiter(limiter);
+  }
+}
+
+void HttpServer::SetResponseCache(ResponseCache* cache) {
+  response_cache_ = cache;
+
+  // 为现有连接设置响应缓存
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetResponseCache(cache);
+  }
+}
+
+void HttpServer::SetRequestCoalescer(RequestCoalescer* coalescer) {
+  coalescer_ = coalescer;
+
+  // 为现有连接设置请求合并
+  for (auto& conn : connections_) {
+    conn.second->GetPipeline()->SetRequestCoalescer(coalescer);
+  }
+}
+
+CompletionQueue* HttpServer::GetCompletionQueue() {
+  return &completions_;
+}
+
+uint64_t HttpServer::GetLoopTime() const {
+  return loop_time_ns_;
+}
@@ -3,11 +3,14 @@
 #define HTTP_SERVER_H_
 
 #include <liburing.h>
+#include <stdint.h>
 #include <functional>
 #include <map>
 #include <memory>
 #include <string>
 
+#include "admission_controller.h"
+#include "completion_queue.h"
 #include "http_connection.h"
 
 // HTTP服务器类
@@ -31,18 +34,46 @@ class HttpServer {
   // 提交接受连接请求
   void SubmitAccept();
 
-  // 提交读请求
-  void SubmitRead(int fd);
+  // 提交读请求，最多读取len字节；serial为连接序号，完成时据此找回连接
+  void SubmitRead(int fd, uint64_t serial, size_t len = kReadSize);
 
-  // 提交写请求
-  void SubmitWrite(int fd, const void* buf, size_t len);
+  // 提交写请求，发送队列队首的数据段中，普通数据会被复制；
+  // 共享缓冲区不复制，写请求持有其引用直到完成
+  void SubmitWrite(int fd, uint64_t serial, const OutputQueue& output);
 
   // 移除连接
   void RemoveConnection(int fd);
 
+  // 查找描述符对应的连接，连接已关闭或描述符已被新连接复用时返回nullptr
+  HttpConnection* FindConnection(int fd, uint64_t serial);
+
   // 设置请求回调函数
   void SetRequestCallback(const RequestCallback& cb);
 
+  // 设置响应压缩器，为nullptr时不压缩
+  void SetResponseCompressor(ResponseCompressor* compressor);
+
+  // 设置静态响应缓存，为nullptr时所有请求都交给请求回调函数
+  void SetStaticResponseCache(StaticResponseCache* cache);
+
+  // 设置准入控制器，为nullptr时不限制连接和请求
+  void SetAdmissionController(AdmissionController* admission);
+
+  // 设置请求限速，为nullptr时不限速
+  void SetRateLimiter(RateLimiter* limiter);
+
+  // 设置响应缓存，为nullptr时不缓存动态响应
+  void SetResponseCache(ResponseCache* cache);
+
+  // 设置请求合并，为nullptr时不合并相同请求
+  void SetRequestCoalescer(RequestCoalescer* coalescer);
+
+  // 获取异步请求的完成队列
+  CompletionQueue* GetCompletionQueue();
+
+  // 本轮事件循环醒来的时间，作为请求开始排队的时间，只在设置准入控制器时更新
+  uint64_t GetLoopTime() const;
+
  private:
   static const int kQueueDepth = 1024;  // io_uring队列深度
   static const int kReadSize = 8192;    // 读缓冲区大小
@@ -51,18 +82,36 @@ class HttpServer {
   void HandleNewConnection(int client_fd, struct sockaddr_in* client_addr);
 
   // 处理读事件
-  void HandleRead(int fd, const char* data, int bytes_read);
+  void HandleRead(int fd, uint64_t serial, const char* data, int bytes_read);
 
   // 处理写事件
-  void HandleWrite(int fd, int bytes_written);
+  void HandleWrite(int fd, uint64_t serial, int bytes_written);
+
+  // 读写失败或对端关闭，移除提交请求的那个连接
+  void HandleIoError(int fd, uint64_t serial);
+
+  // 提交完成队列eventfd的读请求，读完成即有异步请求完成
+  void SubmitCompletionRead();
+
+  // 把完成的异步请求交还给对应的连接
+  void HandleCompletions();
 
   std::string ip_;                         // 服务器IP地址
   int port_;                               // 服务器端口
   int listen_fd_;                          // 监听套接字
   bool running_;                           // 服务器运行状态
   struct io_uring ring_;                   // io_uring实例
+  uint64_t next_serial_;                   // 下一个连接的序号
+  CompletionQueue completions_;            // 异步请求的完成队列
+  uint64_t loop_time_ns_;                  // 本轮事件循环醒来的时间
   std::map<int, std::unique_ptr<HttpConnection>> connections_;  // 连接映射表
   RequestCallback request_callback_;       // 请求回调函数
+  ResponseCompressor* compressor_;         // 响应压缩器
+  StaticResponseCache* static_cache_;      // 静态响应缓存
+  AdmissionController* admission_;         // 准入控制器
+  RateLimiter* rate_limiter_;              // 请求限速
+  ResponseCache* response_cache_;          // 响应缓存
+  RequestCoalescer* coalescer_;            // 请求合并
 };
 
 #endif  // HTTP_SERVER_H_
\ No newline at end of file
@@ -0,0 +1,94 @@
+// 准入控制实现
+#include "admission_controller.h"
+
+#include <time.h>
+#include <string>
+
+AdmissionController::AdmissionController(size_t max_connections,
+                                         size_t max_in_flight,
+                                         int target_delay_ms, int interval_ms)
+    : max_connections_(max_connections),
+      max_in_flight_(max_in_flight),
+      target_ns_(static_cast<uint64_t>(target_delay_ms) * 1000000),
+      interval_ns_(static_cast<uint64_t>(interval_ms) * 1000000),
+      in_flight_(0),
+      interval_end_ns_(0),
+      min_sojourn_ns_(UINT64_MAX),
+      overloaded_(false),
+      stats_() {
+  HttpResponse response;
+  response.SetStatusCode(HttpStatusCode::k503ServiceUnavailable);
+  response.SetHeader("Content-Type", "text/plain");
+  response.SetHeader("Retry-After", std::to_string(kRetryAfterSeconds));
+  response.SetBody("Service Unavailable");
+  reject_ = reject_cache_.Add(response);
+}
+
+AdmissionController::~AdmissionController() {}
+
+bool AdmissionController::AcceptConnection(size_t connections) {
+  if (max_connections_ > 0 && connections >= max_connections_) {
+    ++stats_.rejected_connections;
+    return false;
+  }
+  return true;
+}
+
+bool AdmissionController::BeginRequest(uint64_t arrival_ns) {
+  if (max_in_flight_ > 0 && in_flight_ >= max_in_flight_) {
+    ++stats_.shed_in_flight;
+    return false;
+  }
+
+  if (target_ns_ > 0) {
+    uint64_t now = NowNanos();
+    uint64_t sojourn = now > arrival_ns ? now - arrival_ns : 0;
+    if (ShouldDrop(sojourn, now)) {
+      ++stats_.shed_delay;
+      return false;
+    }
+  }
+
+  ++in_flight_;
+  ++stats_.admitted;
+  return true;
+}
+
+void AdmissionController::EndRequest() {
+  --in_flight_;
+}
+
+const PreSerializedResponse* AdmissionController::GetRejectResponse() {
+  // 只在拒绝时刷新Date，不影响正常请求
+  reject_cache_.Tick(time(nullptr));
+  return reject_;
+}
+
+const AdmissionStats& AdmissionController::GetStats() const {
+  return stats_;
+}
+
+uint64_t AdmissionController::NowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+bool AdmissionController::ShouldDrop(uint64_t sojourn_ns, uint64_t now_ns) {
+  // 每个窗口结束时检查窗口内的最小排队延迟：只要有一个请求几乎没有排队，
+  // 说明队列曾经排空，延迟只是突发；最小值也超过目标值才说明队列持续堆积
+  if (now_ns >= interval_end_ns_) {
+    overloaded_ =
+        min_sojourn_ns_ != UINT64_MAX && min_sojourn_ns_ > target_ns_;
+    min_sojourn_ns_ = UINT64_MAX;
+    interval_end_ns_ = now_ns + interval_ns_;
+  }
+  if (sojourn_ns < min_sojourn_ns_) {
+    min_sojourn_ns_ = sojourn_ns;
+  }
+
+  // 平时只丢弃排队超过一个窗口的请求；过载时排队超过目标值就丢弃，
+  // 让处理能力留给刚到达、还来得及按时回答的请求
+  uint64_t limit = overloaded_ ? target_ns_ : interval_ns_;
+  return sojourn_ns > limit;
+}
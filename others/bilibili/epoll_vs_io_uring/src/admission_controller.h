@@ -0,0 +1,77 @@
+// 准入控制和过载时的快速拒绝
+#ifndef ADMISSION_CONTROLLER_H_
+#define ADMISSION_CONTROLLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "static_response_cache.h"
+
+// 准入控制的统计
+struct AdmissionStats {
+  uint64_t admitted;              // 准入的请求数
+  uint64_t shed_in_flight;        // 超过并发上限被拒绝的请求数
+  uint64_t shed_delay;            // 排队延迟过高被丢弃的请求数
+  uint64_t rejected_connections;  // 超过连接数上限被拒绝的连接数
+};
+
+// 准入控制器
+// 过载时把请求全部接下来只会让所有请求一起变慢，尽早拒绝一部分才能让
+// 其余请求的延迟保持有界。控制分三层：
+//   1. 连接数达到上限时，新连接收到503后立即关闭；
+//   2. 处理中的请求（包括等待异步完成的）达到上限时，新请求收到503；
+//   3. 按排队延迟（请求数据读入到开始处理）自适应丢弃，采用CoDel的思路：
+//      一个观察窗口内的最小排队延迟都高于目标值，说明队列持续堆积而不是
+//      短暂突发，此时排队超过目标值的请求直接丢弃；平时只丢弃排队超过
+//      一个窗口的请求。排队延迟回落后，下一个窗口即恢复正常。
+// 拒绝时统一回答预序列化的503，带Retry-After。只在事件循环线程中访问。
+class AdmissionController {
+ public:
+  static const int kRetryAfterSeconds = 1;  // 建议客户端重试的间隔
+
+  // max_connections和max_in_flight为0表示不限制，target_delay_ms为0表示
+  // 不按排队延迟丢弃；interval_ms为CoDel的观察窗口
+  AdmissionController(size_t max_connections, size_t max_in_flight,
+                      int target_delay_ms, int interval_ms);
+  ~AdmissionController();
+
+  AdmissionController(const AdmissionController&) = delete;
+  AdmissionController& operator=(const AdmissionController&) = delete;
+
+  // 已有connections个连接时能否再接受一个连接，不能接受时计入统计
+  bool AcceptConnection(size_t connections);
+
+  // 请求开始处理前调用，arrival_ns为请求数据读入时的单调时钟
+  // 准入时返回true，请求处理完成后必须调用EndRequest()
+  bool BeginRequest(uint64_t arrival_ns);
+
+  // 准入的请求处理完成
+  void EndRequest();
+
+  // 获取拒绝时回答的503响应
+  const PreSerializedResponse* GetRejectResponse();
+
+  // 获取统计信息
+  const AdmissionStats& GetStats() const;
+
+  // 单调时钟，纳秒
+  static uint64_t NowNanos();
+
+ private:
+  // 根据本次排队延迟决定是否丢弃
+  bool ShouldDrop(uint64_t sojourn_ns, uint64_t now_ns);
+
+  size_t max_connections_;               // 最大连接数
+  size_t max_in_flight_;                 // 最多同时处理的请求数
+  uint64_t target_ns_;                   // 目标排队延迟
+  uint64_t interval_ns_;                 // 观察窗口
+  size_t in_flight_;                     // 正在处理的请求数
+  uint64_t interval_end_ns_;             // 当前观察窗口的结束时刻
+  uint64_t min_sojourn_ns_;              // 当前窗口内的最小排队延迟
+  bool overloaded_;                      // 上一个窗口是否持续过载
+  StaticResponseCache reject_cache_;     // 持有预序列化的503，负责刷新Date
+  const PreSerializedResponse* reject_;  // 拒绝时回答的503
+  AdmissionStats stats_;                 // 统计信息
+};
+
+#endif  // ADMISSION_CONTROLLER_H_
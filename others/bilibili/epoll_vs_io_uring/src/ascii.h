@@ -0,0 +1,38 @@
+// HTTP协议元素的ASCII字符串工具
+#ifndef ASCII_H_
+#define ASCII_H_
+
+#include <stddef.h>
+
+#include <string_view>
+
+// 转为小写，只处理ASCII字母，不受locale影响
+inline char AsciiToLower(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// 按ASCII不区分大小写比较，用于请求头字段名和Cache-Control指令名等
+inline bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (AsciiToLower(a[i]) != AsciiToLower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 去掉两端的空格和制表符
+inline std::string_view TrimSpaces(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+#endif  // ASCII_H_
@@ -0,0 +1,110 @@
+// 异步处理函数的完成队列实现
+#include "completion_queue.h"
+
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+CompletionQueue::CompletionQueue() : head_(nullptr), event_fd_(-1) {}
+
+CompletionQueue::~CompletionQueue() {
+  // 丢弃尚未处理的完成节点
+  AsyncCompletion* node = head_.exchange(nullptr);
+  while (node) {
+    std::unique_ptr<AsyncCompletion> owned(node);
+    node = node->next;
+  }
+
+  if (event_fd_ >= 0) {
+    close(event_fd_);
+  }
+}
+
+bool CompletionQueue::Init() {
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  return event_fd_ >= 0;
+}
+
+int CompletionQueue::GetEventFd() const {
+  return event_fd_;
+}
+
+void CompletionQueue::Push(std::unique_ptr<AsyncCompletion> completion) {
+  AsyncCompletion* node = completion.release();
+  AsyncCompletion* head = head_.load(std::memory_order_relaxed);
+  do {
+    node->next = head;
+  } while (!head_.compare_exchange_weak(head, node, std::memory_order_release,
+                                        std::memory_order_relaxed));
+
+  // 只有队列从空变为非空时才需要唤醒，事件循环会一次取走全部节点
+  if (!head) {
+    uint64_t one = 1;
+    ssize_t n = write(event_fd_, &one, sizeof(one));
+    (void)n;
+  }
+}
+
+void CompletionQueue::Drain(
+    const std::function<void(std::unique_ptr<AsyncCompletion>)>& fn,
+    bool skip_read) {
+  // 先读空eventfd再取链表：之后压入的节点会看到空链表并重新唤醒
+  if (!skip_read) {
+    uint64_t count;
+    ssize_t n = read(event_fd_, &count, sizeof(count));
+    (void)n;
+  }
+
+  AsyncCompletion* node = head_.exchange(nullptr, std::memory_order_acquire);
+
+  // 链表是后进先出的，反转后按完成顺序处理
+  AsyncCompletion* ordered = nullptr;
+  while (node) {
+    AsyncCompletion* next = node->next;
+    node->next = ordered;
+    ordered = node;
+    node = next;
+  }
+
+  while (ordered) {
+    std::unique_ptr<AsyncCompletion> completion(ordered);
+    ordered = ordered->next;
+    fn(std::move(completion));
+  }
+}
+
+CompletionToken::CompletionToken(CompletionQueue* queue, int fd,
+                                 uint64_t serial)
+    : state_(std::make_shared<State>()) {
+  state_->queue = queue;
+  state_->fd = fd;
+  state_->serial = serial;
+  state_->done.store(false, std::memory_order_relaxed);
+}
+
+void CompletionToken::Complete(HttpResponse response) {
+  state_->Complete(std::move(response));
+}
+
+CompletionToken::State::~State() {
+  if (!done.load(std::memory_order_acquire)) {
+    HttpResponse response;
+    response.SetStatusCode(HttpStatusCode::k500InternalError);
+    response.SetHeader("Content-Type", "text/plain");
+    response.SetBody("Internal Server Error");
+    Complete(std::move(response));
+  }
+}
+
+void CompletionToken::State::Complete(HttpResponse response) {
+  if (done.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+
+  auto completion = std::make_unique<AsyncCompletion>();
+  completion->fd = fd;
+  completion->serial = serial;
+  completion->response = std::move(response);
+  completion->next = nullptr;
+  queue->Push(std::move(completion));
+}
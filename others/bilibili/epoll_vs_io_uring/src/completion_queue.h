@@ -0,0 +1,77 @@
+// 异步处理函数的完成队列和完成令牌
+#ifndef COMPLETION_QUEUE_H_
+#define COMPLETION_QUEUE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "http_response.h"
+
+// 一个已完成的异步请求
+struct AsyncCompletion {
+  int fd;                 // 连接的套接字描述符
+  uint64_t serial;        // 连接序号，防止描述符被复用后送错连接
+  HttpResponse response;  // 处理函数生成的响应
+  AsyncCompletion* next;  // 队列中的下一个节点
+};
+
+// 多生产者单消费者的完成队列
+// 工作线程无锁地压入完成的请求，队列从空变为非空时写eventfd唤醒事件循环；
+// 事件循环线程在eventfd可读时一次取出全部节点。
+class CompletionQueue {
+ public:
+  CompletionQueue();
+  ~CompletionQueue();
+
+  CompletionQueue(const CompletionQueue&) = delete;
+  CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+  // 创建eventfd，失败时返回false
+  bool Init();
+
+  // 获取用于唤醒事件循环的eventfd
+  int GetEventFd() const;
+
+  // 压入一个完成的请求，可以在任意线程调用
+  void Push(std::unique_ptr<AsyncCompletion> completion);
+
+  // 取出全部完成的请求并按压入顺序逐个处理，只能在事件循环线程调用
+  // 调用前应已读空eventfd（io_uring由读请求完成），skip_read为false时在这里读
+  void Drain(const std::function<void(std::unique_ptr<AsyncCompletion>)>& fn,
+             bool skip_read = false);
+
+ private:
+  std::atomic<AsyncCompletion*> head_;  // 后进先出的节点链表
+  int event_fd_;                        // 唤醒事件循环的eventfd
+};
+
+// 异步请求的完成令牌
+// 处理函数拿到令牌后可以把工作交给任意线程，在完成时调用Complete()。
+// 令牌可以复制，只有第一次Complete()生效；所有副本都销毁仍未完成时
+// 自动回答500，保证连接不会永远等待。
+class CompletionToken {
+ public:
+  CompletionToken(CompletionQueue* queue, int fd, uint64_t serial);
+
+  // 提交响应，可以在任意线程调用
+  void Complete(HttpResponse response);
+
+ private:
+  struct State {
+    CompletionQueue* queue;  // 所属事件循环的完成队列
+    int fd;                  // 连接的套接字描述符
+    uint64_t serial;         // 连接序号
+    std::atomic<bool> done;  // 是否已经完成
+
+    ~State();
+
+    // 第一次调用时把响应压入完成队列
+    void Complete(HttpResponse response);
+  };
+
+  std::shared_ptr<State> state_;  // 各副本共享的状态
+};
+
+#endif  // COMPLETION_QUEUE_H_
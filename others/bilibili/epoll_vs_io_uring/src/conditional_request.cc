@@ -0,0 +1,80 @@
+// 条件请求实现
+#include "conditional_request.h"
+
+#include "http_date.h"
+
+namespace {
+
+// 跳过逗号分隔列表中的空白和逗号
+size_t SkipSeparators(std::string_view value, size_t pos) {
+  while (pos < value.size() &&
+         (value[pos] == ' ' || value[pos] == '\t' || value[pos] == ',')) {
+    ++pos;
+  }
+  return pos;
+}
+
+}  // namespace
+
+void FormatETag(uint64_t hash, char* out) {
+  static const char kHex[] = "0123456789abcdef";
+  out[0] = '"';
+  for (int i = 0; i < 16; ++i) {
+    out[16 - i] = kHex[hash & 0xf];
+    hash >>= 4;
+  }
+  out[17] = '"';
+  out[18] = '\0';
+}
+
+bool MatchesIfNoneMatch(std::string_view if_none_match, std::string_view etag) {
+  // 弱比较忽略W/前缀，只比较引号内的不透明标签
+  if (etag.substr(0, 2) == "W/") {
+    etag.remove_prefix(2);
+  }
+
+  size_t pos = SkipSeparators(if_none_match, 0);
+  while (pos < if_none_match.size()) {
+    if (if_none_match[pos] == '*') {
+      return true;
+    }
+    if (if_none_match.compare(pos, 2, "W/") == 0) {
+      pos += 2;
+    }
+    if (pos >= if_none_match.size() || if_none_match[pos] != '"') {
+      // 格式不合法，放弃匹配
+      return false;
+    }
+
+    size_t end = if_none_match.find('"', pos + 1);
+    if (end == std::string_view::npos) {
+      return false;
+    }
+    if (if_none_match.substr(pos, end + 1 - pos) == etag) {
+      return true;
+    }
+    pos = SkipSeparators(if_none_match, end + 1);
+  }
+  return false;
+}
+
+bool IsNotModified(const HttpRequest& request, std::string_view etag,
+                   time_t last_modified) {
+  if (request.GetMethod() != HttpMethod::kGet) {
+    return false;
+  }
+
+  const std::string& if_none_match = request.GetHeader("If-None-Match");
+  if (!if_none_match.empty()) {
+    return MatchesIfNoneMatch(if_none_match, etag);
+  }
+
+  // 日期不合法时忽略该条件
+  const std::string& if_modified_since = request.GetHeader("If-Modified-Since");
+  time_t since;
+  if (if_modified_since.empty() ||
+      !ParseHttpDate(if_modified_since, &since)) {
+    return false;
+  }
+  return last_modified <= since;
+}
@@ -0,0 +1,29 @@
+// 条件请求：ETag/Last-Modified验证器和304判断
+#ifndef CONDITIONAL_REQUEST_H_
+#define CONDITIONAL_REQUEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <string_view>
+
+#include "http_request.h"
+
+// 强ETag的固定长度：两个引号加16位十六进制哈希
+constexpr size_t kETagLength = 18;
+
+// 把内容哈希格式化为强ETag，例如 "\"0123456789abcdef\""，
+// out至少需要kETagLength + 1字节
+void FormatETag(uint64_t hash, char* out);
+
+// 判断If-None-Match是否与etag匹配（弱比较，"*"匹配任意资源）
+bool MatchesIfNoneMatch(std::string_view if_none_match, std::string_view etag);
+
+// 判断请求能否用304 Not Modified回答
+// 按RFC 7232，请求带If-None-Match时只看它；否则才看If-Modified-Since。
+// 只对GET请求生效。
+bool IsNotModified(const HttpRequest& request, std::string_view etag,
+                   time_t last_modified);
+
+#endif  // CONDITIONAL_REQUEST_H_
@@ -0,0 +1,32 @@
+// 快速的非加密哈希
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// 按8字节分块的乘法-异或哈希，用于内容去重和ETag，不可用于安全场景
+inline uint64_t HashBytes(const void* data, size_t size) {
+  const uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  uint64_t h = size * kMul;
+
+  while (size >= 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    h = (h ^ word) * kMul;
+    h ^= h >> 29;
+    p += 8;
+    size -= 8;
+  }
+
+  // 处理剩余不足8字节的部分
+  uint64_t tail = 0;
+  memcpy(&tail, p, size);
+  h = (h ^ tail) * kMul;
+  h ^= h >> 32;
+  return h;
+}
+
+#endif  // HASH_H_
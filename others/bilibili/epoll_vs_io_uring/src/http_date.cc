@@ -0,0 +1,86 @@
+// HTTP日期格式化和解析实现
+#include "http_date.h"
+
+#include <string.h>
+
+namespace {
+
+const char* const kWeekdays[] = {"Sun", "Mon", "Tue", "Wed",
+                                 "Thu", "Fri", "Sat"};
+const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                               "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+// 解析定长的十进制数字，遇到非数字返回-1
+int ParseDigits(std::string_view value, size_t pos, size_t count) {
+  int result = 0;
+  for (size_t i = pos; i < pos + count; ++i) {
+    if (value[i] < '0' || value[i] > '9') {
+      return -1;
+    }
+    result = result * 10 + (value[i] - '0');
+  }
+  return result;
+}
+
+// 把非负整数写成定长的十进制数字，不足的位数补0
+void WriteDigits(int value, size_t count, char* out) {
+  for (size_t i = count; i > 0; --i) {
+    out[i - 1] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+}
+
+}  // namespace
+
+void FormatHttpDate(time_t t, char* out) {
+  // 不使用strftime，避免受locale影响；逐个字段按固定宽度写入，
+  // 超出四位的年份取模，输出总是kHttpDateLength个字符
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  memcpy(out, "Sun, 00 Jan 0000 00:00:00 GMT", kHttpDateLength + 1);
+  memcpy(out, kWeekdays[tm.tm_wday], 3);
+  WriteDigits(tm.tm_mday, 2, out + 5);
+  memcpy(out + 8, kMonths[tm.tm_mon], 3);
+  WriteDigits((tm.tm_year + 1900) % 10000, 4, out + 12);
+  WriteDigits(tm.tm_hour, 2, out + 17);
+  WriteDigits(tm.tm_min, 2, out + 20);
+  WriteDigits(tm.tm_sec, 2, out + 23);
+}
+
+bool ParseHttpDate(std::string_view value, time_t* out) {
+  // "Sun, 06 Nov 1994 08:49:37 GMT"
+  if (value.size() != kHttpDateLength || value.substr(3, 2) != ", " ||
+      value[7] != ' ' || value[11] != ' ' || value[16] != ' ' ||
+      value[19] != ':' || value[22] != ':' || value.substr(25) != " GMT") {
+    return false;
+  }
+
+  int month = -1;
+  for (int i = 0; i < 12; ++i) {
+    if (value.substr(8, 3) == kMonths[i]) {
+      month = i;
+      break;
+    }
+  }
+
+  int day = ParseDigits(value, 5, 2);
+  int year = ParseDigits(value, 12, 4);
+  int hour = ParseDigits(value, 17, 2);
+  int minute = ParseDigits(value, 20, 2);
+  int second = ParseDigits(value, 23, 2);
+  if (month < 0 || day < 1 || day > 31 || year < 1970 || hour < 0 ||
+      hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60) {
+    return false;
+  }
+
+  // 星期由日期决定，不再校验
+  struct tm tm = {};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month;
+  tm.tm_mday = day;
+  tm.tm_hour = hour;
+  tm.tm_min = minute;
+  tm.tm_sec = second;
+  *out = timegm(&tm);
+  return true;
+}
@@ -0,0 +1,20 @@
+// HTTP日期格式化和解析
+#ifndef HTTP_DATE_H_
+#define HTTP_DATE_H_
+
+#include <stddef.h>
+#include <time.h>
+
+#include <string_view>
+
+// HTTP日期的固定长度，例如 "Sun, 06 Nov 1994 08:49:37 GMT"
+constexpr size_t kHttpDateLength = 29;
+
+// 按RFC 7231的IMF-fixdate格式输出，out至少需要kHttpDateLength + 1字节
+void FormatHttpDate(time_t t, char* out);
+
+// 解析IMF-fixdate格式的日期，格式不合法时返回false
+// 已废弃的RFC 850和asctime格式不支持，按RFC 7232视为条件不存在
+bool ParseHttpDate(std::string_view value, time_t* out);
+
+#endif  // HTTP_DATE_H_
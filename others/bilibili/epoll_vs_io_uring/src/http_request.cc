@@ -3,24 +3,50 @@
 
 #include <string.h>
 #include <algorithm>
+#include <charconv>
+
+#include "ascii.h"
+
+namespace {
+
+// 解析Content-Length，只允许十进制数字（两端可有空白），
+// 格式错误或溢出时返回false
+bool ParseContentLength(std::string_view value, size_t* length) {
+  value = TrimSpaces(value);
+  auto result =
+      std::from_chars(value.data(), value.data() + value.size(), *length);
+  return !value.empty() && result.ec == std::errc() &&
+         result.ptr == value.data() + value.size();
+}
+
+}  // namespace
 
 HttpRequest::HttpRequest()
     : method_(HttpMethod::kUnknown),
-      state_(HttpRequestParseState::kRequestLine) {}
+      header_count_(0),
+      content_length_(0),
+      state_(HttpRequestParseState::kRequestLine),
+      parsed_bytes_(0),
+      remote_ip_(0) {}
 
 HttpRequest::~HttpRequest() {}
 
 void HttpRequest::Reset() {
   method_ = HttpMethod::kUnknown;
   path_.clear();
+  query_.clear();
   version_.clear();
-  headers_.clear();
+  header_count_ = 0;
+  content_length_ = 0;
   body_.clear();
   state_ = HttpRequestParseState::kRequestLine;
+  parsed_bytes_ = 0;
 }
 
 bool HttpRequest::Parse(const char* buffer, size_t size) {
-  const char* begin = buffer;
+  // buffer始终从请求起始处开始，跳过上次调用已经解析过的部分，
+  // 这样数据分多次到达时不会把请求行重复当作请求头解析
+  const char* begin = buffer + parsed_bytes_;
   const char* end = buffer + size;
 
   while (begin < end && state_ != HttpRequestParseState::kComplete &&
@@ -48,13 +74,15 @@ bool HttpRequest::Parse(const char* buffer, size_t size) {
       if (begin == line_end) {
         begin = line_end + 2;  // 跳过\r\n
 
-        // 检查是否有请求体
-        auto it = headers_.find("Content-Length");
-        if (it != headers_.end() && std::stoi(it->second) > 0) {
-          state_ = HttpRequestParseState::kBody;
-        } else {
-          state_ = HttpRequestParseState::kComplete;
+        // 检查是否有请求体，长度由客户端给出，不合法时按解析错误处理
+        const std::string* length = FindHeader("Content-Length");
+        content_length_ = 0;
+        if (length && !ParseContentLength(*length, &content_length_)) {
+          state_ = HttpRequestParseState::kError;
+          return false;
         }
+        state_ = content_length_ > 0 ? HttpRequestParseState::kBody
+                                     : HttpRequestParseState::kComplete;
       } else {
         if (!ParseHeaders(begin, line_end)) {
           state_ = HttpRequestParseState::kError;
@@ -63,24 +91,19 @@ bool HttpRequest::Parse(const char* buffer, size_t size) {
         begin = line_end + 2;  // 跳过\r\n
       }
     } else if (state_ == HttpRequestParseState::kBody) {
-      auto it = headers_.find("Content-Length");
-      if (it == headers_.end()) {
-        state_ = HttpRequestParseState::kComplete;
-        continue;
-      }
-
-      int content_length = std::stoi(it->second);
-      if (end - begin >= content_length) {
-        if (!ParseBody(begin, begin + content_length)) {
+      if (static_cast<size_t>(end - begin) >= content_length_) {
+        if (!ParseBody(begin, begin + content_length_)) {
           state_ = HttpRequestParseState::kError;
           return false;
         }
-        begin += content_length;
+        begin += content_length_;
         state_ = HttpRequestParseState::kComplete;
       } else {
         return false;  // 数据不完整，等待更多数据
       }
     }
+
+    parsed_bytes_ = begin - buffer;
   }
 
   return state_ == HttpRequestParseState::kComplete;
@@ -94,7 +117,7 @@ bool HttpRequest::ParseRequestLine(const char* begin, const char* end) {
   }
 
   // 解析HTTP方法
-  std::string method(begin, space1);
+  std::string_view method(begin, space1 - begin);
   if (method == "GET") {
     method_ = HttpMethod::kGet;
   } else if (method == "POST") {
@@ -113,8 +136,14 @@ bool HttpRequest::ParseRequestLine(const char* begin, const char* end) {
     return false;
   }
 
-  // 解析URL
-  path_.assign(space1 + 1, space2);
+  // 解析URL，在路由匹配之前分离出查询字符串
+  const char* question = std::find(space1 + 1, space2, '?');
+  path_.assign(space1 + 1, question);
+  if (question != space2) {
+    query_.assign(question + 1, space2);
+  } else {
+    query_.clear();
+  }
 
   // 解析HTTP版本
   version_.assign(space2 + 1, end);
@@ -129,15 +158,28 @@ bool HttpRequest::ParseHeaders(const char* begin, const char* end) {
     return false;
   }
 
-  std::string key(begin, colon);
+  std::string_view key(begin, colon - begin);
   // 跳过冒号和空格
   const char* value_begin = colon + 1;
   while (value_begin < end && *value_begin == ' ') {
     ++value_begin;
   }
 
-  std::string value(value_begin, end);
-  headers_[key] = value;
+  // 同名请求头覆盖之前的值，字段名不区分大小写
+  for (size_t i = 0; i < header_count_; ++i) {
+    if (EqualsIgnoreCase(headers_[i].first, key)) {
+      headers_[i].second.assign(value_begin, end);
+      return true;
+    }
+  }
+
+  // 优先复用上一个请求留下的元素，保留其字符串容量
+  if (header_count_ == headers_.size()) {
+    headers_.emplace_back();
+  }
+  auto& header = headers_[header_count_++];
+  header.first.assign(key);
+  header.second.assign(value_begin, end);
 
   return true;
 }
@@ -155,20 +197,53 @@ const std::string& HttpRequest::GetPath() const {
   return path_;
 }
 
+const std::string& HttpRequest::GetQuery() const {
+  return query_;
+}
+
 const std::string& HttpRequest::GetVersion() const {
   return version_;
 }
 
-const std::string& HttpRequest::GetHeader(const std::string& key) const {
+const std::string& HttpRequest::GetHeader(std::string_view key) const {
   static const std::string empty_string;
-  auto it = headers_.find(key);
-  return it != headers_.end() ? it->second : empty_string;
+  const std::string* value = FindHeader(key);
+  return value ? *value : empty_string;
 }
 
 const std::string& HttpRequest::GetBody() const {
   return body_;
 }
 
+void HttpRequest::SetRemoteIp(uint32_t ip) {
+  remote_ip_ = ip;
+}
+
+uint32_t HttpRequest::GetRemoteIp() const {
+  return remote_ip_;
+}
+
+size_t HttpRequest::GetHeaderCount() const {
+  return header_count_;
+}
+
 bool HttpRequest::IsComplete() const {
   return state_ == HttpRequestParseState::kComplete;
+}
+
+bool HttpRequest::HasError() const {
+  return state_ == HttpRequestParseState::kError;
+}
+
+size_t HttpRequest::GetParsedBytes() const {
+  return parsed_bytes_;
+}
+
+const std::string* HttpRequest::FindHeader(std::string_view key) const {
+  for (size_t i = 0; i < header_count_; ++i) {
+    if (EqualsIgnoreCase(headers_[i].first, key)) {
+      return &headers_[i].second;
+    }
+  }
+  return nullptr;
 }
\ No newline at end of file
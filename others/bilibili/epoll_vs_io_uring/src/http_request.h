@@ -2,8 +2,11 @@
 #ifndef HTTP_REQUEST_H_
 #define HTTP_REQUEST_H_
 
-#include <map>
+#include <stdint.h>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 // HTTP请求解析状态
 enum class HttpRequestParseState {
@@ -23,7 +26,7 @@ class HttpRequest {
   HttpRequest();
   ~HttpRequest();
 
-  // 重置请求状态
+  // 重置请求状态，对端地址属于连接，不会被重置
   void Reset();
 
   // 解析HTTP请求
@@ -32,21 +35,39 @@ class HttpRequest {
   // 获取HTTP方法
   HttpMethod GetMethod() const;
 
-  // 获取请求路径
+  // 获取请求路径，不含查询字符串
   const std::string& GetPath() const;
 
+  // 获取查询字符串，不含'?'，没有时为空
+  const std::string& GetQuery() const;
+
   // 获取HTTP版本
   const std::string& GetVersion() const;
 
-  // 获取请求头
-  const std::string& GetHeader(const std::string& key) const;
+  // 获取请求头，字段名不区分大小写
+  const std::string& GetHeader(std::string_view key) const;
 
   // 获取请求体
   const std::string& GetBody() const;
 
+  // 获取请求头数量
+  size_t GetHeaderCount() const;
+
+  // 设置对端的IPv4地址（主机字节序），由连接在建立时设置
+  void SetRemoteIp(uint32_t ip);
+
+  // 获取对端的IPv4地址（主机字节序）
+  uint32_t GetRemoteIp() const;
+
   // 判断请求是否解析完成
   bool IsComplete() const;
 
+  // 判断请求是否无法解析，出错后Parse()一直返回false，连接应回答400
+  bool HasError() const;
+
+  // 获取已消费的字节数（流水线请求中下一个请求的起始偏移）
+  size_t GetParsedBytes() const;
+
  private:
   // 解析请求行
   bool ParseRequestLine(const char* begin, const char* end);
@@ -57,12 +78,20 @@ class HttpRequest {
   // 解析请求体
   bool ParseBody(const char* begin, const char* end);
 
-  HttpMethod method_;                           // HTTP方法
-  std::string path_;                            // 请求路径
-  std::string version_;                         // HTTP版本
-  std::map<std::string, std::string> headers_;  // 请求头
-  std::string body_;                            // 请求体
-  HttpRequestParseState state_;                 // 解析状态
+  // 查找请求头，字段名不区分大小写，不存在时返回nullptr
+  const std::string* FindHeader(std::string_view key) const;
+
+  HttpMethod method_;                                         // HTTP方法
+  std::string path_;                                          // 请求路径
+  std::string query_;                                         // 查询字符串
+  std::string version_;                                       // HTTP版本
+  std::vector<std::pair<std::string, std::string>> headers_;  // 请求头，元素复用
+  size_t header_count_;                                       // 有效的请求头数量
+  size_t content_length_;                                     // 请求体长度
+  std::string body_;                                          // 请求体
+  HttpRequestParseState state_;                               // 解析状态
+  size_t parsed_bytes_;                                       // 已消费的字节数
+  uint32_t remote_ip_;                                        // 对端IPv4地址
 };
 
 #endif  // HTTP_REQUEST_H_
\ No newline at end of file
@@ -1,65 +1,350 @@
 // HTTP响应类实现
 #include "http_response.h"
 
-HttpResponse::HttpResponse() : status_code_(HttpStatusCode::k200Ok) {}
+#include <charconv>
+
+#include "static_response_cache.h"
+
+namespace {
+
+// 状态码对应的完整状态行，编译期确定
+constexpr std::string_view StatusLine(HttpStatusCode code) {
+  switch (code) {
+    case HttpStatusCode::k100Continue:
+      return "HTTP/1.1 100 Continue\r\n";
+    case HttpStatusCode::k101SwitchingProtocols:
+      return "HTTP/1.1 101 Switching Protocols\r\n";
+    case HttpStatusCode::k102Processing:
+      return "HTTP/1.1 102 Processing\r\n";
+    case HttpStatusCode::k103EarlyHints:
+      return "HTTP/1.1 103 Early Hints\r\n";
+    case HttpStatusCode::k200Ok:
+      return "HTTP/1.1 200 OK\r\n";
+    case HttpStatusCode::k201Created:
+      return "HTTP/1.1 201 Created\r\n";
+    case HttpStatusCode::k202Accepted:
+      return "HTTP/1.1 202 Accepted\r\n";
+    case HttpStatusCode::k203NonAuthoritativeInformation:
+      return "HTTP/1.1 203 Non-Authoritative Information\r\n";
+    case HttpStatusCode::k204NoContent:
+      return "HTTP/1.1 204 No Content\r\n";
+    case HttpStatusCode::k205ResetContent:
+      return "HTTP/1.1 205 Reset Content\r\n";
+    case HttpStatusCode::k206PartialContent:
+      return "HTTP/1.1 206 Partial Content\r\n";
+    case HttpStatusCode::k207MultiStatus:
+      return "HTTP/1.1 207 Multi-Status\r\n";
+    case HttpStatusCode::k208AlreadyReported:
+      return "HTTP/1.1 208 Already Reported\r\n";
+    case HttpStatusCode::k226ImUsed:
+      return "HTTP/1.1 226 IM Used\r\n";
+    case HttpStatusCode::k300MultipleChoices:
+      return "HTTP/1.1 300 Multiple Choices\r\n";
+    case HttpStatusCode::k301MovedPermanently:
+      return "HTTP/1.1 301 Moved Permanently\r\n";
+    case HttpStatusCode::k302Found:
+      return "HTTP/1.1 302 Found\r\n";
+    case HttpStatusCode::k303SeeOther:
+      return "HTTP/1.1 303 See Other\r\n";
+    case HttpStatusCode::k304NotModified:
+      return "HTTP/1.1 304 Not Modified\r\n";
+    case HttpStatusCode::k305UseProxy:
+      return "HTTP/1.1 305 Use Proxy\r\n";
+    case HttpStatusCode::k307TemporaryRedirect:
+      return "HTTP/1.1 307 Temporary Redirect\r\n";
+    case HttpStatusCode::k308PermanentRedirect:
+      return "HTTP/1.1 308 Permanent Redirect\r\n";
+    case HttpStatusCode::k400BadRequest:
+      return "HTTP/1.1 400 Bad Request\r\n";
+    case HttpStatusCode::k401Unauthorized:
+      return "HTTP/1.1 401 Unauthorized\r\n";
+    case HttpStatusCode::k402PaymentRequired:
+      return "HTTP/1.1 402 Payment Required\r\n";
+    case HttpStatusCode::k403Forbidden:
+      return "HTTP/1.1 403 Forbidden\r\n";
+    case HttpStatusCode::k404NotFound:
+      return "HTTP/1.1 404 Not Found\r\n";
+    case HttpStatusCode::k405MethodNotAllowed:
+      return "HTTP/1.1 405 Method Not Allowed\r\n";
+    case HttpStatusCode::k406NotAcceptable:
+      return "HTTP/1.1 406 Not Acceptable\r\n";
+    case HttpStatusCode::k407ProxyAuthenticationRequired:
+      return "HTTP/1.1 407 Proxy Authentication Required\r\n";
+    case HttpStatusCode::k408RequestTimeout:
+      return "HTTP/1.1 408 Request Timeout\r\n";
+    case HttpStatusCode::k409Conflict:
+      return "HTTP/1.1 409 Conflict\r\n";
+    case HttpStatusCode::k410Gone:
+      return "HTTP/1.1 410 Gone\r\n";
+    case HttpStatusCode::k411LengthRequired:
+      return "HTTP/1.1 411 Length Required\r\n";
+    case HttpStatusCode::k412PreconditionFailed:
+      return "HTTP/1.1 412 Precondition Failed\r\n";
+    case HttpStatusCode::k413ContentTooLarge:
+      return "HTTP/1.1 413 Content Too Large\r\n";
+    case HttpStatusCode::k414UriTooLong:
+      return "HTTP/1.1 414 URI Too Long\r\n";
+    case HttpStatusCode::k415UnsupportedMediaType:
+      return "HTTP/1.1 415 Unsupported Media Type\r\n";
+    case HttpStatusCode::k416RangeNotSatisfiable:
+      return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+    case HttpStatusCode::k417ExpectationFailed:
+      return "HTTP/1.1 417 Expectation Failed\r\n";
+    case HttpStatusCode::k418ImATeapot:
+      return "HTTP/1.1 418 I'm a teapot\r\n";
+    case HttpStatusCode::k421MisdirectedRequest:
+      return "HTTP/1.1 421 Misdirected Request\r\n";
+    case HttpStatusCode::k422UnprocessableContent:
+      return "HTTP/1.1 422 Unprocessable Content\r\n";
+    case HttpStatusCode::k423Locked:
+      return "HTTP/1.1 423 Locked\r\n";
+    case HttpStatusCode::k424FailedDependency:
+      return "HTTP/1.1 424 Failed Dependency\r\n";
+    case HttpStatusCode::k425TooEarly:
+      return "HTTP/1.1 425 Too Early\r\n";
+    case HttpStatusCode::k426UpgradeRequired:
+      return "HTTP/1.1 426 Upgrade Required\r\n";
+    case HttpStatusCode::k428PreconditionRequired:
+      return "HTTP/1.1 428 Precondition Required\r\n";
+    case HttpStatusCode::k429TooManyRequests:
+      return "HTTP/1.1 429 Too Many Requests\r\n";
+    case HttpStatusCode::k431RequestHeaderFieldsTooLarge:
+      return "HTTP/1.1 431 Request Header Fields Too Large\r\n";
+    case HttpStatusCode::k451UnavailableForLegalReasons:
+      return "HTTP/1.1 451 Unavailable For Legal Reasons\r\n";
+    case HttpStatusCode::k500InternalError:
+      return "HTTP/1.1 500 Internal Server Error\r\n";
+    case HttpStatusCode::k501NotImplemented:
+      return "HTTP/1.1 501 Not Implemented\r\n";
+    case HttpStatusCode::k502BadGateway:
+      return "HTTP/1.1 502 Bad Gateway\r\n";
+    case HttpStatusCode::k503ServiceUnavailable:
+      return "HTTP/1.1 503 Service Unavailable\r\n";
+    case HttpStatusCode::k504GatewayTimeout:
+      return "HTTP/1.1 504 Gateway Timeout\r\n";
+    case HttpStatusCode::k505HttpVersionNotSupported:
+      return "HTTP/1.1 505 HTTP Version Not Supported\r\n";
+    case HttpStatusCode::k506VariantAlsoNegotiates:
+      return "HTTP/1.1 506 Variant Also Negotiates\r\n";
+    case HttpStatusCode::k507InsufficientStorage:
+      return "HTTP/1.1 507 Insufficient Storage\r\n";
+    case HttpStatusCode::k508LoopDetected:
+      return "HTTP/1.1 508 Loop Detected\r\n";
+    case HttpStatusCode::k510NotExtended:
+      return "HTTP/1.1 510 Not Extended\r\n";
+    case HttpStatusCode::k511NetworkAuthenticationRequired:
+      return "HTTP/1.1 511 Network Authentication Required\r\n";
+  }
+  return "HTTP/1.1 500 Internal Server Error\r\n";
+}
+
+// 状态行 "HTTP/1.1 200 " 前缀和结尾 "\r\n" 的长度
+constexpr size_t kStatusLinePrefixLength = 13;
+constexpr size_t kCrlfLength = 2;
+
+}  // namespace
+
+HttpResponse::HttpResponse()
+    : status_code_(HttpStatusCode::k200Ok),
+      coalescing_(false),
+      pre_serialized_(nullptr) {}
 
 HttpResponse::~HttpResponse() {}
 
+void HttpResponse::Reset() {
+  status_code_ = HttpStatusCode::k200Ok;
+  headers_.clear();
+  body_.clear();
+  shared_body_.reset();
+  stream_producer_ = nullptr;
+  async_handler_ = nullptr;
+  coalescing_ = false;
+  pre_serialized_ = nullptr;
+}
+
 void HttpResponse::SetStatusCode(HttpStatusCode code) {
   status_code_ = code;
 }
 
-void HttpResponse::SetHeader(const std::string& key, const std::string& value) {
-  headers_[key] = value;
+HttpStatusCode HttpResponse::GetStatusCode() const {
+  return status_code_;
 }
 
-void HttpResponse::SetBody(const std::string& body) {
-  body_ = body;
+void HttpResponse::SetHeader(std::string_view key, std::string_view value) {
+  size_t pos = FindHeader(key);
+  if (pos != std::string::npos) {
+    // 替换已有响应头的值
+    size_t value_begin = pos + key.size() + 2;
+    size_t value_end = headers_.find("\r\n", value_begin);
+    headers_.replace(value_begin, value_end - value_begin, value);
+    return;
+  }
+
+  headers_.append(key);
+  headers_.append(": ");
+  headers_.append(value);
+  headers_.append("\r\n");
 }
 
-std::string HttpResponse::ToString() const {
-  std::string response;
+std::string_view HttpResponse::GetHeader(std::string_view key) const {
+  size_t pos = FindHeader(key);
+  if (pos == std::string::npos) {
+    return std::string_view();
+  }
+
+  size_t value_begin = pos + key.size() + 2;
+  size_t value_end = headers_.find("\r\n", value_begin);
+  return std::string_view(headers_).substr(value_begin,
+                                           value_end - value_begin);
+}
+
+void HttpResponse::SetBody(std::string_view body) {
+  body_.assign(body);
+  shared_body_.reset();
+}
+
+void HttpResponse::SetBody(const char* body) {
+  body_.assign(body);
+  shared_body_.reset();
+}
+
+void HttpResponse::SetBody(std::string&& body) {
+  body_ = std::move(body);
+  shared_body_.reset();
+}
+
+const std::string& HttpResponse::GetBody() const {
+  return body_;
+}
+
+void HttpResponse::SwapBody(std::string* body) {
+  body_.swap(*body);
+  shared_body_.reset();
+}
+
+void HttpResponse::SetBody(std::shared_ptr<const SharedBuffer> body) {
+  body_.clear();
+  shared_body_ = std::move(body);
+}
+
+const std::shared_ptr<const SharedBuffer>& HttpResponse::GetSharedBody()
+    const {
+  return shared_body_;
+}
+
+void HttpResponse::SetStreamProducer(StreamProducer producer) {
+  body_.clear();
+  shared_body_.reset();
+  stream_producer_ = std::move(producer);
+}
+
+bool HttpResponse::IsStreaming() const {
+  return static_cast<bool>(stream_producer_);
+}
+
+StreamProducer HttpResponse::TakeStreamProducer() {
+  StreamProducer producer = std::move(stream_producer_);
+  stream_producer_ = nullptr;
+  return producer;
+}
+
+void HttpResponse::SetAsyncHandler(AsyncHandler handler) {
+  async_handler_ = std::move(handler);
+}
+
+bool HttpResponse::IsAsync() const {
+  return static_cast<bool>(async_handler_);
+}
+
+AsyncHandler HttpResponse::TakeAsyncHandler() {
+  AsyncHandler handler = std::move(async_handler_);
+  async_handler_ = nullptr;
+  return handler;
+}
+
+void HttpResponse::EnableCoalescing() {
+  coalescing_ = true;
+}
+
+bool HttpResponse::IsCoalescing() const {
+  return coalescing_;
+}
+
+void HttpResponse::SetPreSerialized(
+    const PreSerializedResponse* pre_serialized) {
+  pre_serialized_ = pre_serialized;
+}
+
+const PreSerializedResponse* HttpResponse::GetPreSerialized() const {
+  return pre_serialized_;
+}
+
+void HttpResponse::SerializeTo(std::string* out) const {
+  if (pre_serialized_) {
+    out->append(pre_serialized_->wire);
+    return;
+  }
 
   // 添加状态行
-  response.append("HTTP/1.1 ");
-  response.append(std::to_string(static_cast<int>(status_code_)));
-  response.append(" ");
-  response.append(GetStatusMessage(status_code_));
-  response.append("\r\n");
+  out->append(StatusLine(status_code_));
 
   // 添加响应头
-  for (const auto& header : headers_) {
-    response.append(header.first);
-    response.append(": ");
-    response.append(header.second);
-    response.append("\r\n");
+  out->append(headers_);
+
+  // 流式响应长度未知，使用chunked编码
+  if (stream_producer_) {
+    out->append("Transfer-Encoding: chunked\r\n\r\n");
+    return;
+  }
+
+  // 1xx、204和304响应没有响应体，也不发送Content-Length
+  int code = static_cast<int>(status_code_);
+  if (code < 200 || status_code_ == HttpStatusCode::k204NoContent ||
+      status_code_ == HttpStatusCode::k304NotModified) {
+    out->append("\r\n");
+    return;
   }
 
   // 添加Content-Length头
-  response.append("Content-Length: ");
-  response.append(std::to_string(body_.size()));
-  response.append("\r\n");
+  size_t body_size = shared_body_ ? shared_body_->GetSize() : body_.size();
+  char length[24];
+  auto result = std::to_chars(length, length + sizeof(length), body_size);
+  out->append("Content-Length: ");
+  out->append(length, result.ptr - length);
+  out->append("\r\n");
 
   // 空行分隔头部和响应体
-  response.append("\r\n");
+  out->append("\r\n");
 
   // 添加响应体
-  response.append(body_);
+  out->append(body_);
+}
 
+std::string HttpResponse::ToString() const {
+  std::string response;
+  SerializeTo(&response);
+  const auto& body = pre_serialized_ ? pre_serialized_->body : shared_body_;
+  if (body) {
+    response.append(body->GetData(), body->GetSize());
+  }
   return response;
 }
 
-std::string HttpResponse::GetStatusMessage(HttpStatusCode code) const {
-  switch (code) {
-    case HttpStatusCode::k200Ok:
-      return "OK";
-    case HttpStatusCode::k400BadRequest:
-      return "Bad Request";
-    case HttpStatusCode::k404NotFound:
-      return "Not Found";
-    case HttpStatusCode::k500InternalError:
-      return "Internal Server Error";
-    default:
-      return "Unknown";
+std::string_view HttpResponse::GetStatusMessage(HttpStatusCode code) {
+  std::string_view line = StatusLine(code);
+  return line.substr(kStatusLinePrefixLength,
+                     line.size() - kStatusLinePrefixLength - kCrlfLength);
+}
+
+size_t HttpResponse::FindHeader(std::string_view key) const {
+  size_t pos = 0;
+  while (pos < headers_.size()) {
+    size_t line_end = headers_.find("\r\n", pos);
+    if (line_end - pos > key.size() && headers_[pos + key.size()] == ':' &&
+        headers_.compare(pos, key.size(), key) == 0) {
+      return pos;
+    }
+    pos = line_end + 2;
   }
+  return std::string::npos;
 }
\ No newline at end of file
@@ -2,42 +2,187 @@
 #ifndef HTTP_RESPONSE_H_
 #define HTTP_RESPONSE_H_
 
-#include <map>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
+
+#include "shared_buffer.h"
+
+// 前向声明
+struct PreSerializedResponse;
+class ChunkWriter;
+class CompletionToken;
+
+// 流式响应的生产者：向writer写入若干数据块，返回false表示响应结束。
+// 写入返回false（发送队列达到高水位）后应尽快返回，队列排空后会再次被调用。
+using StreamProducer = std::function<bool(ChunkWriter*)>;
+
+// 异步处理函数：在事件循环线程被调用，可以把令牌交给其他线程，
+// 完成后通过令牌提交响应。等待期间连接不处理后续请求。
+using AsyncHandler = std::function<void(CompletionToken)>;
 
 // HTTP状态码
 enum class HttpStatusCode {
+  k100Continue = 100,
+  k101SwitchingProtocols = 101,
+  k102Processing = 102,
+  k103EarlyHints = 103,
   k200Ok = 200,
+  k201Created = 201,
+  k202Accepted = 202,
+  k203NonAuthoritativeInformation = 203,
+  k204NoContent = 204,
+  k205ResetContent = 205,
+  k206PartialContent = 206,
+  k207MultiStatus = 207,
+  k208AlreadyReported = 208,
+  k226ImUsed = 226,
+  k300MultipleChoices = 300,
+  k301MovedPermanently = 301,
+  k302Found = 302,
+  k303SeeOther = 303,
+  k304NotModified = 304,
+  k305UseProxy = 305,
+  k307TemporaryRedirect = 307,
+  k308PermanentRedirect = 308,
   k400BadRequest = 400,
+  k401Unauthorized = 401,
+  k402PaymentRequired = 402,
+  k403Forbidden = 403,
   k404NotFound = 404,
-  k500InternalError = 500
+  k405MethodNotAllowed = 405,
+  k406NotAcceptable = 406,
+  k407ProxyAuthenticationRequired = 407,
+  k408RequestTimeout = 408,
+  k409Conflict = 409,
+  k410Gone = 410,
+  k411LengthRequired = 411,
+  k412PreconditionFailed = 412,
+  k413ContentTooLarge = 413,
+  k414UriTooLong = 414,
+  k415UnsupportedMediaType = 415,
+  k416RangeNotSatisfiable = 416,
+  k417ExpectationFailed = 417,
+  k418ImATeapot = 418,
+  k421MisdirectedRequest = 421,
+  k422UnprocessableContent = 422,
+  k423Locked = 423,
+  k424FailedDependency = 424,
+  k425TooEarly = 425,
+  k426UpgradeRequired = 426,
+  k428PreconditionRequired = 428,
+  k429TooManyRequests = 429,
+  k431RequestHeaderFieldsTooLarge = 431,
+  k451UnavailableForLegalReasons = 451,
+  k500InternalError = 500,
+  k501NotImplemented = 501,
+  k502BadGateway = 502,
+  k503ServiceUnavailable = 503,
+  k504GatewayTimeout = 504,
+  k505HttpVersionNotSupported = 505,
+  k506VariantAlsoNegotiates = 506,
+  k507InsufficientStorage = 507,
+  k508LoopDetected = 508,
+  k510NotExtended = 510,
+  k511NetworkAuthenticationRequired = 511
 };
 
 // HTTP响应类
+// 响应头直接按线上格式追加到内部缓冲区，Reset()只清空内容不释放容量，
+// 连接复用同一个HttpResponse时稳态下不产生堆分配
 class HttpResponse {
  public:
   HttpResponse();
   ~HttpResponse();
 
+  // 重置响应，保留已分配的缓冲区
+  void Reset();
+
   // 设置状态码
   void SetStatusCode(HttpStatusCode code);
 
-  // 设置响应头
-  void SetHeader(const std::string& key, const std::string& value);
+  // 获取状态码
+  HttpStatusCode GetStatusCode() const;
+
+  // 设置响应头，同名响应头会被替换
+  void SetHeader(std::string_view key, std::string_view value);
+
+  // 获取响应头的值，不存在时返回空
+  std::string_view GetHeader(std::string_view key) const;
+
+  // 设置响应体（复制到内部缓冲区）
+  void SetBody(std::string_view body);
+  void SetBody(const char* body);
+
+  // 设置响应体（接管调用者的字符串）
+  void SetBody(std::string&& body);
+
+  // 获取响应体（不包括共享响应体）
+  const std::string& GetBody() const;
+
+  // 与调用者的字符串交换响应体，双方的容量都得以保留
+  void SwapBody(std::string* body);
+
+  // 设置共享的不可变响应体，序列化时不复制，由写路径直接发送
+  void SetBody(std::shared_ptr<const SharedBuffer> body);
+
+  // 获取共享响应体，未设置时返回nullptr
+  const std::shared_ptr<const SharedBuffer>& GetSharedBody() const;
 
-  // 设置响应体
-  void SetBody(const std::string& body);
+  // 设置流式响应的生产者，响应体以chunked编码分块发送
+  void SetStreamProducer(StreamProducer producer);
 
-  // 生成完整的HTTP响应
+  // 是否为流式响应
+  bool IsStreaming() const;
+
+  // 取出流式响应的生产者，由连接负责驱动
+  StreamProducer TakeStreamProducer();
+
+  // 把响应交给异步处理函数生成，连接稍后调用它并等待完成
+  void SetAsyncHandler(AsyncHandler handler);
+
+  // 是否为异步响应
+  bool IsAsync() const;
+
+  // 取出异步处理函数，由连接负责调用
+  AsyncHandler TakeAsyncHandler();
+
+  // 允许合并相同的并发请求：已有相同请求在执行异步处理函数时，
+  // 不再执行本次的异步处理函数，等待那次的结果
+  void EnableCoalescing();
+
+  // 是否允许合并
+  bool IsCoalescing() const;
+
+  // 直接使用预序列化的完整响应，设置后忽略状态码、响应头和响应体
+  void SetPreSerialized(const PreSerializedResponse* pre_serialized);
+
+  // 获取预序列化的响应，未设置时返回nullptr
+  const PreSerializedResponse* GetPreSerialized() const;
+
+  // 把HTTP响应追加到out中，out容量足够时不分配内存
+  // 共享响应体不会写入out，需要调用者通过GetSharedBody()另行发送
+  void SerializeTo(std::string* out) const;
+
+  // 生成完整的HTTP响应，包括共享响应体
   std::string ToString() const;
 
- private:
   // 获取状态码对应的文本描述
-  std::string GetStatusMessage(HttpStatusCode code) const;
+  static std::string_view GetStatusMessage(HttpStatusCode code);
+
+ private:
+  // 查找响应头所在行的起始位置，不存在时返回npos
+  size_t FindHeader(std::string_view key) const;
 
-  HttpStatusCode status_code_;                  // HTTP状态码
-  std::map<std::string, std::string> headers_;  // 响应头
-  std::string body_;                            // 响应体
+  HttpStatusCode status_code_;                       // HTTP状态码
+  std::string headers_;                              // 响应头，按线上格式存放
+  std::string body_;                                 // 响应体
+  std::shared_ptr<const SharedBuffer> shared_body_;  // 共享响应体
+  StreamProducer stream_producer_;                   // 流式响应的生产者
+  AsyncHandler async_handler_;                       // 异步处理函数
+  bool coalescing_;                                  // 是否允许合并相同请求
+  const PreSerializedResponse* pre_serialized_;      // 预序列化的响应
 };
 
 #endif  // HTTP_RESPONSE_H_
\ No newline at end of file
@@ -1,11 +1,30 @@
 // 主程序入口
 #include <signal.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
+#include "admission_controller.h"
+#include "completion_queue.h"
 #include "http_request.h"
 #include "http_response.h"
 #include "http_server.h"
+#include "request_coalescer.h"
+#include "output_queue.h"
+#include "rate_limiter.h"
+#include "response_cache.h"
+#include "response_compressor.h"
+#include "router.h"
+#include "shared_buffer.h"
+#include "static_response_cache.h"
+#include "worker_pool.h"
 
 // 全局服务器指针，用于信号处理
 HttpServer* g_server = nullptr;
@@ -17,35 +36,293 @@ void SignalHandler(int sig) {
   }
 }
 
-// 请求处理回调函数
+// 静态路由的预序列化响应缓存
+StaticResponseCache g_static_cache;
+
+// 404响应，启动时注册
+const PreSerializedResponse* g_not_found = nullptr;
+
+// 响应压缩：1KB以上的文本响应，压缩变体缓存上限64MB
+ResponseCompressor g_compressor(1024, 64 * 1024 * 1024);
+
+// 动态路由表，启动时构建
+Router g_router;
+
+// 可选的静态资源，所有连接共享同一份内存映射
+std::shared_ptr<const SharedBuffer> g_asset;
+
+// 静态资源的Content-Type，按扩展名确定；文本类型注册时会预先压缩
+std::string g_asset_type = "application/octet-stream";
+
+// 承接慢处理函数的工作线程池：4个线程，最多排队1024个任务
+WorkerPool g_workers(4, 1024);
+
+// 准入控制，由--max-connections、--max-in-flight和--target-delay-ms开启，
+// 默认不限制：压测要测量的正是饱和时的表现，不能被提前拒绝掩盖
+std::unique_ptr<AdmissionController> g_admission;
+
+// 按排队延迟丢弃时的观察窗口
+const int kAdmissionIntervalMs = 100;
+
+// 请求限速，由--rate-limit和--key-rate-limit开启，默认不限速：
+// 压测的负载都来自同一个IP，限速会把压测变成测量429
+std::unique_ptr<RateLimiter> g_rate_limiter;
+
+// 限速表最多跟踪的客户端数
+const size_t kRateLimitClients = 1 << 20;
+
+// 动态响应缓存：上限64MB，压缩与否的响应分别缓存
+ResponseCache g_response_cache(64 * 1024 * 1024, {"Accept-Encoding"});
+
+// 合并相同的并发请求：压缩与否的响应分别合并，最多等待2秒
+RequestCoalescer g_coalescer({"Accept-Encoding"}, 2000);
+
+// 流式导出的行数
+const int kExportRows = 1000000;
+
+// 流式导出CSV：每次被调用生成一批行，发送队列满时暂停，
+// 整个导出过程中连接只缓冲不超过高水位的数据
+void StreamExport(HttpResponse* response) {
+  response->SetStatusCode(HttpStatusCode::k200Ok);
+  response->SetHeader("Content-Type", "text/csv");
+  int row = 0;
+  std::string batch;
+  response->SetStreamProducer([row, batch](ChunkWriter* writer) mutable {
+    if (row == 0) {
+      writer->Write("id,name,value\n");
+    }
+
+    // 每批最多1000行，发送队列达到高水位后连接不再调用生产者
+    batch.clear();
+    int end = std::min(row + 1000, kExportRows);
+    for (; row < end; ++row) {
+      batch += std::to_string(row);
+      batch += ",item";
+      batch += std::to_string(row);
+      batch += ',';
+      batch += std::to_string(row * 7 % 1000);
+      batch += '\n';
+    }
+    writer->Write(batch);
+    return row < kExportRows;
+  });
+}
+
+// 按扩展名推断静态资源的Content-Type，未知的扩展名按二进制处理
+std::string GuessContentType(std::string_view path) {
+  static const struct {
+    const char* extension;
+    const char* content_type;
+  } kTypes[] = {
+      {".html", "text/html"},
+      {".txt", "text/plain"},
+      {".css", "text/css"},
+      {".js", "application/javascript"},
+      {".json", "application/json"},
+      {".svg", "image/svg+xml"},
+  };
+  for (const auto& type : kTypes) {
+    std::string_view extension = type.extension;
+    if (path.size() > extension.size() &&
+        path.substr(path.size() - extension.size()) == extension) {
+      return type.content_type;
+    }
+  }
+  return "application/octet-stream";
+}
+
+// 注册静态路由的响应，只序列化一次；设置了压缩器时可压缩的响应
+// 在这里预先压缩，命中时不再压缩
+void RegisterStaticRoutes() {
+  g_static_cache.SetResponseCompressor(&g_compressor);
+
+  HttpResponse index;
+  index.SetStatusCode(HttpStatusCode::k200Ok);
+  index.SetHeader("Content-Type", "text/html");
+  index.SetBody(
+      "<html><body><h1>欢迎访问 HTTP Epoll 服务器</h1></body></html>");
+  g_static_cache.Register("/", index);
+  g_static_cache.Register("/index.html", index);
+
+  HttpResponse hello;
+  hello.SetStatusCode(HttpStatusCode::k200Ok);
+  hello.SetHeader("Content-Type", "text/plain");
+  hello.SetBody("Hello, World!");
+  g_static_cache.Register("/hello", hello);
+
+  HttpResponse info;
+  info.SetStatusCode(HttpStatusCode::k200Ok);
+  info.SetHeader("Content-Type", "application/json");
+  info.SetBody("{\"server\": \"HTTP Epoll Server\", \"version\": \"1.0\"}");
+  g_static_cache.Register("/info", info);
+
+  // 404 未找到
+  HttpResponse not_found;
+  not_found.SetStatusCode(HttpStatusCode::k404NotFound);
+  not_found.SetHeader("Content-Type", "text/html");
+  not_found.SetBody(
+      "<html><body><h1>404 Not "
+      "Found</h1><p>请求的资源不存在</p></body></html>");
+  g_not_found = g_static_cache.Add(not_found);
+
+  // 静态资源直接引用共享缓冲区，不复制，Last-Modified取文件的修改时间
+  if (g_asset) {
+    HttpResponse asset;
+    asset.SetStatusCode(HttpStatusCode::k200Ok);
+    asset.SetHeader("Content-Type", g_asset_type);
+    asset.SetHeader("Cache-Control", "no-cache");
+    asset.SetBody(g_asset);
+    g_static_cache.Register("/asset", asset);
+  }
+}
+
+// 注册动态路由
+bool RegisterDynamicRoutes() {
+  bool ok = g_router.AddRoute(
+      HttpMethod::kGet, "/export",
+      [](const HttpRequest&, const RouteParams&, HttpResponse* response) {
+        StreamExport(response);
+      });
+
+  ok = ok && g_router.AddRoute(
+      HttpMethod::kGet, "/users/:id",
+      [](const HttpRequest& request, const RouteParams& params,
+         HttpResponse* response) {
+        std::string body = "{\"id\": \"";
+        body += params.Get("id");
+        body += "\", \"query\": \"";
+        body += request.GetQuery();
+        body += "\"}";
+        response->SetStatusCode(HttpStatusCode::k200Ok);
+        response->SetHeader("Content-Type", "application/json");
+        response->SetBody(std::move(body));
+      });
+
+  // 模拟耗时50ms的数据库查询，交给工作线程执行，不阻塞事件循环
+  ok = ok && g_router.AddRoute(
+      HttpMethod::kGet, "/slow",
+      [](const HttpRequest&, const RouteParams&, HttpResponse* response) {
+        response->SetAsyncHandler([](CompletionToken token) {
+          bool submitted = g_workers.Submit([token]() mutable {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            HttpResponse result;
+            result.SetStatusCode(HttpStatusCode::k200Ok);
+            result.SetHeader("Content-Type", "application/json");
+            result.SetBody("{\"rows\": 1}");
+            token.Complete(std::move(result));
+          });
+
+          // 线程池已满，直接拒绝，不让请求无限排队
+          if (!submitted) {
+            HttpResponse busy;
+            busy.SetStatusCode(HttpStatusCode::k503ServiceUnavailable);
+            busy.SetHeader("Content-Type", "text/plain");
+            busy.SetBody("Service Unavailable");
+            token.Complete(std::move(busy));
+          }
+        });
+      });
+
+  // 模拟耗时100ms的报表查询，结果可以缓存5秒；缓存过期时同一报表的
+  // 并发请求只查询一次，其余请求等待这次查询的结果
+  RouteOptions coalesce;
+  coalesce.coalesce = true;
+  ok = ok && g_router.AddRoute(
+      HttpMethod::kGet, "/report/:name",
+      [](const HttpRequest& request, const RouteParams& params,
+         HttpResponse* response) {
+        std::string body = "{\"report\": \"";
+        body += params.Get("name");
+        body += "\", \"query\": \"";
+        body += request.GetQuery();
+        body += "\"}";
+        response->SetAsyncHandler([body](CompletionToken token) {
+          bool submitted = g_workers.Submit([token, body]() mutable {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            HttpResponse result;
+            result.SetStatusCode(HttpStatusCode::k200Ok);
+            result.SetHeader("Content-Type", "application/json");
+            result.SetHeader("Cache-Control", "max-age=5");
+            result.SetBody(std::move(body));
+            token.Complete(std::move(result));
+          });
+
+          if (!submitted) {
+            HttpResponse busy;
+            busy.SetStatusCode(HttpStatusCode::k503ServiceUnavailable);
+            busy.SetHeader("Content-Type", "text/plain");
+            busy.SetBody("Service Unavailable");
+            token.Complete(std::move(busy));
+          }
+        });
+      },
+      coalesce);
+
+  return ok;
+}
+
+// 请求处理回调函数，静态路由已由连接在调用前从缓存中回答
 void HandleRequest(const HttpRequest& request, HttpResponse* response) {
   std::cout << "收到请求: " << request.GetPath() << std::endl;
 
-  // 根据请求路径提供不同的响应
-  if (request.GetPath() == "/" || request.GetPath() == "/index.html") {
-    response->SetStatusCode(HttpStatusCode::k200Ok);
-    response->SetHeader("Content-Type", "text/html");
-    response->SetBody(
-        "<html><body><h1>欢迎访问 HTTP Epoll 服务器</h1></body></html>");
-  } else if (request.GetPath() == "/hello") {
-    response->SetStatusCode(HttpStatusCode::k200Ok);
-    response->SetHeader("Content-Type", "text/plain");
-    response->SetBody("Hello, World!");
-  } else if (request.GetPath() == "/info") {
-    response->SetStatusCode(HttpStatusCode::k200Ok);
-    response->SetHeader("Content-Type", "application/json");
-    response->SetBody(
-        "{\"server\": \"HTTP Epoll Server\", \"version\": \"1.0\"}");
-  } else {
-    // 404 未找到
-    response->SetStatusCode(HttpStatusCode::k404NotFound);
-    response->SetHeader("Content-Type", "text/html");
-    response->SetBody(
-        "<html><body><h1>404 Not "
-        "Found</h1><p>请求的资源不存在</p></body></html>");
+  if (!g_router.Dispatch(request, response)) {
+    response->SetPreSerialized(g_not_found);
   }
 }
 
+// 解析非负整数，整个字符串都必须是数字
+template <class T>
+bool ParseNumber(std::string_view text, T* value) {
+  auto result = std::from_chars(text.data(), text.data() + text.size(), *value);
+  return !text.empty() && result.ec == std::errc() &&
+         result.ptr == text.data() + text.size();
+}
+
+// 解析“每秒请求数,突发数”，突发数省略时取每秒请求数的两倍
+bool ParseRateLimit(std::string_view text, RateLimit* limit) {
+  size_t comma = text.find(',');
+  if (!ParseNumber(text.substr(0, comma), &limit->rate)) {
+    return false;
+  }
+  if (comma == std::string_view::npos) {
+    limit->burst = limit->rate * 2;
+    return true;
+  }
+  return ParseNumber(text.substr(comma + 1), &limit->burst);
+}
+
+// 把本进程的打开文件数限制提高到needed，软限制不够时先用到硬限制，
+// 硬限制也不够时尝试一起提高（需要CAP_SYS_RESOURCE），返回最终的软限制
+rlim_t RaiseFileLimit(rlim_t needed) {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+    return 0;
+  }
+  if (limit.rlim_cur >= needed) {
+    return limit.rlim_cur;
+  }
+  struct rlimit raised = {needed, std::max(needed, limit.rlim_max)};
+  if (setrlimit(RLIMIT_NOFILE, &raised) == 0) {
+    return needed;
+  }
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+  getrlimit(RLIMIT_NOFILE, &limit);
+  return limit.rlim_cur;
+}
+
+// 输出用法
+void PrintUsage(const char* program) {
+  std::cerr << "用法: " << program << " [端口] [静态资源文件] [选项]\n"
+            << "  --rate-limit R[,B]      每个IP每秒R个请求、突发B个\n"
+            << "  --key-rate-limit R[,B]  每个API Key每秒R个请求、突发B个\n"
+            << "  --max-connections N     最多N个连接，超过时回答503并关闭\n"
+            << "  --max-in-flight N       最多同时处理N个请求，超过时回答503\n"
+            << "  --target-delay-ms N     排队延迟持续高于N毫秒时丢弃请求\n"
+            << "  --max-open-files N      把打开文件数限制提高到N\n"
+            << "所有限制默认关闭" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
   // 设置信号处理
   signal(SIGINT, SignalHandler);
@@ -54,16 +331,82 @@ int main(int argc, char* argv[]) {
   // 默认端口
   int port = 8080;
 
-  // 解析命令行参数
-  if (argc > 1) {
+  // 限速参数，rate为0表示不限速
+  RateLimit ip_limit = {0, 0};
+  RateLimit key_limit = {0, 0};
+
+  // 准入控制参数，0表示不限制
+  size_t max_connections = 0;
+  size_t max_in_flight = 0;
+  int target_delay_ms = 0;
+
+  // 打开文件数限制，0表示保持继承的限制；每个连接占一个描述符
+  rlim_t max_open_files = 0;
+
+  // 解析命令行参数：前两个位置参数为端口和静态资源文件（通过/asset访问），
+  // 其余为--选项
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 2, "--") != 0) {
+      positional.push_back(arg);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "选项缺少参数: " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    std::string value = argv[++i];
+    bool ok;
+    if (arg == "--rate-limit") {
+      ok = ParseRateLimit(value, &ip_limit);
+    } else if (arg == "--key-rate-limit") {
+      ok = ParseRateLimit(value, &key_limit);
+    } else if (arg == "--max-connections") {
+      ok = ParseNumber(value, &max_connections);
+    } else if (arg == "--max-in-flight") {
+      ok = ParseNumber(value, &max_in_flight);
+    } else if (arg == "--target-delay-ms") {
+      ok = ParseNumber(value, &target_delay_ms);
+    } else if (arg == "--max-open-files") {
+      ok = ParseNumber(value, &max_open_files);
+    } else {
+      std::cerr << "未知的选项: " << arg << std::endl;
+      PrintUsage(argv[0]);
+      return 1;
+    }
+    if (!ok) {
+      std::cerr << "选项的参数无效: " << arg << " " << value << std::endl;
+      return 1;
+    }
+  }
+
+  if (positional.size() > 0) {
     try {
-      port = std::stoi(argv[1]);
+      port = std::stoi(positional[0]);
     } catch (const std::exception& e) {
       std::cerr << "端口参数无效: " << e.what() << std::endl;
       return 1;
     }
   }
 
+  if (positional.size() > 1) {
+    g_asset = SharedBuffer::MapFile(positional[1]);
+    if (!g_asset) {
+      std::cerr << "无法映射静态资源文件: " << positional[1] << std::endl;
+      return 1;
+    }
+    g_asset_type = GuessContentType(positional[1]);
+  }
+
+  if (max_open_files > 0) {
+    rlim_t limit = RaiseFileLimit(max_open_files);
+    if (limit < max_open_files) {
+      std::cerr << "警告: 打开文件数限制只能提高到 " << limit << std::endl;
+    }
+  }
+
   std::cout << "启动 HTTP 服务器，监听端口: " << port << std::endl;
 
   // 创建并启动服务器
@@ -71,7 +414,26 @@ int main(int argc, char* argv[]) {
   g_server = &server;
 
   // 设置请求处理回调
+  RegisterStaticRoutes();
+  if (!RegisterDynamicRoutes()) {
+    std::cerr << "路由注册失败" << std::endl;
+    return 1;
+  }
   server.SetRequestCallback(HandleRequest);
+  server.SetStaticResponseCache(&g_static_cache);
+  server.SetResponseCompressor(&g_compressor);
+  if (max_connections > 0 || max_in_flight > 0 || target_delay_ms > 0) {
+    g_admission = std::make_unique<AdmissionController>(
+        max_connections, max_in_flight, target_delay_ms, kAdmissionIntervalMs);
+    server.SetAdmissionController(g_admission.get());
+  }
+  if (ip_limit.rate > 0 || key_limit.rate > 0) {
+    g_rate_limiter = std::make_unique<RateLimiter>(ip_limit, key_limit,
+                                                   kRateLimitClients);
+    server.SetRateLimiter(g_rate_limiter.get());
+  }
+  server.SetResponseCache(&g_response_cache);
+  server.SetRequestCoalescer(&g_coalescer);
 
   // 启动服务器
   if (!server.Start()) {
@@ -82,6 +444,52 @@ int main(int argc, char* argv[]) {
   // 服务器主循环
   server.EventLoop();
 
+  // 等待工作线程处理完已排队的任务，之后不会再有请求完成
+  g_workers.Shutdown();
+
+  // 输出压缩统计
+  const CompressionStats& stats = g_compressor.GetStats();
+  std::cout << "压缩响应数: " << stats.compressed_responses
+            << ", 节省字节: " << stats.bytes_in - stats.bytes_out
+            << ", 压缩CPU耗时: " << stats.cpu_ns / 1000 << " 微秒"
+            << ", 缓存命中/未命中: " << stats.cache_hits << "/"
+            << stats.cache_misses << std::endl;
+
+  // 输出准入控制统计
+  if (g_admission) {
+    const AdmissionStats& admission = g_admission->GetStats();
+    std::cout << "准入请求数: " << admission.admitted
+              << ", 并发超限拒绝: " << admission.shed_in_flight
+              << ", 排队延迟丢弃: " << admission.shed_delay
+              << ", 拒绝连接数: " << admission.rejected_connections
+              << std::endl;
+  }
+
+  // 输出限速统计
+  if (g_rate_limiter) {
+    RateLimitStats limits = g_rate_limiter->GetStats();
+    std::cout << "按IP限速: " << limits.limited_by_ip
+              << ", 按API Key限速: " << limits.limited_by_key
+              << ", 淘汰客户端: " << limits.evictions << std::endl;
+  }
+
+  // 输出响应缓存统计
+  const ResponseCacheStats& cache = g_response_cache.GetStats();
+  uint64_t lookups = cache.hits + cache.misses;
+  std::cout << "响应缓存命中/未命中: " << cache.hits << "/" << cache.misses
+            << ", 命中率: "
+            << (lookups > 0 ? 100.0 * cache.hits / lookups : 0.0)
+            << "%, 缓存响应数: " << cache.entries
+            << ", 占用字节: " << cache.bytes
+            << ", 淘汰/过期: " << cache.evictions << "/" << cache.expirations
+            << std::endl;
+
+  // 输出请求合并统计
+  const CoalescingStats& coalescing = g_coalescer.GetStats();
+  std::cout << "合并请求 计算/等待: " << coalescing.leaders << "/"
+            << coalescing.followers << ", 等待超时: " << coalescing.timeouts
+            << ", 计算放弃: " << coalescing.abandoned << std::endl;
+
   std::cout << "服务器已关闭" << std::endl;
   return 0;
 }
\ No newline at end of file
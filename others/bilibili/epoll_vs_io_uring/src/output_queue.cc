@@ -0,0 +1,190 @@
+// 连接的发送队列和chunked分块写入器实现
+#include "output_queue.h"
+
+#include <algorithm>
+#include <charconv>
+
+OutputQueue::OutputQueue(size_t high_watermark, size_t low_watermark)
+    : head_(0),
+      tail_(0),
+      bytes_(0),
+      append_begin_size_(0),
+      high_watermark_(high_watermark),
+      low_watermark_(low_watermark) {}
+
+OutputQueue::~OutputQueue() {}
+
+void OutputQueue::Append(std::string_view data) {
+  if (data.empty()) {
+    return;
+  }
+
+  Segment* segment = nullptr;
+  if (tail_ > head_ && segments_[tail_ - 1].kind == SegmentKind::kOwned) {
+    segment = &segments_[tail_ - 1];
+  } else {
+    segment = PushSegment(SegmentKind::kOwned);
+  }
+  segment->owned.append(data);
+  segment->size = segment->owned.size();
+  bytes_ += data.size();
+}
+
+void OutputQueue::AppendReference(const char* data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  Segment* segment = PushSegment(SegmentKind::kReference);
+  segment->data = data;
+  segment->size = size;
+  bytes_ += size;
+}
+
+void OutputQueue::Append(std::shared_ptr<const SharedBuffer> buffer,
+                         size_t offset) {
+  if (!buffer || offset >= buffer->GetSize()) {
+    return;
+  }
+
+  Segment* segment = PushSegment(SegmentKind::kShared);
+  segment->data = buffer->GetData();
+  segment->size = buffer->GetSize();
+  segment->offset = offset;
+  segment->shared = std::move(buffer);
+  bytes_ += segment->size - offset;
+}
+
+std::string* OutputQueue::BeginAppend() {
+  Segment* segment = nullptr;
+  if (tail_ > head_ && segments_[tail_ - 1].kind == SegmentKind::kOwned) {
+    segment = &segments_[tail_ - 1];
+  } else {
+    segment = PushSegment(SegmentKind::kOwned);
+  }
+  append_begin_size_ = segment->owned.size();
+  return &segment->owned;
+}
+
+void OutputQueue::EndAppend() {
+  Segment* segment = &segments_[tail_ - 1];
+  segment->size = segment->owned.size();
+  bytes_ += segment->size - append_begin_size_;
+}
+
+int OutputQueue::GetSegments(OutputSegment* segments, int max) const {
+  int count = 0;
+  for (size_t i = head_; i < tail_ && count < max; ++i) {
+    const Segment& segment = segments_[i];
+    if (segment.offset == segment.size) {
+      continue;  // BeginAppend后未写入数据的空段
+    }
+    // 自有数据的地址在取段时现取：段数组扩容或回收段轮转时会移动段，
+    // 短字符串的数据存放在段内，缓存的地址会失效
+    const char* data = segment.kind == SegmentKind::kOwned
+                           ? segment.owned.data()
+                           : segment.data;
+    segments[count].data = data + segment.offset;
+    segments[count].size = segment.size - segment.offset;
+    segments[count].shared =
+        segment.kind == SegmentKind::kShared ? &segment.shared : nullptr;
+    ++count;
+  }
+  return count;
+}
+
+void OutputQueue::Consume(size_t n) {
+  bytes_ -= std::min(n, bytes_);
+  while (head_ < tail_) {
+    Segment& segment = segments_[head_];
+    size_t remaining = segment.size - segment.offset;
+    if (n < remaining) {
+      segment.offset += n;
+      break;
+    }
+
+    // 整段发送完毕，回收该段，保留自有数据的容量
+    n -= remaining;
+    segment.owned.clear();
+    segment.shared.reset();
+    segment.data = nullptr;
+    segment.size = 0;
+    segment.offset = 0;
+    ++head_;
+  }
+
+  if (head_ == tail_) {
+    head_ = 0;
+    tail_ = 0;
+  }
+}
+
+size_t OutputQueue::GetSize() const {
+  return bytes_;
+}
+
+bool OutputQueue::IsEmpty() const {
+  return bytes_ == 0;
+}
+
+bool OutputQueue::IsAboveHighWatermark() const {
+  return bytes_ >= high_watermark_;
+}
+
+bool OutputQueue::IsBelowLowWatermark() const {
+  return bytes_ <= low_watermark_;
+}
+
+OutputQueue::Segment* OutputQueue::PushSegment(SegmentKind kind) {
+  if (tail_ == segments_.size()) {
+    if (head_ > 0) {
+      // 把已回收的段移到末尾，有效段挪到数组前部
+      std::rotate(segments_.begin(), segments_.begin() + head_,
+                  segments_.begin() + tail_);
+      tail_ -= head_;
+      head_ = 0;
+    } else {
+      segments_.emplace_back();
+    }
+  }
+
+  Segment* segment = &segments_[tail_++];
+  segment->kind = kind;
+  segment->data = nullptr;
+  segment->size = 0;
+  segment->offset = 0;
+  return segment;
+}
+
+ChunkWriter::ChunkWriter(OutputQueue* output) : output_(output) {}
+
+bool ChunkWriter::Write(std::string_view data) {
+  // 长度为0的块表示结束，普通写入跳过空数据
+  if (!data.empty()) {
+    WriteChunkHeader(data.size());
+    output_->Append(data);
+    output_->Append("\r\n");
+  }
+  return !output_->IsAboveHighWatermark();
+}
+
+bool ChunkWriter::Write(std::shared_ptr<const SharedBuffer> data) {
+  if (data && data->GetSize() > 0) {
+    WriteChunkHeader(data->GetSize());
+    output_->Append(std::move(data));
+    output_->Append("\r\n");
+  }
+  return !output_->IsAboveHighWatermark();
+}
+
+void ChunkWriter::Finish() {
+  output_->Append("0\r\n\r\n");
+}
+
+void ChunkWriter::WriteChunkHeader(size_t size) {
+  char header[24];
+  auto result = std::to_chars(header, header + sizeof(header) - 2, size, 16);
+  *result.ptr++ = '\r';
+  *result.ptr++ = '\n';
+  output_->Append(std::string_view(header, result.ptr - header));
+}
@@ -0,0 +1,106 @@
+// 连接的发送队列和chunked分块写入器
+#ifndef OUTPUT_QUEUE_H_
+#define OUTPUT_QUEUE_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "shared_buffer.h"
+
+// 发送队列中的一段数据
+struct OutputSegment {
+  const char* data;                                   // 待发送数据
+  size_t size;                                        // 待发送长度
+  const std::shared_ptr<const SharedBuffer>* shared;  // 共享缓冲区，否则为nullptr
+};
+
+// 连接的发送队列
+// 数据按段排队：队列自有的数据、引用的外部数据（预序列化响应）和共享缓冲区。
+// 队列长度超过高水位时连接应暂停处理新请求和流式生产者，降到低水位以下
+// 再恢复。已消费的段会被回收复用，稳态下不产生堆分配。
+class OutputQueue {
+ public:
+  OutputQueue(size_t high_watermark, size_t low_watermark);
+  ~OutputQueue();
+
+  // 追加数据（复制），与队尾的自有数据段合并
+  void Append(std::string_view data);
+
+  // 追加外部数据的引用，数据在发送完成前必须保持有效
+  void AppendReference(const char* data, size_t size);
+
+  // 追加共享缓冲区，从offset开始发送，不复制
+  void Append(std::shared_ptr<const SharedBuffer> buffer, size_t offset = 0);
+
+  // 获取队尾的自有数据段直接写入，写完后必须调用EndAppend()
+  std::string* BeginAppend();
+  void EndAppend();
+
+  // 取出队首最多max段待发送数据，返回段数
+  int GetSegments(OutputSegment* segments, int max) const;
+
+  // 标记n字节已发送
+  void Consume(size_t n);
+
+  // 待发送的字节数
+  size_t GetSize() const;
+
+  // 队列是否为空
+  bool IsEmpty() const;
+
+  // 是否达到高水位
+  bool IsAboveHighWatermark() const;
+
+  // 是否降到低水位以下
+  bool IsBelowLowWatermark() const;
+
+ private:
+  // 段类型
+  enum class SegmentKind { kOwned, kReference, kShared };
+
+  struct Segment {
+    SegmentKind kind;                            // 段类型
+    std::string owned;                           // 自有数据，容量跨段复用
+    const char* data;                            // 引用或共享的数据
+    std::shared_ptr<const SharedBuffer> shared;  // 共享缓冲区
+    size_t size;                                 // 段长度
+    size_t offset;                               // 已发送的长度
+  };
+
+  // 获取一个空闲段放到队尾
+  Segment* PushSegment(SegmentKind kind);
+
+  std::vector<Segment> segments_;  // 段数组，[head_, tail_)为有效段
+  size_t head_;                    // 队首段下标
+  size_t tail_;                    // 队尾段之后的下标
+  size_t bytes_;                   // 待发送的字节数
+  size_t append_begin_size_;       // BeginAppend时队尾段的长度
+  size_t high_watermark_;          // 高水位
+  size_t low_watermark_;           // 低水位
+};
+
+// chunked编码的分块写入器，流式响应的生产者通过它输出数据
+class ChunkWriter {
+ public:
+  explicit ChunkWriter(OutputQueue* output);
+
+  // 写入一个数据块（复制），返回false表示发送队列已达到高水位，
+  // 生产者应尽快返回，等待队列排空后再次被调用
+  bool Write(std::string_view data);
+
+  // 写入一个共享缓冲区数据块（不复制）
+  bool Write(std::shared_ptr<const SharedBuffer> data);
+
+  // 写入结束块
+  void Finish();
+
+ private:
+  // 写入块头部 "<十六进制长度>\r\n"
+  void WriteChunkHeader(size_t size);
+
+  OutputQueue* output_;  // 所属连接的发送队列
+};
+
+#endif  // OUTPUT_QUEUE_H_
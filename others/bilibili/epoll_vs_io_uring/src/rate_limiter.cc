@@ -0,0 +1,246 @@
+// 按客户端的令牌桶限速实现
+#include "rate_limiter.h"
+
+#include <time.h>
+#include <string>
+
+#include "hash.h"
+
+namespace {
+
+const uint64_t kRefBit = 1ULL << 63;            // CLOCK的访问位
+const uint64_t kTokenMask = (1ULL << 31) - 1;  // 令牌数的位宽
+
+// 打散键的各位，IP这样的键高位几乎相同，直接取高位分片会很不均匀
+uint64_t MixKey(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+uint64_t PackState(uint64_t tokens, uint32_t time_ms, bool referenced) {
+  return (referenced ? kRefBit : 0) | (tokens << 32) | time_ms;
+}
+
+uint64_t GetTokens(uint64_t state) {
+  return (state >> 32) & kTokenMask;
+}
+
+uint32_t GetTime(uint64_t state) {
+  return static_cast<uint32_t>(state);
+}
+
+// 不小于n的2的幂
+size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+TokenBucketTable::TokenBucketTable(const RateLimit& limit, size_t capacity)
+    : rate_(limit.rate),
+      capacity_(static_cast<uint64_t>(limit.burst) * kMilli) {
+  // 令牌数只有31位
+  if (capacity_ > kTokenMask) {
+    capacity_ = kTokenMask;
+  }
+
+  size_t total = RoundUpToPowerOfTwo(capacity);
+  shard_size_ = total >> kShardBits;
+  if (shard_size_ < static_cast<size_t>(kProbeLimit)) {
+    shard_size_ = kProbeLimit;
+  }
+  total = shard_size_ << kShardBits;
+
+  slots_.reset(new Slot[total]);
+  for (size_t i = 0; i < total; ++i) {
+    slots_[i].key.store(0, std::memory_order_relaxed);
+    slots_[i].state.store(0, std::memory_order_relaxed);
+  }
+  for (ShardStats& stats : stats_) {
+    stats.rejected.store(0, std::memory_order_relaxed);
+    stats.evictions.store(0, std::memory_order_relaxed);
+  }
+}
+
+TokenBucketTable::~TokenBucketTable() {}
+
+bool TokenBucketTable::Acquire(uint64_t key, uint32_t now_ms) {
+  // 0表示空槽位，不能作为键
+  if (key == 0) {
+    key = 1;
+  }
+  uint64_t hash = MixKey(key);
+  Slot* slot = FindSlot(key, hash, now_ms);
+
+  uint64_t state = slot->state.load(std::memory_order_relaxed);
+  for (;;) {
+    // 按经过的时间补充令牌，时钟回绕时差值仍然正确
+    uint32_t elapsed = now_ms - GetTime(state);
+    uint64_t tokens = GetTokens(state) + elapsed * rate_;
+    if (tokens > capacity_) {
+      tokens = capacity_;
+    }
+
+    bool allowed = tokens >= kMilli;
+    if (allowed) {
+      tokens -= kMilli;
+    }
+
+    // 其他线程同时更新时重新计算
+    if (slot->state.compare_exchange_weak(state,
+                                          PackState(tokens, now_ms, true),
+                                          std::memory_order_relaxed)) {
+      if (!allowed) {
+        stats_[hash >> (64 - kShardBits)].rejected.fetch_add(
+            1, std::memory_order_relaxed);
+      }
+      return allowed;
+    }
+  }
+}
+
+uint64_t TokenBucketTable::GetRejected() const {
+  uint64_t total = 0;
+  for (const ShardStats& stats : stats_) {
+    total += stats.rejected.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+uint64_t TokenBucketTable::GetEvictions() const {
+  uint64_t total = 0;
+  for (const ShardStats& stats : stats_) {
+    total += stats.evictions.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+uint32_t TokenBucketTable::NowMillis() {
+  // 粗粒度时钟走vDSO且不读硬件计数器，精度为一个时钟节拍，足够用来补充令牌
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return static_cast<uint32_t>(static_cast<uint64_t>(ts.tv_sec) * 1000 +
+                               ts.tv_nsec / 1000000);
+}
+
+TokenBucketTable::Slot* TokenBucketTable::FindSlot(uint64_t key,
+                                                   uint64_t hash,
+                                                   uint32_t now_ms) {
+  size_t shard = hash >> (64 - kShardBits);
+  Slot* slots = &slots_[shard * shard_size_];
+  size_t mask = shard_size_ - 1;
+  size_t start = hash & mask;
+
+  // 键不会被删除，只会被原地替换，遇到空槽位说明键不在表中
+  for (int i = 0; i < kProbeLimit; ++i) {
+    Slot* slot = &slots[(start + i) & mask];
+    uint64_t current = slot->key.load(std::memory_order_acquire);
+    if (current == key) {
+      return slot;
+    }
+    if (current == 0) {
+      if (slot->key.compare_exchange_strong(current, key,
+                                            std::memory_order_acq_rel)) {
+        slot->state.store(FullState(now_ms), std::memory_order_relaxed);
+        return slot;
+      }
+      // 同一个键被其他线程抢先插入
+      if (current == key) {
+        return slot;
+      }
+    }
+  }
+
+  // 窗口已满，按CLOCK淘汰：清除经过的访问位，替换第一个最近没有访问的键；
+  // 第二轮时第一轮清除过的槽位都可以替换
+  for (int i = 0; i < 2 * kProbeLimit; ++i) {
+    Slot* slot = &slots[(start + i % kProbeLimit) & mask];
+    uint64_t state = slot->state.load(std::memory_order_relaxed);
+    if (state & kRefBit) {
+      slot->state.fetch_and(~kRefBit, std::memory_order_relaxed);
+      continue;
+    }
+
+    uint64_t victim = slot->key.load(std::memory_order_relaxed);
+    if (slot->key.compare_exchange_strong(victim, key,
+                                          std::memory_order_acq_rel)) {
+      slot->state.store(FullState(now_ms), std::memory_order_relaxed);
+      stats_[shard].evictions.fetch_add(1, std::memory_order_relaxed);
+      return slot;
+    }
+  }
+
+  // 其他线程一直在访问窗口内的键，直接替换起始槽位
+  Slot* slot = &slots[start];
+  slot->key.store(key, std::memory_order_release);
+  slot->state.store(FullState(now_ms), std::memory_order_relaxed);
+  stats_[shard].evictions.fetch_add(1, std::memory_order_relaxed);
+  return slot;
+}
+
+uint64_t TokenBucketTable::FullState(uint32_t now_ms) const {
+  return PackState(capacity_, now_ms, false);
+}
+
+RateLimiter::RateLimiter(const RateLimit& per_ip, const RateLimit& per_key,
+                         size_t capacity) {
+  if (per_ip.rate > 0) {
+    by_ip_ = std::make_unique<TokenBucketTable>(per_ip, capacity);
+  }
+  if (per_key.rate > 0) {
+    by_key_ = std::make_unique<TokenBucketTable>(per_key, capacity);
+  }
+
+  HttpResponse response;
+  response.SetStatusCode(HttpStatusCode::k429TooManyRequests);
+  response.SetHeader("Content-Type", "text/plain");
+  response.SetHeader("Retry-After", std::to_string(kRetryAfterSeconds));
+  response.SetBody("Too Many Requests");
+  reject_ = reject_cache_.Add(response);
+}
+
+RateLimiter::~RateLimiter() {}
+
+bool RateLimiter::Allow(const HttpRequest& request) {
+  uint32_t now = TokenBucketTable::NowMillis();
+
+  if (by_ip_ && !by_ip_->Acquire(request.GetRemoteIp(), now)) {
+    return false;
+  }
+
+  if (by_key_) {
+    const std::string& api_key = request.GetHeader("X-API-Key");
+    if (!api_key.empty() &&
+        !by_key_->Acquire(HashBytes(api_key.data(), api_key.size()), now)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const PreSerializedResponse* RateLimiter::GetRejectResponse() {
+  // 只在拒绝时刷新Date，不影响正常请求
+  reject_cache_.Tick(time(nullptr));
+  return reject_;
+}
+
+RateLimitStats RateLimiter::GetStats() const {
+  RateLimitStats stats = {};
+  if (by_ip_) {
+    stats.limited_by_ip = by_ip_->GetRejected();
+    stats.evictions += by_ip_->GetEvictions();
+  }
+  if (by_key_) {
+    stats.limited_by_key = by_key_->GetRejected();
+    stats.evictions += by_key_->GetEvictions();
+  }
+  return stats;
+}
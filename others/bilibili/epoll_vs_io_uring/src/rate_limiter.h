@@ -0,0 +1,121 @@
+// 按客户端的令牌桶限速
+#ifndef RATE_LIMITER_H_
+#define RATE_LIMITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+#include "http_request.h"
+#include "static_response_cache.h"
+
+// 令牌桶的限速参数
+struct RateLimit {
+  uint32_t rate;   // 每秒补充的令牌数，即长期允许的每秒请求数，0表示不限制
+  uint32_t burst;  // 桶容量，即允许的突发请求数
+};
+
+// 分片的令牌桶表
+// 键是客户端标识的64位哈希，每个键一个令牌桶，令牌数和上次补充时间打包在
+// 一个64位原子变量里，用CAS更新，多个线程访问时也不需要锁。令牌不单独
+// 定时补充，而是访问时按粗粒度时钟经过的时间一次补足。
+// 表按键的高位分片，片内开放寻址，键只会出现在起始位置之后的kProbeLimit个
+// 槽位里；槽位用尽时在这个窗口内按CLOCK算法淘汰最近没有访问的键，
+// 内存固定，不随键的数量增长。被淘汰的客户端下次访问时得到一个满的桶，
+// 对限速来说这种偏差可以接受。
+class TokenBucketTable {
+ public:
+  // capacity为最多跟踪的键数量，向上取整到2的幂
+  TokenBucketTable(const RateLimit& limit, size_t capacity);
+  ~TokenBucketTable();
+
+  TokenBucketTable(const TokenBucketTable&) = delete;
+  TokenBucketTable& operator=(const TokenBucketTable&) = delete;
+
+  // 从key的桶中取一个令牌，令牌不足时返回false，now_ms为NowMillis()的值
+  bool Acquire(uint64_t key, uint32_t now_ms);
+
+  // 被拒绝的请求数
+  uint64_t GetRejected() const;
+
+  // 淘汰的键数
+  uint64_t GetEvictions() const;
+
+  // 粗粒度的单调时钟，毫秒，允许回绕
+  static uint32_t NowMillis();
+
+ private:
+  static const int kShardBits = 6;      // 分片数的对数
+  static const int kProbeLimit = 8;     // 单个键的探测窗口
+  static const uint32_t kMilli = 1000;  // 令牌按千分之一个计数
+
+  // 一个令牌桶，state的低32位是上次补充时间，
+  // 32~62位是令牌数（千分之一个），最高位是CLOCK的访问位
+  struct alignas(16) Slot {
+    std::atomic<uint64_t> key;    // 客户端标识，0表示空槽位
+    std::atomic<uint64_t> state;  // 打包的令牌桶状态
+  };
+
+  // 分片的统计，独占缓存行，避免多个线程争用同一个计数器
+  struct alignas(64) ShardStats {
+    std::atomic<uint64_t> rejected;   // 被拒绝的请求数
+    std::atomic<uint64_t> evictions;  // 淘汰的键数
+  };
+
+  // 查找key所在的槽位，不存在时占用空槽位或淘汰旧键
+  Slot* FindSlot(uint64_t key, uint64_t hash, uint32_t now_ms);
+
+  // 满桶的状态
+  uint64_t FullState(uint32_t now_ms) const;
+
+  uint64_t rate_;                      // 每毫秒补充的千分之一令牌数
+  uint64_t capacity_;                  // 桶容量，千分之一令牌
+  size_t shard_size_;                  // 每个分片的槽位数
+  std::unique_ptr<Slot[]> slots_;      // 所有分片的槽位
+  ShardStats stats_[1 << kShardBits];  // 各分片的统计
+};
+
+// 限速的统计
+struct RateLimitStats {
+  uint64_t limited_by_ip;   // 按IP被拒绝的请求数
+  uint64_t limited_by_key;  // 按API Key被拒绝的请求数
+  uint64_t evictions;       // 两张表淘汰的键数
+};
+
+// 请求限速
+// 每个请求先按客户端IP限速，带X-API-Key请求头时再按API Key限速；
+// IP限速防止伪造大量API Key绕过限制，所以应设置得比单个API Key宽松。
+// 超限的请求回答预序列化的429，带Retry-After。
+// 令牌桶表可以被多个线程同时访问，429响应与静态响应缓存一样
+// 只在事件循环线程中使用。
+class RateLimiter {
+ public:
+  static const int kRetryAfterSeconds = 1;  // 建议客户端重试的间隔
+
+  // per_ip和per_key为两种限速，rate为0的不启用
+  // capacity为每张表最多跟踪的键数量
+  RateLimiter(const RateLimit& per_ip, const RateLimit& per_key,
+              size_t capacity);
+  ~RateLimiter();
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  // 请求是否放行
+  bool Allow(const HttpRequest& request);
+
+  // 获取超限时回答的429响应
+  const PreSerializedResponse* GetRejectResponse();
+
+  // 获取统计信息
+  RateLimitStats GetStats() const;
+
+ private:
+  std::unique_ptr<TokenBucketTable> by_ip_;   // 按IP的令牌桶，未启用时为空
+  std::unique_ptr<TokenBucketTable> by_key_;  // 按API Key的令牌桶，未启用时为空
+  StaticResponseCache reject_cache_;          // 持有预序列化的429，负责刷新Date
+  const PreSerializedResponse* reject_;       // 超限时回答的429
+};
+
+#endif  // RATE_LIMITER_H_
@@ -0,0 +1,135 @@
+// 相同请求的合并实现
+#include "request_coalescer.h"
+
+#include <time.h>
+
+#include "http_response.h"
+
+RequestCoalescer::RequestCoalescer(std::vector<std::string> vary_headers,
+                                   int wait_timeout_ms)
+    : timeout_ns_(static_cast<uint64_t>(wait_timeout_ms) * 1000000),
+      key_builder_(std::move(vary_headers)),
+      last_flight_(nullptr),
+      next_id_(0),
+      stats_() {
+  // 与动态响应一样不带Date，所有超时的请求共享同一块字节
+  HttpResponse response;
+  response.SetStatusCode(HttpStatusCode::k504GatewayTimeout);
+  response.SetHeader("Content-Type", "text/plain");
+  response.SetBody("Gateway Timeout");
+  timeout_wire_ = SharedBuffer::FromString(response.ToString());
+}
+
+RequestCoalescer::~RequestCoalescer() {}
+
+RequestCoalescer::JoinResult RequestCoalescer::Join(
+    const HttpRequest& request) {
+  if (!key_builder_.Build(request, &key_)) {
+    return JoinResult::kBypass;
+  }
+
+  auto it = flights_.find(key_);
+  if (it != flights_.end()) {
+    last_flight_ = &it->second;
+    ++stats_.followers;
+    return JoinResult::kWait;
+  }
+
+  flights_.emplace(key_, std::vector<uint64_t>());
+  ++stats_.leaders;
+  return JoinResult::kLead;
+}
+
+void RequestCoalescer::Wait(Waiter waiter) {
+  // 所有等待者的等待时间相同，按登记顺序就是按超时时刻排列
+  uint64_t id = next_id_++;
+  last_flight_->push_back(id);
+  last_flight_ = nullptr;
+  waiters_.emplace(id, std::move(waiter));
+  deadlines_.push_back({NowNanos() + timeout_ns_, id});
+}
+
+void RequestCoalescer::Complete(const HttpRequest& request,
+                                std::shared_ptr<const SharedBuffer> wire) {
+  if (!key_builder_.Build(request, &key_)) {
+    return;
+  }
+  auto it = flights_.find(key_);
+  if (it == flights_.end()) {
+    return;
+  }
+
+  // 等待者可能立即处理下一个请求并再次登记，先从表中取出
+  std::vector<uint64_t> ids = std::move(it->second);
+  flights_.erase(it);
+  if (!wire) {
+    ++stats_.abandoned;
+  }
+
+  for (uint64_t id : ids) {
+    // 已超时的等待者不在表中
+    auto waiter = waiters_.find(id);
+    if (waiter == waiters_.end()) {
+      continue;
+    }
+    Waiter callback = std::move(waiter->second);
+    waiters_.erase(waiter);
+    callback(wire);
+  }
+}
+
+void RequestCoalescer::Abandon(const HttpRequest& request) {
+  Complete(request, nullptr);
+}
+
+void RequestCoalescer::ExpireWaiters() {
+  if (waiters_.empty()) {
+    deadlines_.clear();
+    return;
+  }
+
+  uint64_t now = NowNanos();
+  while (!deadlines_.empty() && deadlines_.front().time_ns <= now) {
+    uint64_t id = deadlines_.front().id;
+    deadlines_.pop_front();
+
+    // 已完成的等待者不在表中，计算完成时会跳过已超时的编号
+    auto waiter = waiters_.find(id);
+    if (waiter == waiters_.end()) {
+      continue;
+    }
+    Waiter callback = std::move(waiter->second);
+    waiters_.erase(waiter);
+    ++stats_.timeouts;
+    callback(timeout_wire_);
+  }
+}
+
+int RequestCoalescer::GetWaitTimeout() {
+  // 跳过已完成的等待者
+  while (!deadlines_.empty() &&
+         waiters_.find(deadlines_.front().id) == waiters_.end()) {
+    deadlines_.pop_front();
+  }
+  if (deadlines_.empty()) {
+    return -1;
+  }
+
+  // 向上取整到毫秒，避免提前醒来后空转
+  uint64_t now = NowNanos();
+  uint64_t deadline = deadlines_.front().time_ns;
+  if (deadline <= now) {
+    return 0;
+  }
+  return static_cast<int>((deadline - now + 999999) / 1000000);
+}
+
+const CoalescingStats& RequestCoalescer::GetStats() const {
+  return stats_;
+}
+
+uint64_t RequestCoalescer::NowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
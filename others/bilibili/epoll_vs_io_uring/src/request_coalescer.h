@@ -0,0 +1,98 @@
+// 相同请求的合并（single-flight）
+#ifndef REQUEST_COALESCER_H_
+#define REQUEST_COALESCER_H_
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "http_request.h"
+#include "request_key.h"
+#include "shared_buffer.h"
+
+// 请求合并的统计
+struct CoalescingStats {
+  uint64_t leaders;    // 实际执行处理函数的请求数
+  uint64_t followers;  // 合并到进行中的计算、没有执行处理函数的请求数
+  uint64_t timeouts;   // 等待超时、回答504的请求数
+  uint64_t abandoned;  // 计算被放弃、等待者自行处理的次数
+};
+
+// 请求合并
+// 热点键过期时大量相同的请求同时到达，每个都执行同一个昂贵的处理函数。
+// 开启合并的路由在执行异步处理函数之前先在这里登记：同一个键（见
+// RequestKeyBuilder）没有进行中的计算时成为计算者，照常执行；否则成为
+// 等待者，不执行处理函数，计算完成时所有等待者引用同一块响应字节发送。
+// 同步处理函数在事件循环线程中执行完毕，不会并发，不需要合并。
+// 等待超过wait_timeout_ms的请求回答504，不再等待；计算者的连接关闭等原因
+// 放弃计算时，等待者各自重新处理请求，其中一个成为新的计算者。
+// 只在事件循环线程中访问。
+class RequestCoalescer {
+ public:
+  // 登记的结果
+  enum class JoinResult {
+    kLead,    // 成为计算者，完成后必须调用Complete()，放弃时调用Abandon()
+    kWait,    // 已有进行中的计算，调用者应紧接着调用Wait()
+    kBypass   // 请求不可合并，照常处理
+  };
+
+  // 等待者，参数为完整的响应字节，为nullptr表示计算被放弃，应自行处理请求
+  using Waiter = std::function<void(std::shared_ptr<const SharedBuffer>)>;
+
+  // vary_headers为参与合并键的请求头，wait_timeout_ms为等待者最长的等待时间
+  RequestCoalescer(std::vector<std::string> vary_headers, int wait_timeout_ms);
+  ~RequestCoalescer();
+
+  RequestCoalescer(const RequestCoalescer&) = delete;
+  RequestCoalescer& operator=(const RequestCoalescer&) = delete;
+
+  // 登记一个即将执行处理函数的请求
+  JoinResult Join(const HttpRequest& request);
+
+  // Join()返回kWait后登记等待者
+  void Wait(Waiter waiter);
+
+  // 计算者完成，把响应字节交给所有等待者，wire为nullptr时相当于Abandon()
+  void Complete(const HttpRequest& request,
+                std::shared_ptr<const SharedBuffer> wire);
+
+  // 计算者放弃计算，等待者各自重新处理请求
+  void Abandon(const HttpRequest& request);
+
+  // 回答等待超时的请求，由事件循环每轮调用
+  void ExpireWaiters();
+
+  // 距最早的等待超时的毫秒数，作为事件循环的等待时间，没有等待者时返回-1
+  int GetWaitTimeout();
+
+  // 获取统计信息
+  const CoalescingStats& GetStats() const;
+
+ private:
+  // 一个等待者的超时时刻
+  struct Deadline {
+    uint64_t time_ns;  // 超时时刻
+    uint64_t id;       // 等待者编号
+  };
+
+  // 单调时钟，纳秒
+  static uint64_t NowNanos();
+
+  uint64_t timeout_ns_;                                 // 最长等待时间
+  RequestKeyBuilder key_builder_;                       // 合并键的生成器
+  std::string key_;                                     // 合并键，复用内存
+  std::unordered_map<std::string, std::vector<uint64_t>>
+      flights_;                                         // 进行中的计算和等待者编号
+  std::vector<uint64_t>* last_flight_;                  // 最近一次kWait的计算
+  std::unordered_map<uint64_t, Waiter> waiters_;        // 还在等待的等待者
+  std::deque<Deadline> deadlines_;                      // 按超时时刻排列
+  uint64_t next_id_;                                    // 下一个等待者编号
+  std::shared_ptr<const SharedBuffer> timeout_wire_;    // 超时回答的504
+  CoalescingStats stats_;                               // 统计信息
+};
+
+#endif  // REQUEST_COALESCER_H_
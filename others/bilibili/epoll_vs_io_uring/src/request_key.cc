@@ -0,0 +1,49 @@
+// 请求的缓存键实现
+#include "request_key.h"
+
+#include <algorithm>
+
+RequestKeyBuilder::RequestKeyBuilder(std::vector<std::string> vary_headers)
+    : vary_headers_(std::move(vary_headers)) {}
+
+RequestKeyBuilder::~RequestKeyBuilder() {}
+
+bool RequestKeyBuilder::Build(const HttpRequest& request, std::string* key) {
+  // 只有GET请求可以共享响应
+  if (request.GetMethod() != HttpMethod::kGet) {
+    return false;
+  }
+
+  key->assign(request.GetPath());
+
+  // 查询参数按字典序排列
+  const std::string& query = request.GetQuery();
+  if (!query.empty()) {
+    params_.clear();
+    std::string_view rest = query;
+    while (!rest.empty()) {
+      size_t end = rest.find('&');
+      std::string_view param = rest.substr(0, end);
+      if (!param.empty()) {
+        params_.push_back(param);
+      }
+      rest.remove_prefix(end == std::string_view::npos ? rest.size()
+                                                       : end + 1);
+    }
+    std::sort(params_.begin(), params_.end());
+
+    char separator = '?';
+    for (std::string_view param : params_) {
+      key->push_back(separator);
+      key->append(param);
+      separator = '&';
+    }
+  }
+
+  // 选定的请求头，值不同的请求分别处理
+  for (const std::string& name : vary_headers_) {
+    key->push_back('\n');
+    key->append(request.GetHeader(name));
+  }
+  return true;
+}
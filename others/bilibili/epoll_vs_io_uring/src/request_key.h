@@ -0,0 +1,29 @@
+// 请求的缓存键
+#ifndef REQUEST_KEY_H_
+#define REQUEST_KEY_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "http_request.h"
+
+// 请求键的生成器
+// 键由路径、规范化（按参数排序）的查询字符串和选定的请求头组成，
+// 参数顺序不同的同一请求得到相同的键。只有GET请求有键。
+// 响应缓存和请求合并用它判断两个请求是否可以共享同一个响应。
+class RequestKeyBuilder {
+ public:
+  // vary_headers为参与键的请求头，值不同的请求得到不同的键
+  explicit RequestKeyBuilder(std::vector<std::string> vary_headers);
+  ~RequestKeyBuilder();
+
+  // 把请求的键写入*key，请求不可共享响应时返回false
+  bool Build(const HttpRequest& request, std::string* key);
+
+ private:
+  std::vector<std::string> vary_headers_;  // 参与键的请求头
+  std::vector<std::string_view> params_;   // 排序查询参数用的临时数组
+};
+
+#endif  // REQUEST_KEY_H_
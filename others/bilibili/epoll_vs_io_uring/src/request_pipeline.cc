@@ -0,0 +1,376 @@
+// 请求处理流水线实现
+#include "request_pipeline.h"
+
+#include <string.h>
+#include <time.h>
+
+namespace {
+
+// 请求无法解析时回答的400，带Connection: close，所有连接共用；
+// 与其他预序列化响应一样只在事件循环线程中访问
+const PreSerializedResponse* GetBadRequestResponse() {
+  static StaticResponseCache cache;
+  static const PreSerializedResponse* response = [] {
+    HttpResponse bad_request;
+    bad_request.SetStatusCode(HttpStatusCode::k400BadRequest);
+    bad_request.SetHeader("Content-Type", "text/plain");
+    bad_request.SetHeader("Connection", "close");
+    bad_request.SetBody("Bad Request");
+    return cache.Add(bad_request);
+  }();
+  cache.Tick(time(nullptr));
+  return response;
+}
+
+}  // namespace
+
+RequestPipeline::RequestPipeline(CompletionQueue* completions, int fd,
+                                 uint64_t serial,
+                                 RequestCoalescer::Waiter on_coalesced)
+    : completions_(completions),
+      fd_(fd),
+      serial_(serial),
+      on_coalesced_(std::move(on_coalesced)),
+      read_index_(0),
+      input_time_ns_(0),
+      output_(kHighWatermark, kLowWatermark),
+      output_paused_(false),
+      async_pending_(false),
+      admitted_(false),
+      filling_cache_(false),
+      leading_(false),
+      closing_(false),
+      compressor_(nullptr),
+      static_cache_(nullptr),
+      admission_(nullptr),
+      rate_limiter_(nullptr),
+      response_cache_(nullptr),
+      coalescer_(nullptr) {}
+
+RequestPipeline::~RequestPipeline() {
+  // 连接在异步请求完成前关闭，归还并发名额
+  EndAdmittedRequest();
+
+  // 计算者的连接关闭，让等待它的请求自行处理
+  if (leading_) {
+    leading_ = false;
+    coalescer_->Abandon(request_);
+  }
+}
+
+char* RequestPipeline::GetInputSpace() {
+  return read_buffer_ + read_index_;
+}
+
+size_t RequestPipeline::GetInputSpaceSize() const {
+  return kBufferSize - read_index_;
+}
+
+void RequestPipeline::OnInput(size_t n, uint64_t arrival_ns) {
+  read_index_ += n;
+
+  // 只在可以处理请求时读取，缓冲区里的完整请求都已处理，
+  // 剩余数据和新数据一起从本轮事件循环醒来时开始排队
+  input_time_ns_ = arrival_ns;
+
+  // 处理已完整到达的请求
+  ProcessInput();
+}
+
+bool RequestPipeline::IsInputOverflowed() const {
+  return read_index_ == kBufferSize && CanProcessRequests();
+}
+
+const OutputQueue& RequestPipeline::GetOutput() const {
+  return output_;
+}
+
+void RequestPipeline::OnOutputSent(size_t n) {
+  output_.Consume(n);
+
+  // 发送队列降到低水位以下，恢复流式生产者和请求处理
+  if (output_.IsBelowLowWatermark()) {
+    output_paused_ = false;
+    RunProducer();
+    ProcessInput();
+  }
+}
+
+bool RequestPipeline::CanProcessRequests() const {
+  return !producer_ && !output_paused_ && !async_pending_ && !closing_;
+}
+
+bool RequestPipeline::ShouldClose() const {
+  return closing_ && output_.IsEmpty();
+}
+
+void RequestPipeline::OnAsyncComplete(HttpResponse* response) {
+  EndAdmittedRequest();
+  response_ = std::move(*response);
+  FinishResponse();
+
+  // 请求到此处理完毕，继续处理期间到达的流水线请求
+  request_.Reset();
+  async_pending_ = false;
+  ProcessInput();
+}
+
+void RequestPipeline::OnCoalescedResponse(
+    std::shared_ptr<const SharedBuffer> wire) {
+  async_pending_ = false;
+  if (wire) {
+    output_.Append(std::move(wire));
+    if (output_.IsAboveHighWatermark()) {
+      output_paused_ = true;
+    }
+  } else {
+    // 计算被放弃，重新处理这个请求，可能成为新的计算者或再次等待；
+    // 请求已经过限速和准入，只重试响应缓存、合并和处理函数这一步
+    response_.Reset();
+    DispatchRequest(false);
+    if (async_pending_) {
+      return;
+    }
+  }
+
+  request_.Reset();
+  ProcessInput();
+}
+
+void RequestPipeline::SetRequestCallback(const RequestCallback& cb) {
+  request_callback_ = cb;
+}
+
+void RequestPipeline::SetResponseCompressor(ResponseCompressor* compressor) {
+  compressor_ = compressor;
+}
+
+void RequestPipeline::SetStaticResponseCache(StaticResponseCache* cache) {
+  static_cache_ = cache;
+}
+
+void RequestPipeline::SetAdmissionController(AdmissionController* admission) {
+  admission_ = admission;
+}
+
+void RequestPipeline::SetRateLimiter(RateLimiter* limiter) {
+  rate_limiter_ = limiter;
+}
+
+void RequestPipeline::SetResponseCache(ResponseCache* cache) {
+  response_cache_ = cache;
+}
+
+void RequestPipeline::SetRequestCoalescer(RequestCoalescer* coalescer) {
+  coalescer_ = coalescer;
+}
+
+void RequestPipeline::SetRemoteIp(uint32_t ip) {
+  request_.SetRemoteIp(ip);
+}
+
+void RequestPipeline::ProcessInput() {
+  // 读缓冲区中可能有多个流水线请求，逐个处理直到需要暂停
+  while (CanProcessRequests() && read_index_ > 0) {
+    if (!request_.Parse(read_buffer_, read_index_)) {
+      // 解析出错后无法找到下一个请求的边界，只能回答400并关闭
+      if (request_.HasError()) {
+        RejectBadRequest();
+      }
+      break;
+    }
+    HandleRequest();
+
+    // 把下一个请求的数据移到缓冲区开头
+    size_t parsed = request_.GetParsedBytes();
+    memmove(read_buffer_, read_buffer_ + parsed, read_index_ - parsed);
+    read_index_ -= parsed;
+
+    // 异步请求完成前保留请求，压缩阶段还要用到
+    if (async_pending_) {
+      break;
+    }
+
+    // 重置请求，准备处理下一个请求
+    request_.Reset();
+  }
+}
+
+void RequestPipeline::RejectBadRequest() {
+  const PreSerializedResponse* response = GetBadRequestResponse();
+  output_.AppendReference(response->wire.data(), response->wire.size());
+  output_.Append(response->body);
+  closing_ = true;
+  read_index_ = 0;
+  request_.Reset();
+}
+
+void RequestPipeline::HandleRequest() {
+  // 请求解析完成，生成响应
+  response_.Reset();
+
+  // 静态路由在调用处理函数之前回答，条件请求命中时直接回答304
+  const PreSerializedResponse* cached =
+      static_cache_ ? static_cache_->Find(request_) : nullptr;
+
+  if (cached) {
+    response_.SetPreSerialized(cached);
+  } else if (rate_limiter_ && !rate_limiter_->Allow(request_)) {
+    // 客户端超过限速，回答429，不占用并发名额
+    response_.SetPreSerialized(rate_limiter_->GetRejectResponse());
+  } else {
+    DispatchRequest(true);
+    return;
+  }
+
+  FinishResponse();
+}
+
+void RequestPipeline::DispatchRequest(bool admit) {
+  if (response_cache_ && ServeFromResponseCache()) {
+    // 命中响应缓存，不调用处理函数
+    return;
+  }
+
+  if (admit && !AdmitRequest()) {
+    // 过载时直接回答503，不调用处理函数
+    response_.SetPreSerialized(admission_->GetRejectResponse());
+  } else if (request_callback_) {
+    // 调用回调函数处理请求
+    request_callback_(request_, &response_);
+  } else {
+    // 默认响应
+    response_.SetStatusCode(HttpStatusCode::k404NotFound);
+    response_.SetBody("<html><body><h1>404 Not Found</h1></body></html>");
+    response_.SetHeader("Content-Type", "text/html");
+  }
+
+  // 异步响应：处理函数拿到令牌后返回，完成时经完成队列回到事件循环线程
+  if (response_.IsAsync()) {
+    // 开启合并的请求已有相同请求在计算时，不执行处理函数，等待那次的结果
+    if (coalescer_ && response_.IsCoalescing() && JoinInFlight()) {
+      return;
+    }
+    async_pending_ = true;
+    AsyncHandler handler = response_.TakeAsyncHandler();
+    handler(CompletionToken(completions_, fd_, serial_));
+    return;
+  }
+
+  EndAdmittedRequest();
+  FinishResponse();
+}
+
+void RequestPipeline::FinishResponse() {
+  // 压缩阶段
+  if (compressor_) {
+    compressor_->Compress(request_, &response_);
+  }
+
+  // 写入响应缓存或交给等待同一请求的连接时，响应只序列化一次，
+  // 各个连接引用同一块字节发送
+  std::shared_ptr<const SharedBuffer> wire;
+  if (filling_cache_) {
+    filling_cache_ = false;
+    response_cache_->Store(request_, response_, &wire);
+  }
+  if (leading_ && !wire && !response_.IsStreaming()) {
+    wire = SharedBuffer::FromString(response_.ToString());
+  }
+
+  // 预序列化的响应直接引用，其余响应序列化到发送队列
+  if (wire) {
+    output_.Append(wire);
+  } else if (const PreSerializedResponse* pre = response_.GetPreSerialized()) {
+    output_.AppendReference(pre->wire.data(), pre->wire.size());
+    output_.Append(pre->body);
+  } else {
+    response_.SerializeTo(output_.BeginAppend());
+    output_.EndAppend();
+    // 共享响应体不复制，作为单独的段发送
+    output_.Append(response_.GetSharedBody());
+  }
+
+  if (response_.IsStreaming()) {
+    producer_ = response_.TakeStreamProducer();
+    RunProducer();
+  }
+
+  if (output_.IsAboveHighWatermark()) {
+    output_paused_ = true;
+  }
+
+  // 最后通知等待者，它们会接着处理各自连接上的后续请求；
+  // 流式响应无法共享，等待者各自重新处理
+  if (leading_) {
+    leading_ = false;
+    coalescer_->Complete(request_, std::move(wire));
+  }
+}
+
+bool RequestPipeline::ServeFromResponseCache() {
+  std::shared_ptr<const SharedBuffer> wire;
+  if (!response_cache_->Lookup(request_, &wire)) {
+    // 未命中，响应计算完成后写入缓存
+    filling_cache_ = true;
+    return false;
+  }
+
+  output_.Append(std::move(wire));
+  if (output_.IsAboveHighWatermark()) {
+    output_paused_ = true;
+  }
+  return true;
+}
+
+bool RequestPipeline::JoinInFlight() {
+  switch (coalescer_->Join(request_)) {
+    case RequestCoalescer::JoinResult::kLead:
+      leading_ = true;
+      return false;
+    case RequestCoalescer::JoinResult::kBypass:
+      return false;
+    case RequestCoalescer::JoinResult::kWait:
+      break;
+  }
+
+  // 等待期间不占用并发名额，响应由计算者写入缓存
+  EndAdmittedRequest();
+  filling_cache_ = false;
+
+  // 与异步请求一样暂停后续请求，结果经服务器按连接序号送回，
+  // 期间连接关闭或描述符被复用时结果被丢弃
+  async_pending_ = true;
+  coalescer_->Wait(on_coalesced_);
+  return true;
+}
+
+bool RequestPipeline::AdmitRequest() {
+  if (!admission_) {
+    return true;
+  }
+  admitted_ = admission_->BeginRequest(input_time_ns_);
+  return admitted_;
+}
+
+void RequestPipeline::EndAdmittedRequest() {
+  if (admitted_) {
+    admitted_ = false;
+    admission_->EndRequest();
+  }
+}
+
+void RequestPipeline::RunProducer() {
+  ChunkWriter writer(&output_);
+  while (producer_ && !output_.IsAboveHighWatermark()) {
+    if (!producer_(&writer)) {
+      // 生产者结束，写入结束块
+      writer.Finish();
+      producer_ = nullptr;
+    }
+  }
+
+  if (output_.IsAboveHighWatermark()) {
+    output_paused_ = true;
+  }
+}
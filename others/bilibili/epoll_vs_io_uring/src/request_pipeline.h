@@ -0,0 +1,165 @@
+// 连接上的请求处理流水线
+#ifndef REQUEST_PIPELINE_H_
+#define REQUEST_PIPELINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <memory>
+
+#include "admission_controller.h"
+#include "completion_queue.h"
+#include "http_request.h"
+#include "http_response.h"
+#include "output_queue.h"
+#include "rate_limiter.h"
+#include "request_coalescer.h"
+#include "response_cache.h"
+#include "response_compressor.h"
+#include "shared_buffer.h"
+#include "static_response_cache.h"
+
+// 请求处理流水线
+// 一个连接的读缓冲区、发送队列和请求处理状态，epoll和io_uring两种后端
+// 的连接共用。读缓冲区中的流水线请求逐个经过静态响应缓存、限速、
+// 响应缓存、准入控制和处理函数，响应放入发送队列；流式响应、发送队列
+// 超过高水位、异步请求和合并等待期间暂停处理后续请求。
+// 流水线不做I/O：连接把读到的数据交给它，从发送队列取数据发送，并在
+// 每次调用之后按CanProcessRequests()和发送队列决定关注哪些I/O。
+// 只在事件循环线程中访问。
+class RequestPipeline {
+ public:
+  // 回调函数类型定义
+  using RequestCallback =
+      std::function<void(const HttpRequest&, HttpResponse*)>;
+
+  static const size_t kBufferSize = 4096;  // 读缓冲区大小
+
+  // completions、fd和serial用于生成异步请求的完成令牌；
+  // on_coalesced为合并等待的结果送回连接的函数，由连接所属的服务器按
+  // 描述符和序号查找连接，连接已关闭或描述符被复用时丢弃结果
+  RequestPipeline(CompletionQueue* completions, int fd, uint64_t serial,
+                  RequestCoalescer::Waiter on_coalesced);
+  ~RequestPipeline();
+
+  RequestPipeline(const RequestPipeline&) = delete;
+  RequestPipeline& operator=(const RequestPipeline&) = delete;
+
+  // 读缓冲区的空闲空间，读到的数据直接写入这里
+  char* GetInputSpace();
+
+  // 读缓冲区的空闲字节数
+  size_t GetInputSpaceSize() const;
+
+  // 读缓冲区写入了n字节，arrival_ns为数据开始排队的时间，
+  // 处理已完整到达的请求
+  void OnInput(size_t n, uint64_t arrival_ns);
+
+  // 读缓冲区已满仍不是完整请求，请求头过大，无法继续解析
+  bool IsInputOverflowed() const;
+
+  // 获取发送队列
+  const OutputQueue& GetOutput() const;
+
+  // 发送队列中n字节已发送，降到低水位以下时恢复流式生产者和请求处理
+  void OnOutputSent(size_t n);
+
+  // 是否可以处理新请求
+  bool CanProcessRequests() const;
+
+  // 已对无法解析的请求回答400并发送完毕，连接应关闭
+  bool ShouldClose() const;
+
+  // 异步请求完成，发送响应并继续处理后续请求
+  void OnAsyncComplete(HttpResponse* response);
+
+  // 合并等待的请求得到结果，wire为nullptr时计算被放弃，自行处理请求
+  void OnCoalescedResponse(std::shared_ptr<const SharedBuffer> wire);
+
+  // 设置请求回调函数
+  void SetRequestCallback(const RequestCallback& cb);
+
+  // 设置响应压缩器，为nullptr时不压缩
+  void SetResponseCompressor(ResponseCompressor* compressor);
+
+  // 设置静态响应缓存，命中时不调用请求回调函数，为nullptr时不查找
+  void SetStaticResponseCache(StaticResponseCache* cache);
+
+  // 设置准入控制器，为nullptr时不限制
+  void SetAdmissionController(AdmissionController* admission);
+
+  // 设置请求限速，为nullptr时不限速
+  void SetRateLimiter(RateLimiter* limiter);
+
+  // 设置响应缓存，命中时不调用请求回调函数，为nullptr时不查找
+  void SetResponseCache(ResponseCache* cache);
+
+  // 设置请求合并，为nullptr时不合并
+  void SetRequestCoalescer(RequestCoalescer* coalescer);
+
+  // 设置对端的IPv4地址（主机字节序）
+  void SetRemoteIp(uint32_t ip);
+
+ private:
+  static const size_t kHighWatermark = 256 * 1024;  // 发送队列高水位
+  static const size_t kLowWatermark = 64 * 1024;    // 发送队列低水位
+
+  // 处理读缓冲区中已完整到达的请求
+  void ProcessInput();
+
+  // 请求无法解析，回答400后不再读取，发送完毕后由连接关闭
+  void RejectBadRequest();
+
+  // 处理一个请求，把响应放入发送队列；异步响应在完成后再放入
+  void HandleRequest();
+
+  // 静态响应缓存和限速之后的阶段：查找响应缓存、准入检查、合并和
+  // 调用处理函数。admit为false时跳过准入检查，用于合并计算被放弃后
+  // 重新处理已经准入的请求，排队延迟不会把等待合并的时间算进去
+  void DispatchRequest(bool admit);
+
+  // 压缩并序列化response_，放入发送队列
+  void FinishResponse();
+
+  // 查找响应缓存，命中并已回答时返回true
+  bool ServeFromResponseCache();
+
+  // 登记即将执行的异步请求，合并到进行中的相同请求时返回true
+  bool JoinInFlight();
+
+  // 请求交给处理函数之前的准入检查，被拒绝时返回false
+  bool AdmitRequest();
+
+  // 准入的请求处理完成，归还并发名额
+  void EndAdmittedRequest();
+
+  // 驱动流式响应的生产者，直到结束或发送队列达到高水位
+  void RunProducer();
+
+  CompletionQueue* completions_;            // 异步请求的完成队列
+  int fd_;                                  // 连接的套接字描述符
+  uint64_t serial_;                         // 连接序号
+  RequestCoalescer::Waiter on_coalesced_;   // 合并等待的结果送回连接
+  char read_buffer_[kBufferSize];           // 读缓冲区
+  size_t read_index_;                       // 读缓冲区中已读取的数据长度
+  uint64_t input_time_ns_;                  // 读缓冲区中最早的数据读入的时间
+  OutputQueue output_;                      // 发送队列
+  bool output_paused_;                      // 发送队列超过高水位后暂停读取
+  StreamProducer producer_;                 // 正在进行的流式响应
+  bool async_pending_;                      // 是否在等待异步请求完成
+  bool admitted_;                           // 当前请求是否占用了并发名额
+  bool filling_cache_;                      // 当前请求的响应是否要写入响应缓存
+  bool leading_;                            // 当前请求是否为合并请求的计算者
+  bool closing_;                            // 已回答400，发送完毕后关闭连接
+  HttpRequest request_;                     // HTTP请求
+  HttpResponse response_;                   // HTTP响应，跨请求复用
+  RequestCallback request_callback_;        // 请求回调函数
+  ResponseCompressor* compressor_;          // 响应压缩器
+  StaticResponseCache* static_cache_;       // 静态响应缓存
+  AdmissionController* admission_;          // 准入控制器
+  RateLimiter* rate_limiter_;               // 请求限速
+  ResponseCache* response_cache_;           // 响应缓存
+  RequestCoalescer* coalescer_;             // 请求合并
+};
+
+#endif  // REQUEST_PIPELINE_H_
@@ -0,0 +1,272 @@
+// 动态响应的内存缓存实现
+#include "response_cache.h"
+
+#include <time.h>
+#include <charconv>
+
+#include "ascii.h"
+#include "hash.h"
+
+namespace {
+
+// 每项除响应字节外的估计开销：索引节点、键和Entry本身
+const size_t kEntryOverhead = 128;
+
+// 一项占用的字节数
+size_t EntryBytes(const std::string& key, const SharedBuffer& wire) {
+  return key.size() + wire.GetSize() + kEntryOverhead;
+}
+
+}  // namespace
+
+void ResponseCache::Fifo::PushFront(Entry* entry) {
+  entry->prev = nullptr;
+  entry->next = head;
+  if (head) {
+    head->prev = entry;
+  } else {
+    tail = entry;
+  }
+  head = entry;
+  bytes += EntryBytes(entry->key, *entry->wire);
+}
+
+void ResponseCache::Fifo::Remove(Entry* entry) {
+  if (entry->prev) {
+    entry->prev->next = entry->next;
+  } else {
+    head = entry->next;
+  }
+  if (entry->next) {
+    entry->next->prev = entry->prev;
+  } else {
+    tail = entry->prev;
+  }
+  entry->prev = nullptr;
+  entry->next = nullptr;
+  bytes -= EntryBytes(entry->key, *entry->wire);
+}
+
+ResponseCache::ResponseCache(size_t capacity,
+                             std::vector<std::string> vary_headers)
+    : capacity_(capacity),
+      small_capacity_(capacity / 10),
+      key_builder_(std::move(vary_headers)),
+      stats_() {}
+
+ResponseCache::~ResponseCache() {}
+
+bool ResponseCache::Lookup(const HttpRequest& request,
+                           std::shared_ptr<const SharedBuffer>* wire) {
+  if (!key_builder_.Build(request, &key_)) {
+    return false;
+  }
+
+  auto it = entries_.find(key_);
+  if (it != entries_.end()) {
+    Entry* entry = it->second.get();
+    if (entry->expires_ms > NowMillis()) {
+      // 命中只增加计数，不移动位置，淘汰时才根据计数调整
+      if (entry->frequency < 3) {
+        ++entry->frequency;
+      }
+      ++stats_.hits;
+      *wire = entry->wire;
+      return true;
+    }
+    Erase(entry);
+    ++stats_.expirations;
+  }
+
+  ++stats_.misses;
+  return false;
+}
+
+void ResponseCache::Store(const HttpRequest& request,
+                          const HttpResponse& response,
+                          std::shared_ptr<const SharedBuffer>* wire) {
+  // 预序列化的响应带有随时钟刷新的Date，复制一份就会过期，不缓存
+  uint64_t max_age = GetMaxAge(response);
+  if (max_age == 0 || response.IsStreaming() || response.IsAsync() ||
+      response.GetPreSerialized() || !key_builder_.Build(request, &key_)) {
+    return;
+  }
+
+  // 序列化为一整块不可变的缓冲区，命中时直接引用发送
+  if (!*wire) {
+    *wire = SharedBuffer::FromString(response.ToString());
+  }
+  Insert(*wire, max_age * 1000, NowMillis());
+}
+
+const ResponseCacheStats& ResponseCache::GetStats() const {
+  return stats_;
+}
+
+uint64_t ResponseCache::GetMaxAge(const HttpResponse& response) {
+  if (response.GetStatusCode() != HttpStatusCode::k200Ok) {
+    return 0;
+  }
+
+  // 逐个解析逗号分隔的指令，指令名不区分大小写；本缓存是共享缓存，
+  // s-maxage优先于max-age，要求重新验证或不可共享的响应都不缓存
+  std::string_view control = response.GetHeader("Cache-Control");
+  uint64_t max_age = 0;
+  bool has_shared_max_age = false;
+  while (!control.empty()) {
+    size_t comma = control.find(',');
+    std::string_view directive = TrimSpaces(control.substr(0, comma));
+    control = comma == std::string_view::npos ? std::string_view()
+                                              : control.substr(comma + 1);
+
+    size_t equals = directive.find('=');
+    std::string_view name = TrimSpaces(directive.substr(0, equals));
+    std::string_view value =
+        equals == std::string_view::npos
+            ? std::string_view()
+            : TrimSpaces(directive.substr(equals + 1));
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+      value = value.substr(1, value.size() - 2);
+    }
+
+    if (EqualsIgnoreCase(name, "no-store") ||
+        EqualsIgnoreCase(name, "no-cache") ||
+        EqualsIgnoreCase(name, "private")) {
+      return 0;
+    }
+    bool shared = EqualsIgnoreCase(name, "s-maxage");
+    if (shared || (EqualsIgnoreCase(name, "max-age") && !has_shared_max_age)) {
+      uint64_t seconds = 0;
+      auto result =
+          std::from_chars(value.data(), value.data() + value.size(), seconds);
+      if (result.ec != std::errc() ||
+          result.ptr != value.data() + value.size()) {
+        return 0;
+      }
+      max_age = seconds;
+      has_shared_max_age = has_shared_max_age || shared;
+    }
+  }
+  return max_age;
+}
+
+void ResponseCache::Insert(std::shared_ptr<const SharedBuffer> wire,
+                           uint64_t ttl_ms, uint64_t now_ms) {
+  // 同一个键已有响应（计算期间被其他路径写入）时替换
+  auto it = entries_.find(key_);
+  if (it != entries_.end()) {
+    Erase(it->second.get());
+  }
+
+  // 比整个缓存还大的响应不缓存
+  if (EntryBytes(key_, *wire) > capacity_) {
+    return;
+  }
+
+  auto entry = std::make_unique<Entry>();
+  entry->key = key_;
+  entry->wire = std::move(wire);
+  entry->expires_ms = now_ms + ttl_ms;
+  entry->frequency = 0;
+
+  // 刚被淘汰又回来的键说明确实会被重复访问，直接进入主FIFO
+  uint64_t hash = HashBytes(key_.data(), key_.size());
+  if (ghosts_.erase(hash) > 0) {
+    entry->queue = Queue::kMain;
+    main_.PushFront(entry.get());
+  } else {
+    entry->queue = Queue::kSmall;
+    small_.PushFront(entry.get());
+  }
+
+  entries_.emplace(key_, std::move(entry));
+  ++stats_.insertions;
+  ++stats_.entries;
+  stats_.bytes = small_.bytes + main_.bytes;
+
+  EvictUntilFits();
+}
+
+void ResponseCache::EvictUntilFits() {
+  while (small_.bytes + main_.bytes > capacity_) {
+    if (small_.tail && (small_.bytes > small_capacity_ || !main_.tail)) {
+      EvictSmall();
+    } else {
+      EvictMain();
+    }
+  }
+  stats_.bytes = small_.bytes + main_.bytes;
+}
+
+void ResponseCache::EvictSmall() {
+  Entry* entry = small_.tail;
+  uint64_t now = NowMillis();
+
+  if (entry->expires_ms > now && entry->frequency > 0) {
+    // 在小FIFO期间被再次访问，晋升到主FIFO
+    small_.Remove(entry);
+    entry->frequency = 0;
+    entry->queue = Queue::kMain;
+    main_.PushFront(entry);
+    return;
+  }
+
+  if (entry->expires_ms > now) {
+    RememberGhost(entry->key);
+    ++stats_.evictions;
+  } else {
+    ++stats_.expirations;
+  }
+  Erase(entry);
+}
+
+void ResponseCache::EvictMain() {
+  Entry* entry = main_.tail;
+  uint64_t now = NowMillis();
+
+  if (entry->expires_ms > now && entry->frequency > 0) {
+    // 还在被访问，给它第二次机会
+    main_.Remove(entry);
+    --entry->frequency;
+    main_.PushFront(entry);
+    return;
+  }
+
+  if (entry->expires_ms > now) {
+    ++stats_.evictions;
+  } else {
+    ++stats_.expirations;
+  }
+  Erase(entry);
+}
+
+void ResponseCache::Erase(Entry* entry) {
+  if (entry->queue == Queue::kSmall) {
+    small_.Remove(entry);
+  } else {
+    main_.Remove(entry);
+  }
+  --stats_.entries;
+  stats_.bytes = small_.bytes + main_.bytes;
+  // entry属于索引，键也在entry中，按迭代器删除
+  entries_.erase(entries_.find(entry->key));
+}
+
+void ResponseCache::RememberGhost(const std::string& key) {
+  uint64_t hash = HashBytes(key.data(), key.size());
+  if (ghosts_.insert(hash).second) {
+    ghost_fifo_.push_back(hash);
+  }
+
+  // 幽灵队列的长度与缓存的响应数相当
+  while (ghost_fifo_.size() > entries_.size()) {
+    ghosts_.erase(ghost_fifo_.front());
+    ghost_fifo_.pop_front();
+  }
+}
+
+uint64_t ResponseCache::NowMillis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
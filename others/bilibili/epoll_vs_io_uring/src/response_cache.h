@@ -0,0 +1,124 @@
+// 动态响应的内存缓存
+#ifndef RESPONSE_CACHE_H_
+#define RESPONSE_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "http_request.h"
+#include "http_response.h"
+#include "request_key.h"
+#include "shared_buffer.h"
+
+// 响应缓存的统计
+struct ResponseCacheStats {
+  uint64_t hits;         // 命中次数
+  uint64_t misses;       // 未命中次数
+  uint64_t insertions;   // 写入的响应数
+  uint64_t evictions;    // 因容量淘汰的响应数
+  uint64_t expirations;  // 过期删除的响应数
+  size_t entries;        // 当前缓存的响应数
+  size_t bytes;          // 当前占用的字节数
+};
+
+// 响应缓存
+// 缓存请求回调生成的响应，命中时直接发送保存的完整响应字节，不再调用处理函数。
+// 只缓存GET请求，键见RequestKeyBuilder。
+// 只缓存带"Cache-Control: max-age=N"且没有no-store/private的200响应，
+// 有效期为N秒，过期的响应在下次访问或淘汰时删除。
+// 容量按字节计算，用S3-FIFO淘汰：新响应先进入小FIFO，被再次访问过的才
+// 晋升到主FIFO，只访问一次的响应很快被淘汰，不会冲掉热点；刚被淘汰又
+// 回来的键（记录在幽灵队列中）直接进入主FIFO。
+// 未命中的同一个键的并发请求仍会各自计算，需要合并时使用RequestCoalescer。
+// 缓存只在事件循环线程中访问，读写都不加锁。
+class ResponseCache {
+ public:
+  // capacity为最多占用的字节数，vary_headers为参与缓存键的请求头
+  ResponseCache(size_t capacity, std::vector<std::string> vary_headers);
+  ~ResponseCache();
+
+  ResponseCache(const ResponseCache&) = delete;
+  ResponseCache& operator=(const ResponseCache&) = delete;
+
+  // 查找请求对应的响应，命中时输出到*wire并返回true
+  bool Lookup(const HttpRequest& request,
+              std::shared_ptr<const SharedBuffer>* wire);
+
+  // 保存未命中的请求计算出的响应，不可缓存的响应直接忽略
+  // *wire为响应序列化后的完整字节，为空时由缓存序列化并输出到*wire
+  void Store(const HttpRequest& request, const HttpResponse& response,
+             std::shared_ptr<const SharedBuffer>* wire);
+
+  // 获取统计信息
+  const ResponseCacheStats& GetStats() const;
+
+ private:
+  // S3-FIFO的队列
+  enum class Queue { kSmall, kMain };
+
+  // 一个缓存的响应
+  struct Entry {
+    std::string key;                           // 缓存键
+    std::shared_ptr<const SharedBuffer> wire;  // 完整的响应字节
+    uint64_t expires_ms;                       // 过期时刻
+    uint8_t frequency;                         // 访问次数，最多为3
+    Queue queue;                               // 所在的队列
+    Entry* prev;                               // 队列中较新的一项
+    Entry* next;                               // 队列中较旧的一项
+  };
+
+  // 侵入式的FIFO队列，新项在头部，淘汰从尾部开始
+  struct Fifo {
+    Entry* head = nullptr;  // 最新的一项
+    Entry* tail = nullptr;  // 最旧的一项
+    size_t bytes = 0;       // 队列中响应的总字节数
+
+    void PushFront(Entry* entry);
+    void Remove(Entry* entry);
+  };
+
+  // 从响应头中解析有效期（秒），不可缓存时返回0
+  static uint64_t GetMaxAge(const HttpResponse& response);
+
+  // 插入新响应，必要时淘汰旧响应
+  void Insert(std::shared_ptr<const SharedBuffer> wire, uint64_t ttl_ms,
+              uint64_t now_ms);
+
+  // 淘汰响应直到总字节数不超过容量
+  void EvictUntilFits();
+
+  // 淘汰小FIFO尾部的一项：访问过的晋升到主FIFO，否则删除并记入幽灵队列
+  void EvictSmall();
+
+  // 淘汰主FIFO尾部的一项：访问过的降低计数后重新放回头部，否则删除
+  void EvictMain();
+
+  // 从队列和索引中删除一项
+  void Erase(Entry* entry);
+
+  // 记录被淘汰的键，幽灵队列只保存键的哈希
+  void RememberGhost(const std::string& key);
+
+  // 单调时钟，毫秒
+  static uint64_t NowMillis();
+
+  size_t capacity_;                        // 最多占用的字节数
+  size_t small_capacity_;                  // 小FIFO的字节数上限
+  RequestKeyBuilder key_builder_;          // 缓存键的生成器
+  std::unordered_map<std::string, std::unique_ptr<Entry>>
+      entries_;                            // 缓存键到响应的索引
+  Fifo small_;                             // 新进入的响应
+  Fifo main_;                              // 被再次访问过的响应
+  std::deque<uint64_t> ghost_fifo_;        // 幽灵队列，按淘汰顺序
+  std::unordered_set<uint64_t> ghosts_;    // 幽灵队列中的键哈希
+  std::string key_;                        // 缓存键，复用内存
+  ResponseCacheStats stats_;               // 统计信息
+};
+
+#endif  // RESPONSE_CACHE_H_
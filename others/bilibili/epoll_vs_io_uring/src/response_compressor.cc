@@ -0,0 +1,295 @@
+// 响应压缩实现
+#include "response_compressor.h"
+
+#include <time.h>
+#include <zlib.h>
+
+#include "ascii.h"
+
+namespace {
+
+// zlib的窗口参数：15为deflate(zlib格式)，加16输出gzip格式
+const int kWindowBits = 15;
+const int kGzipWindowBits = kWindowBits + 16;
+const int kMemLevel = 8;
+
+// 每线程复用的zlib压缩状态，线程退出时释放
+class ThreadDeflater {
+ public:
+  ThreadDeflater() {
+    gzip_ok_ = InitStream(&gzip_, kGzipWindowBits);
+    deflate_ok_ = InitStream(&deflate_, kWindowBits);
+  }
+
+  ~ThreadDeflater() {
+    if (gzip_ok_) {
+      deflateEnd(&gzip_);
+    }
+    if (deflate_ok_) {
+      deflateEnd(&deflate_);
+    }
+  }
+
+  // 获取对应编码的压缩流，已重置为初始状态
+  z_stream* Get(ContentEncoding encoding) {
+    z_stream* stream = nullptr;
+    if (encoding == ContentEncoding::kGzip && gzip_ok_) {
+      stream = &gzip_;
+    } else if (encoding == ContentEncoding::kDeflate && deflate_ok_) {
+      stream = &deflate_;
+    }
+    if (stream) {
+      deflateReset(stream);
+    }
+    return stream;
+  }
+
+ private:
+  static bool InitStream(z_stream* stream, int window_bits) {
+    stream->zalloc = Z_NULL;
+    stream->zfree = Z_NULL;
+    stream->opaque = Z_NULL;
+    return deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                        window_bits, kMemLevel, Z_DEFAULT_STRATEGY) == Z_OK;
+  }
+
+  z_stream gzip_;
+  z_stream deflate_;
+  bool gzip_ok_;
+  bool deflate_ok_;
+};
+
+thread_local ThreadDeflater t_deflater;
+
+bool StartsWith(std::string_view s, std::string_view prefix) {
+  return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+// 当前线程消耗的CPU时间
+uint64_t ThreadCpuNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+}  // namespace
+
+ResponseCompressor::ResponseCompressor(size_t min_size, size_t cache_capacity)
+    : min_size_(min_size), cache_capacity_(cache_capacity), cache_size_(0) {}
+
+ResponseCompressor::~ResponseCompressor() {}
+
+ContentEncoding ResponseCompressor::Negotiate(
+    std::string_view accept_encoding) {
+  bool gzip = false;
+  bool deflate = false;
+
+  // 逐个解析 "gzip;q=0.8, deflate" 形式的编码列表，q=0表示拒绝
+  while (!accept_encoding.empty()) {
+    size_t comma = accept_encoding.find(',');
+    std::string_view item = accept_encoding.substr(0, comma);
+    accept_encoding.remove_prefix(
+        comma == std::string_view::npos ? accept_encoding.size() : comma + 1);
+
+    size_t semicolon = item.find(';');
+    std::string_view coding = TrimSpaces(item.substr(0, semicolon));
+    bool accepted = true;
+    if (semicolon != std::string_view::npos) {
+      std::string_view param = TrimSpaces(item.substr(semicolon + 1));
+      if (StartsWith(param, "q=")) {
+        param.remove_prefix(2);
+        // q值只需要区分是否为0
+        accepted = false;
+        for (char c : param) {
+          if (c >= '1' && c <= '9') {
+            accepted = true;
+            break;
+          }
+        }
+      }
+    }
+    if (!accepted) {
+      continue;
+    }
+
+    if (EqualsIgnoreCase(coding, "gzip") || EqualsIgnoreCase(coding, "*")) {
+      gzip = true;
+    } else if (EqualsIgnoreCase(coding, "deflate")) {
+      deflate = true;
+    }
+  }
+
+  if (gzip) {
+    return ContentEncoding::kGzip;
+  }
+  if (deflate) {
+    return ContentEncoding::kDeflate;
+  }
+  return ContentEncoding::kIdentity;
+}
+
+void ResponseCompressor::Compress(const HttpRequest& request,
+                                  HttpResponse* response) {
+  if (!ShouldCompress(*response)) {
+    return;
+  }
+
+  const auto& shared_body = response->GetSharedBody();
+  size_t body_size =
+      shared_body ? shared_body->GetSize() : response->GetBody().size();
+  ContentEncoding encoding = Negotiate(request.GetHeader("Accept-Encoding"));
+  if (encoding == ContentEncoding::kIdentity) {
+    return;
+  }
+
+  if (shared_body) {
+    // 不可变的共享响应体，使用缓存的压缩变体
+    auto variant = GetCompressedVariant(encoding, shared_body);
+    if (!variant) {
+      return;
+    }
+    stats_.bytes_in += body_size;
+    stats_.bytes_out += variant->GetSize();
+    response->SetBody(std::move(variant));
+  } else {
+    // 动态响应体，即时压缩
+    uint64_t cpu_begin = ThreadCpuNanos();
+    bool ok = Deflate(encoding, response->GetBody().data(), body_size,
+                      &scratch_);
+    stats_.cpu_ns += ThreadCpuNanos() - cpu_begin;
+    if (!ok || scratch_.size() >= body_size) {
+      return;  // 压缩失败或没有收益，发送原文
+    }
+    stats_.bytes_in += body_size;
+    stats_.bytes_out += scratch_.size();
+    response->SwapBody(&scratch_);
+  }
+
+  ++stats_.compressed_responses;
+  response->SetHeader("Content-Encoding", GetEncodingName(encoding));
+  response->SetHeader("Vary", "Accept-Encoding");
+}
+
+std::shared_ptr<const SharedBuffer> ResponseCompressor::Precompress(
+    ContentEncoding encoding, const HttpResponse& response) {
+  if (encoding == ContentEncoding::kIdentity || !ShouldCompress(response)) {
+    return nullptr;
+  }
+
+  // 普通响应体转为共享缓冲区，同样按内容哈希进入压缩变体缓存
+  std::shared_ptr<const SharedBuffer> body = response.GetSharedBody();
+  if (!body) {
+    body = SharedBuffer::FromString(response.GetBody());
+  }
+  return GetCompressedVariant(encoding, body);
+}
+
+std::string_view ResponseCompressor::GetEncodingName(
+    ContentEncoding encoding) {
+  switch (encoding) {
+    case ContentEncoding::kGzip:
+      return "gzip";
+    case ContentEncoding::kDeflate:
+      return "deflate";
+    case ContentEncoding::kIdentity:
+      break;
+  }
+  return "identity";
+}
+
+const CompressionStats& ResponseCompressor::GetStats() const {
+  return stats_;
+}
+
+bool ResponseCompressor::IsCompressible(std::string_view content_type) {
+  return StartsWith(content_type, "text/") ||
+         StartsWith(content_type, "application/json") ||
+         StartsWith(content_type, "application/javascript") ||
+         StartsWith(content_type, "application/xml") ||
+         StartsWith(content_type, "image/svg+xml");
+}
+
+bool ResponseCompressor::ShouldCompress(const HttpResponse& response) const {
+  // 预序列化的响应、流式响应和已经编码过的响应保持原样
+  if (response.GetPreSerialized() || response.IsStreaming() ||
+      response.GetStatusCode() != HttpStatusCode::k200Ok ||
+      !response.GetHeader("Content-Encoding").empty() ||
+      !IsCompressible(response.GetHeader("Content-Type"))) {
+    return false;
+  }
+
+  const auto& shared_body = response.GetSharedBody();
+  size_t body_size =
+      shared_body ? shared_body->GetSize() : response.GetBody().size();
+  return body_size >= min_size_;
+}
+
+bool ResponseCompressor::Deflate(ContentEncoding encoding,
+                                 const char* data,
+                                 size_t size,
+                                 std::string* out) {
+  z_stream* stream = t_deflater.Get(encoding);
+  if (!stream) {
+    return false;
+  }
+
+  out->resize(deflateBound(stream, size));
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream->avail_in = size;
+  stream->next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+  stream->avail_out = out->size();
+
+  // 输出缓冲区按deflateBound分配，一次Z_FINISH即可完成
+  if (deflate(stream, Z_FINISH) != Z_STREAM_END) {
+    out->clear();
+    return false;
+  }
+  out->resize(stream->total_out);
+  return true;
+}
+
+std::shared_ptr<const SharedBuffer> ResponseCompressor::GetCompressedVariant(
+    ContentEncoding encoding,
+    const std::shared_ptr<const SharedBuffer>& body) {
+  uint64_t key = body->GetHash() ^ static_cast<uint64_t>(encoding);
+  auto it = cache_.find(key);
+  if (it != cache_.end() && it->second.original_size == body->GetSize()) {
+    ++stats_.cache_hits;
+    return it->second.buffer;
+  }
+
+  ++stats_.cache_misses;
+  std::string compressed;
+  uint64_t cpu_begin = ThreadCpuNanos();
+  bool ok = Deflate(encoding, body->GetData(), body->GetSize(), &compressed);
+  stats_.cpu_ns += ThreadCpuNanos() - cpu_begin;
+  if (!ok || compressed.size() >= body->GetSize()) {
+    return nullptr;
+  }
+
+  auto buffer = SharedBuffer::FromString(std::move(compressed));
+  if (buffer->GetSize() <= cache_capacity_) {
+    if (it != cache_.end()) {
+      // 哈希冲突，替换旧条目
+      cache_size_ -= it->second.buffer->GetSize();
+      it->second = CacheEntry{body->GetSize(), buffer};
+    } else {
+      cache_.emplace(key, CacheEntry{body->GetSize(), buffer});
+      cache_order_.push_back(key);
+    }
+    cache_size_ += buffer->GetSize();
+    Evict();
+  }
+  return buffer;
+}
+
+void ResponseCompressor::Evict() {
+  while (cache_size_ > cache_capacity_ && !cache_order_.empty()) {
+    auto it = cache_.find(cache_order_.front());
+    cache_order_.pop_front();
+    if (it != cache_.end()) {
+      cache_size_ -= it->second.buffer->GetSize();
+      cache_.erase(it);
+    }
+  }
+}
@@ -0,0 +1,98 @@
+// 响应压缩
+#ifndef RESPONSE_COMPRESSOR_H_
+#define RESPONSE_COMPRESSOR_H_
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "http_request.h"
+#include "http_response.h"
+#include "shared_buffer.h"
+
+// 内容编码
+enum class ContentEncoding { kIdentity, kGzip, kDeflate };
+
+// 内容编码的种数，可用作按编码索引的数组长度
+const int kNumContentEncodings = 3;
+
+// 压缩统计
+struct CompressionStats {
+  uint64_t compressed_responses = 0;  // 压缩过的响应数（含缓存命中）
+  uint64_t bytes_in = 0;              // 压缩前的字节数
+  uint64_t bytes_out = 0;             // 压缩后的字节数
+  uint64_t cpu_ns = 0;                // 压缩消耗的线程CPU时间
+  uint64_t cache_hits = 0;            // 压缩变体缓存命中次数
+  uint64_t cache_misses = 0;          // 压缩变体缓存未命中次数
+};
+
+// 响应压缩阶段
+// 根据Accept-Encoding协商gzip/deflate，对超过阈值的可压缩响应体进行压缩。
+// 普通响应体使用每线程复用的zlib状态即时压缩；共享响应体内容不可变，
+// 压缩结果按内容哈希缓存，热点响应只压缩一次。静态路由的响应在注册时
+// 经Precompress()预先压缩，内容相同的路由共用缓存中的同一份压缩结果。
+// 压缩变体缓存和统计只在事件循环线程中访问。
+class ResponseCompressor {
+ public:
+  // min_size: 小于该长度的响应体不压缩
+  // cache_capacity: 压缩变体缓存的字节上限
+  ResponseCompressor(size_t min_size, size_t cache_capacity);
+  ~ResponseCompressor();
+
+  // 根据Accept-Encoding选择编码，优先gzip
+  static ContentEncoding Negotiate(std::string_view accept_encoding);
+
+  // 压缩响应，不满足条件时保持原样
+  void Compress(const HttpRequest& request, HttpResponse* response);
+
+  // 为静态响应预先生成encoding编码的响应体，不满足压缩条件或压缩
+  // 没有收益时返回nullptr
+  std::shared_ptr<const SharedBuffer> Precompress(
+      ContentEncoding encoding, const HttpResponse& response);
+
+  // 获取编码在Content-Encoding中的名称
+  static std::string_view GetEncodingName(ContentEncoding encoding);
+
+  // 获取统计数据
+  const CompressionStats& GetStats() const;
+
+ private:
+  // 压缩变体缓存的条目
+  struct CacheEntry {
+    size_t original_size;                        // 原始内容长度，防止哈希冲突
+    std::shared_ptr<const SharedBuffer> buffer;  // 压缩后的内容
+  };
+
+  // 判断Content-Type是否值得压缩
+  static bool IsCompressible(std::string_view content_type);
+
+  // 判断响应是否满足压缩条件，不考虑客户端接受的编码
+  bool ShouldCompress(const HttpResponse& response) const;
+
+  // 使用当前线程的zlib状态压缩数据
+  static bool Deflate(ContentEncoding encoding,
+                      const char* data,
+                      size_t size,
+                      std::string* out);
+
+  // 获取共享响应体的压缩变体，必要时压缩并放入缓存
+  std::shared_ptr<const SharedBuffer> GetCompressedVariant(
+      ContentEncoding encoding,
+      const std::shared_ptr<const SharedBuffer>& body);
+
+  // 淘汰最早放入的条目，直到缓存大小不超过上限
+  void Evict();
+
+  size_t min_size_;                                 // 压缩阈值
+  size_t cache_capacity_;                           // 缓存字节上限
+  size_t cache_size_;                               // 缓存当前字节数
+  std::unordered_map<uint64_t, CacheEntry> cache_;  // 压缩变体缓存
+  std::deque<uint64_t> cache_order_;                // 放入顺序，用于淘汰
+  std::string scratch_;                             // 即时压缩的输出缓冲区
+  CompressionStats stats_;                          // 统计数据
+};
+
+#endif  // RESPONSE_COMPRESSOR_H_
@@ -0,0 +1,250 @@
+// 基于压缩前缀树的请求路由实现
+#include "router.h"
+
+#include <algorithm>
+
+// 前缀树节点
+struct Router::Node {
+  std::string prefix;                           // 压缩的静态前缀
+  std::string indices;                          // 静态子节点前缀的首字符
+  std::vector<std::unique_ptr<Node>> children;  // 静态子节点，与indices对应
+  std::unique_ptr<Node> param_child;            // ":name"参数子节点
+  std::string param_name;                       // 参数名
+  std::unique_ptr<Node> wildcard_child;         // "*name"通配子节点
+  std::string wildcard_name;                    // 通配参数名
+  Route routes[kMethodCount];                   // 按方法区分的路由
+
+  // 获取方法对应的路由，没有时返回nullptr
+  const Route* Find(HttpMethod method) const {
+    int index = static_cast<int>(method);
+    if (index >= kMethodCount || !routes[index].handler) {
+      return nullptr;
+    }
+    return &routes[index];
+  }
+
+  // 该节点是否有任意方法的处理函数
+  bool HasHandler() const {
+    for (const auto& route : routes) {
+      if (route.handler) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+RouteParams::RouteParams() : count_(0) {}
+
+std::string_view RouteParams::Get(std::string_view name) const {
+  for (int i = 0; i < count_; ++i) {
+    if (names_[i] == name) {
+      return values_[i];
+    }
+  }
+  return std::string_view();
+}
+
+int RouteParams::GetCount() const {
+  return count_;
+}
+
+Router::Router() : root_(std::make_unique<Node>()) {}
+
+Router::~Router() {}
+
+bool Router::AddRoute(HttpMethod method, std::string_view pattern,
+                      RouteHandler handler, const RouteOptions& options) {
+  if (method == HttpMethod::kUnknown || pattern.empty() ||
+      pattern[0] != '/' || !handler) {
+    return false;
+  }
+
+  Node* node = root_.get();
+  int param_count = 0;
+  while (!pattern.empty()) {
+    // 静态文本一直延续到下一个参数段或通配段
+    size_t special = pattern.find_first_of(":*");
+    if (special != 0) {
+      node = InsertStatic(node, pattern.substr(0, special));
+      if (special == std::string_view::npos) {
+        break;
+      }
+      pattern.remove_prefix(special);
+    }
+
+    // 参数段和通配段必须占据完整的路径段
+    if (node->prefix.empty() || node->prefix.back() != '/') {
+      return false;
+    }
+    if (++param_count > RouteParams::kMaxParams) {
+      return false;
+    }
+
+    size_t end = pattern.find('/');
+    std::string_view name = pattern.substr(1, end == std::string_view::npos
+                                                  ? std::string_view::npos
+                                                  : end - 1);
+    if (name.empty() || name.find_first_of(":*") != std::string_view::npos) {
+      return false;
+    }
+
+    if (pattern[0] == '*') {
+      // 通配段必须是模式的最后一段
+      if (end != std::string_view::npos) {
+        return false;
+      }
+      if (!node->wildcard_child) {
+        node->wildcard_child = std::make_unique<Node>();
+        node->wildcard_name = std::string(name);
+      } else if (node->wildcard_name != name) {
+        return false;
+      }
+      node = node->wildcard_child.get();
+      break;
+    }
+
+    // 同一位置的参数段必须同名
+    if (!node->param_child) {
+      node->param_child = std::make_unique<Node>();
+      node->param_name = std::string(name);
+    } else if (node->param_name != name) {
+      return false;
+    }
+    node = node->param_child.get();
+    pattern.remove_prefix(end == std::string_view::npos ? pattern.size()
+                                                        : end);
+  }
+
+  Route& slot = node->routes[static_cast<int>(method)];
+  if (slot.handler) {
+    return false;
+  }
+  slot.handler = std::move(handler);
+  slot.options = options;
+  return true;
+}
+
+const RouteHandler* Router::Match(HttpMethod method, std::string_view path,
+                                  RouteParams* params,
+                                  bool* path_found) const {
+  params->count_ = 0;
+  bool found = false;
+  const Route* route = MatchNode(root_.get(), method, path, params, &found);
+  if (path_found) {
+    *path_found = found;
+  }
+  return route ? &route->handler : nullptr;
+}
+
+bool Router::Dispatch(const HttpRequest& request,
+                      HttpResponse* response) const {
+  RouteParams params;
+  bool path_found = false;
+  const Route* route = MatchNode(root_.get(), request.GetMethod(),
+                                 request.GetPath(), &params, &path_found);
+  if (route) {
+    route->handler(request, params, response);
+    if (route->options.coalesce) {
+      response->EnableCoalescing();
+    }
+    return true;
+  }
+  if (!path_found) {
+    return false;
+  }
+
+  response->SetStatusCode(HttpStatusCode::k405MethodNotAllowed);
+  response->SetHeader("Content-Type", "text/plain");
+  response->SetBody("Method Not Allowed");
+  return true;
+}
+
+Router::Node* Router::InsertStatic(Node* node, std::string_view text) {
+  while (!text.empty()) {
+    size_t index = node->indices.find(text[0]);
+    if (index == std::string::npos) {
+      // 没有相同首字符的子节点，整段文本作为新的子节点
+      node->indices.push_back(text[0]);
+      node->children.push_back(std::make_unique<Node>());
+      node->children.back()->prefix = std::string(text);
+      return node->children.back().get();
+    }
+
+    Node* child = node->children[index].get();
+    size_t common = std::mismatch(child->prefix.begin(), child->prefix.end(),
+                                  text.begin(), text.end())
+                        .first -
+                    child->prefix.begin();
+
+    if (common < child->prefix.size()) {
+      // 只有部分前缀相同，在公共前缀处拆分子节点
+      auto split = std::make_unique<Node>();
+      split->prefix = child->prefix.substr(0, common);
+      child->prefix.erase(0, common);
+      split->indices.push_back(child->prefix[0]);
+      split->children.push_back(std::move(node->children[index]));
+      node->children[index] = std::move(split);
+      child = node->children[index].get();
+    }
+
+    node = child;
+    text.remove_prefix(common);
+  }
+  return node;
+}
+
+const Router::Route* Router::MatchNode(const Node* node, HttpMethod method,
+                                       std::string_view path,
+                                       RouteParams* params,
+                                       bool* path_found) {
+  if (path.empty()) {
+    if (node->HasHandler()) {
+      *path_found = true;
+      if (const Route* route = node->Find(method)) {
+        return route;
+      }
+    }
+  } else {
+    // 静态子节点优先，按首字符直接定位
+    size_t index = node->indices.find(path[0]);
+    if (index != std::string::npos) {
+      const Node* child = node->children[index].get();
+      if (path.compare(0, child->prefix.size(), child->prefix) == 0) {
+        const Route* route =
+            MatchNode(child, method, path.substr(child->prefix.size()),
+                      params, path_found);
+        if (route) {
+          return route;
+        }
+      }
+    }
+
+    // 参数段匹配到下一个'/'为止，不能为空
+    if (node->param_child && path[0] != '/') {
+      size_t end = std::min(path.find('/'), path.size());
+      int slot = params->count_++;
+      params->names_[slot] = node->param_name;
+      params->values_[slot] = path.substr(0, end);
+      const Route* route = MatchNode(
+          node->param_child.get(), method, path.substr(end), params,
+          path_found);
+      if (route) {
+        return route;
+      }
+      params->count_ = slot;
+    }
+  }
+
+  // 通配段匹配剩余的全部路径，可以为空
+  if (node->wildcard_child && node->wildcard_child->HasHandler()) {
+    *path_found = true;
+    if (const Route* route = node->wildcard_child->Find(method)) {
+      int slot = params->count_++;
+      params->names_[slot] = node->wildcard_name;
+      params->values_[slot] = path;
+      return route;
+    }
+  }
+  return nullptr;
+}
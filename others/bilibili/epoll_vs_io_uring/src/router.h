@@ -0,0 +1,95 @@
+// 基于压缩前缀树的请求路由
+#ifndef ROUTER_H_
+#define ROUTER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "http_request.h"
+#include "http_response.h"
+
+// 路由匹配得到的路径参数，名字和值都指向路由表和请求路径，不复制
+class RouteParams {
+ public:
+  static const int kMaxParams = 8;  // 单个路由最多的参数个数
+
+  RouteParams();
+
+  // 按名字获取参数，不存在时返回空
+  std::string_view Get(std::string_view name) const;
+
+  // 参数个数
+  int GetCount() const;
+
+ private:
+  friend class Router;
+
+  std::string_view names_[kMaxParams];   // 参数名
+  std::string_view values_[kMaxParams];  // 参数值
+  int count_;                            // 参数个数
+};
+
+// 路由处理函数
+using RouteHandler = std::function<void(
+    const HttpRequest&, const RouteParams&, HttpResponse*)>;
+
+// 路由选项
+struct RouteOptions {
+  // 合并相同的并发请求，只对异步处理函数生效，见RequestCoalescer
+  bool coalesce = false;
+};
+
+// 请求路由
+// 路由模式由静态文本、":name"参数段和结尾的"*name"通配段组成，例如
+// "/users/:id/posts"和"/files/*path"。静态文本按字符存放在压缩前缀树中，
+// 匹配时每个节点按首字符选择子节点，查找开销只与路径长度有关，与路由数量无关。
+// 同一位置静态文本优先于参数段，参数段优先于通配段。
+// 路由表在启动时构建，之后只读。
+class Router {
+ public:
+  Router();
+  ~Router();
+
+  Router(const Router&) = delete;
+  Router& operator=(const Router&) = delete;
+
+  // 添加路由，模式不合法或与已有路由冲突时返回false
+  bool AddRoute(HttpMethod method, std::string_view pattern,
+                RouteHandler handler,
+                const RouteOptions& options = RouteOptions());
+
+  // 匹配请求方法和路径，返回处理函数，未匹配时返回nullptr
+  // path_found非空时输出路径是否存在（用于区分404和405）
+  const RouteHandler* Match(HttpMethod method, std::string_view path,
+                            RouteParams* params,
+                            bool* path_found = nullptr) const;
+
+  // 分发请求，路径存在但方法不匹配时回答405，路径不存在时返回false
+  bool Dispatch(const HttpRequest& request, HttpResponse* response) const;
+
+ private:
+  static const int kMethodCount = static_cast<int>(HttpMethod::kUnknown);
+
+  // 一个方法的路由
+  struct Route {
+    RouteHandler handler;  // 处理函数
+    RouteOptions options;  // 路由选项
+  };
+
+  struct Node;
+
+  // 在node下插入静态文本，返回文本结束处的节点
+  static Node* InsertStatic(Node* node, std::string_view text);
+
+  // 从node开始匹配剩余路径，node自身的前缀已经匹配
+  static const Route* MatchNode(const Node* node, HttpMethod method,
+                                std::string_view path, RouteParams* params,
+                                bool* path_found);
+
+  std::unique_ptr<Node> root_;  // 根节点，前缀为空
+};
+
+#endif  // ROUTER_H_
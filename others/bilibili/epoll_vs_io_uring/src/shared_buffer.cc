@@ -0,0 +1,78 @@
+// 引用计数的不可变缓冲区实现
+#include "shared_buffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+
+SharedBuffer::SharedBuffer()
+    : mapping_(nullptr), data_(nullptr), size_(0), hash_(0), modified_(0) {}
+
+SharedBuffer::~SharedBuffer() {
+  if (mapping_) {
+    munmap(mapping_, size_);
+  }
+}
+
+std::shared_ptr<const SharedBuffer> SharedBuffer::FromString(
+    std::string data) {
+  std::shared_ptr<SharedBuffer> buffer(new SharedBuffer());
+  buffer->storage_ = std::move(data);
+  buffer->data_ = buffer->storage_.data();
+  buffer->size_ = buffer->storage_.size();
+  buffer->hash_ = HashBytes(buffer->data_, buffer->size_);
+  buffer->modified_ = time(nullptr);
+  return buffer;
+}
+
+std::shared_ptr<const SharedBuffer> SharedBuffer::MapFile(
+    const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  // 空文件无法映射，退化为空缓冲区
+  void* mapping = nullptr;
+  if (st.st_size > 0) {
+    mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+
+  std::shared_ptr<SharedBuffer> buffer(new SharedBuffer());
+  buffer->mapping_ = mapping;
+  buffer->data_ = mapping ? static_cast<const char*>(mapping)
+                          : buffer->storage_.data();
+  buffer->size_ = st.st_size;
+  buffer->hash_ = HashBytes(buffer->data_, buffer->size_);
+  buffer->modified_ = st.st_mtime;
+  return buffer;
+}
+
+const char* SharedBuffer::GetData() const {
+  return data_;
+}
+
+size_t SharedBuffer::GetSize() const {
+  return size_;
+}
+
+uint64_t SharedBuffer::GetHash() const {
+  return hash_;
+}
+
+time_t SharedBuffer::GetModifiedTime() const {
+  return modified_;
+}
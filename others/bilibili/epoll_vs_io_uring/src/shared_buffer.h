@@ -0,0 +1,49 @@
+// 引用计数的不可变缓冲区
+#ifndef SHARED_BUFFER_H_
+#define SHARED_BUFFER_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <memory>
+#include <string>
+
+// 不可变的共享缓冲区
+// 热点响应体（大JSON、静态资源）只保存一份，所有连接通过shared_ptr引用，
+// 写路径直接发送其中的数据，发送完成前由写请求持有引用。
+class SharedBuffer {
+ public:
+  // 接管字符串的内存创建缓冲区
+  static std::shared_ptr<const SharedBuffer> FromString(std::string data);
+
+  // 把文件只读映射到内存，失败时返回nullptr
+  static std::shared_ptr<const SharedBuffer> MapFile(const std::string& path);
+
+  ~SharedBuffer();
+
+  SharedBuffer(const SharedBuffer&) = delete;
+  SharedBuffer& operator=(const SharedBuffer&) = delete;
+
+  // 获取数据
+  const char* GetData() const;
+
+  // 获取数据长度
+  size_t GetSize() const;
+
+  // 获取内容哈希，创建时计算一次
+  uint64_t GetHash() const;
+
+  // 获取内容的修改时间：文件映射为文件的mtime，否则为创建时间
+  time_t GetModifiedTime() const;
+
+ private:
+  SharedBuffer();
+
+  std::string storage_;  // 字符串方式创建时持有的数据
+  void* mapping_;        // 文件映射的起始地址，未映射时为nullptr
+  const char* data_;     // 数据起始位置
+  size_t size_;          // 数据长度
+  uint64_t hash_;        // 内容哈希
+  time_t modified_;      // 内容的修改时间
+};
+
+#endif  // SHARED_BUFFER_H_
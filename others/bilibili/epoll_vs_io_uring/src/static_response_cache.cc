@@ -0,0 +1,193 @@
+// 静态路由的预序列化响应缓存实现
+#include "static_response_cache.h"
+
+#include <string.h>
+
+#include "hash.h"
+
+StaticResponseCache::StaticResponseCache()
+    : last_tick_(time(nullptr)), compressor_(nullptr) {
+  FormatHttpDate(last_tick_, date_);
+}
+
+StaticResponseCache::~StaticResponseCache() {}
+
+void StaticResponseCache::SetResponseCompressor(
+    ResponseCompressor* compressor) {
+  compressor_ = compressor;
+}
+
+const PreSerializedResponse* StaticResponseCache::Register(
+    const std::string& path, const HttpResponse& response) {
+  auto entry = std::make_unique<Entry>();
+  Variant& identity =
+      entry->variants[static_cast<int>(ContentEncoding::kIdentity)];
+  identity.present = true;
+  entry->negotiated = false;
+  entry->has_validators =
+      response.GetStatusCode() == HttpStatusCode::k200Ok;
+  if (!entry->has_validators) {
+    Serialize(response, date_, &identity.full);
+    entries_[path] = std::move(entry);
+    return &identity.full;
+  }
+
+  // 验证器在注册时计算一次：ETag取响应体的内容哈希
+  const auto& shared_body = response.GetSharedBody();
+  uint64_t hash;
+  if (shared_body) {
+    hash = shared_body->GetHash();
+    entry->last_modified = shared_body->GetModifiedTime();
+  } else {
+    hash = HashBytes(response.GetBody().data(), response.GetBody().size());
+    entry->last_modified = last_tick_;
+  }
+  char last_modified[kHttpDateLength + 1];
+  FormatHttpDate(entry->last_modified, last_modified);
+
+  // 压缩变体的ETag取压缩结果的哈希，与原始响应的不同
+  if (compressor_) {
+    for (ContentEncoding encoding :
+         {ContentEncoding::kGzip, ContentEncoding::kDeflate}) {
+      auto body = compressor_->Precompress(encoding, response);
+      if (!body) {
+        continue;
+      }
+      uint64_t compressed_hash = body->GetHash();
+      HttpResponse compressed = response;
+      compressed.SetHeader("Content-Encoding",
+                           ResponseCompressor::GetEncodingName(encoding));
+      compressed.SetHeader("Vary", "Accept-Encoding");
+      compressed.SetBody(std::move(body));
+      SerializeVariant(compressed, compressed_hash, last_modified,
+                       &entry->variants[static_cast<int>(encoding)]);
+      entry->negotiated = true;
+    }
+  }
+
+  // 有压缩变体时原始响应也带上Vary，让中间缓存区分不同编码
+  HttpResponse original = response;
+  if (entry->negotiated) {
+    original.SetHeader("Vary", "Accept-Encoding");
+  }
+  SerializeVariant(original, hash, last_modified, &identity);
+
+  entries_[path] = std::move(entry);
+  return &identity.full;
+}
+
+const PreSerializedResponse* StaticResponseCache::Add(
+    const HttpResponse& response) {
+  unrouted_.push_back(std::make_unique<PreSerializedResponse>());
+  Serialize(response, date_, unrouted_.back().get());
+  return unrouted_.back().get();
+}
+
+const PreSerializedResponse* StaticResponseCache::Find(
+    const std::string& path) {
+  // time()走vDSO，开销很小，用它驱动秒级时钟
+  Tick(time(nullptr));
+
+  auto it = entries_.find(path);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  return &it->second->variants[static_cast<int>(ContentEncoding::kIdentity)]
+              .full;
+}
+
+const PreSerializedResponse* StaticResponseCache::Find(
+    const HttpRequest& request) {
+  Tick(time(nullptr));
+
+  auto it = entries_.find(request.GetPath());
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+
+  // 只有带压缩变体的路由才解析Accept-Encoding，客户端不接受时用原始响应
+  const Entry& entry = *it->second;
+  const Variant* variant =
+      &entry.variants[static_cast<int>(ContentEncoding::kIdentity)];
+  if (entry.negotiated) {
+    ContentEncoding encoding = ResponseCompressor::Negotiate(
+        request.GetHeader("Accept-Encoding"));
+    const Variant& candidate = entry.variants[static_cast<int>(encoding)];
+    if (candidate.present) {
+      variant = &candidate;
+    }
+  }
+
+  if (entry.has_validators &&
+      IsNotModified(request, variant->etag, entry.last_modified)) {
+    return &variant->not_modified;
+  }
+  return &variant->full;
+}
+
+void StaticResponseCache::Tick(time_t now) {
+  if (now == last_tick_) {
+    return;
+  }
+
+  last_tick_ = now;
+  FormatHttpDate(now, date_);
+
+  // 原地改写每个响应的Date值
+  for (auto& entry : entries_) {
+    for (Variant& variant : entry.second->variants) {
+      if (!variant.present) {
+        continue;
+      }
+      PatchDate(&variant.full);
+      if (entry.second->has_validators) {
+        PatchDate(&variant.not_modified);
+      }
+    }
+  }
+  for (auto& entry : unrouted_) {
+    PatchDate(entry.get());
+  }
+}
+
+void StaticResponseCache::Serialize(const HttpResponse& response,
+                                    const char* date,
+                                    PreSerializedResponse* out) {
+  HttpResponse copy = response;
+  copy.SetHeader("Date", date);
+
+  // 共享响应体不复制到wire中，由写路径作为单独的段发送
+  out->wire.clear();
+  copy.SerializeTo(&out->wire);
+  out->date_offset = out->wire.find("\r\nDate: ") + 8;
+  out->body = copy.GetSharedBody();
+}
+
+void StaticResponseCache::SerializeVariant(const HttpResponse& response,
+                                           uint64_t hash,
+                                           const char* last_modified,
+                                           Variant* out) const {
+  FormatETag(hash, out->etag);
+  HttpResponse full = response;
+  full.SetHeader("ETag", out->etag);
+  full.SetHeader("Last-Modified", last_modified);
+  Serialize(full, date_, &out->full);
+
+  // 304响应只带验证器和缓存相关的头
+  HttpResponse not_modified;
+  not_modified.SetStatusCode(HttpStatusCode::k304NotModified);
+  not_modified.SetHeader("ETag", out->etag);
+  not_modified.SetHeader("Last-Modified", last_modified);
+  for (std::string_view name : {"Cache-Control", "Vary"}) {
+    std::string_view value = response.GetHeader(name);
+    if (!value.empty()) {
+      not_modified.SetHeader(name, value);
+    }
+  }
+  Serialize(not_modified, date_, &out->not_modified);
+  out->present = true;
+}
+
+void StaticResponseCache::PatchDate(PreSerializedResponse* response) const {
+  memcpy(&response->wire[response->date_offset], date_, kHttpDateLength);
+}
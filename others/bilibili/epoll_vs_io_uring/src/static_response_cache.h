@@ -0,0 +1,98 @@
+// 静态路由的预序列化响应缓存
+#ifndef STATIC_RESPONSE_CACHE_H_
+#define STATIC_RESPONSE_CACHE_H_
+
+#include <time.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "conditional_request.h"
+#include "http_date.h"
+#include "http_request.h"
+#include "http_response.h"
+#include "response_compressor.h"
+#include "shared_buffer.h"
+
+// 预序列化的完整响应（状态行、响应头、Date、Content-Length和响应体）
+struct PreSerializedResponse {
+  std::string wire;                          // 完整的响应字节
+  size_t date_offset;                        // Date头的值在wire中的偏移
+  std::shared_ptr<const SharedBuffer> body;  // 共享响应体，不包含在wire中
+};
+
+// 静态响应缓存
+// 处理函数在启动时注册一次响应，之后命中时直接把wire交给写路径，
+// 只有Date头的值会随秒级时钟原地改写。Date值定长，即使改写时恰好有
+// 写操作引用这块内存，对端最多看到相差一秒的合法日期。
+// 注册的200响应会带上强ETag和Last-Modified，并预先序列化对应的304响应，
+// 条件请求命中时在调用处理函数之前直接回答304。
+// 设置了压缩器时，可压缩的200响应在注册时预先压缩成gzip和deflate两个
+// 变体，各自带有按压缩结果计算的ETag，查找时按Accept-Encoding选择，
+// 静态路由的命中路径上不再压缩。
+// 缓存只在事件循环线程中访问。
+class StaticResponseCache {
+ public:
+  StaticResponseCache();
+  ~StaticResponseCache();
+
+  // 设置注册时预先压缩用的压缩器，为nullptr时只保存原始响应；
+  // 只影响之后注册的响应
+  void SetResponseCompressor(ResponseCompressor* compressor);
+
+  // 注册静态响应，返回预序列化结果，同一路径重复注册会覆盖
+  // 响应体可以是共享缓冲区，此时Last-Modified取其修改时间
+  const PreSerializedResponse* Register(const std::string& path,
+                                        const HttpResponse& response);
+
+  // 添加不绑定路径的响应，例如404或503，返回预序列化结果
+  const PreSerializedResponse* Add(const HttpResponse& response);
+
+  // 查找路径对应的响应，未注册时返回nullptr
+  const PreSerializedResponse* Find(const std::string& path);
+
+  // 查找请求对应的响应，条件请求命中验证器时返回304响应，未注册时返回nullptr
+  const PreSerializedResponse* Find(const HttpRequest& request);
+
+  // 时钟跳动，秒数变化时刷新所有响应的Date头
+  void Tick(time_t now);
+
+ private:
+  // 一种内容编码的完整响应和验证器
+  struct Variant {
+    PreSerializedResponse full;          // 完整响应
+    PreSerializedResponse not_modified;  // 304响应，没有验证器时为空
+    char etag[kETagLength + 1];          // 强ETag
+    bool present;                        // 是否有这种编码的变体
+  };
+
+  // 一个静态路由的各编码变体，按ContentEncoding索引，原始响应总是存在
+  struct Entry {
+    Variant variants[kNumContentEncodings];  // 各编码的变体
+    time_t last_modified;                    // 最后修改时间
+    bool has_validators;                     // 是否带有验证器
+    bool negotiated;                         // 是否有压缩变体需要协商
+  };
+
+  // 序列化响应并记录Date头的位置
+  static void Serialize(const HttpResponse& response, const char* date,
+                        PreSerializedResponse* out);
+
+  // 序列化带验证器的完整响应和对应的304响应
+  void SerializeVariant(const HttpResponse& response, uint64_t hash,
+                        const char* last_modified, Variant* out) const;
+
+  // 原地改写Date头的值
+  void PatchDate(PreSerializedResponse* response) const;
+
+  std::unordered_map<std::string, std::unique_ptr<Entry>>
+      entries_;                         // 路径到预序列化响应的映射
+  std::vector<std::unique_ptr<PreSerializedResponse>>
+      unrouted_;                        // 不绑定路径的响应
+  time_t last_tick_;                    // 上次刷新Date的时间
+  char date_[kHttpDateLength + 1];      // 当前的Date值
+  ResponseCompressor* compressor_;      // 注册时预先压缩用的压缩器
+};
+
+#endif  // STATIC_RESPONSE_CACHE_H_
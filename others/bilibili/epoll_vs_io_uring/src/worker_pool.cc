@@ -0,0 +1,62 @@
+// 有界工作线程池实现
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(size_t num_threads, size_t max_pending)
+    : max_pending_(max_pending), stopping_(false) {
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&WorkerPool::Run, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  Shutdown();
+}
+
+bool WorkerPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_ || tasks_.size() >= max_pending_) {
+      return false;
+    }
+    tasks_.push_back(std::move(task));
+  }
+  cond_.notify_one();
+  return true;
+}
+
+void WorkerPool::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return;
+    }
+    stopping_ = true;
+  }
+  cond_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t WorkerPool::GetPendingCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tasks_.size();
+}
+
+void WorkerPool::Run() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
@@ -0,0 +1,45 @@
+// 有界工作线程池
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 有界工作线程池，用于承接慢的处理函数，让事件循环线程只做I/O和快路由
+// 排队的任务达到上限时Submit()直接失败，由调用者回答503，
+// 而不是无限堆积请求拖垮内存和延迟。
+class WorkerPool {
+ public:
+  WorkerPool(size_t num_threads, size_t max_pending);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // 提交任务，队列已满或线程池已停止时返回false
+  bool Submit(std::function<void()> task);
+
+  // 停止接受新任务，执行完已排队的任务后等待所有线程退出
+  void Shutdown();
+
+  // 当前排队的任务数
+  size_t GetPendingCount() const;
+
+ private:
+  // 工作线程主循环
+  void Run();
+
+  std::vector<std::thread> threads_;         // 工作线程
+  std::deque<std::function<void()>> tasks_;  // 排队的任务
+  size_t max_pending_;                       // 最多排队的任务数
+  bool stopping_;                            // 是否正在停止
+  mutable std::mutex mutex_;                 // 保护任务队列
+  std::condition_variable cond_;             // 有新任务或停止时通知
+};
+
+#endif  // WORKER_POOL_H_
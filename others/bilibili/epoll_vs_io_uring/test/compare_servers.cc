@@ -0,0 +1,370 @@
+// epoll与io_uring服务器的自动对比测试
+// 依次启动各个服务器，在连接数、是否长连接、流水线深度和响应体大小组成的
+// 矩阵上逐格预热并重复压测多次，采集QPS、延迟分位数、服务器CPU时间和
+// 内存，输出JSON和CSV文件以及带置信区间的对比表；指定基线时与上一次运行
+// 的CSV对比，有显著回退时退出码为2。可以把服务器和压测客户端分别绑定到
+// 不重叠的CPU上，避免两者争抢CPU带来的干扰。
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "comparison_report.h"
+#include "cpu_affinity.h"
+#include "event_engine.h"
+#include "load_runner.h"
+#include "process_stats.h"
+#include "scenario.h"
+#include "server_process.h"
+#include "worker_stats.h"
+
+namespace {
+
+// 被测服务器
+struct ServerSpec {
+  std::string name;    // 服务器名，用于报告
+  std::string binary;  // 可执行文件路径
+};
+
+// 按逗号拆分整数列表
+bool ParseIntList(const std::string& text, std::vector<int>* values) {
+  values->clear();
+  std::istringstream in(text);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    try {
+      values->push_back(std::stoi(item));
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+  return !values->empty();
+}
+
+// 本程序所在的目录，用于找到同一构建目录下的服务器
+std::string GetProgramDir() {
+  char path[PATH_MAX];
+  ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (n <= 0) {
+    return ".";
+  }
+  path[n] = '\0';
+  std::string dir(path);
+  size_t slash = dir.rfind('/');
+  return slash == std::string::npos ? "." : dir.substr(0, slash);
+}
+
+// 生成payload字节的静态资源文件，返回文件路径，失败时返回空
+std::string CreateAsset(size_t payload) {
+  char path[] = "/tmp/compare_servers_asset_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return "";
+  }
+  close(fd);
+  std::ofstream out(path, std::ios::binary);
+  out << std::string(payload, 'x');
+  if (!out) {
+    unlink(path);
+    return "";
+  }
+  return path;
+}
+
+// 闭环压测duration_ns，各线程平分连接，每个连接收到响应后立即发送下一批
+LoadResult RunLoad(const Scenario& scenario, int port, const CellConfig& config,
+                   int num_threads, uint64_t duration_ns) {
+  EngineOptions options;
+  options.ip = "127.0.0.1";
+  options.port = port;
+  options.scenario = &scenario;
+  options.connections = config.connections;
+  options.requests_per_connection = config.keep_alive ? 0 : 1;
+  options.pipeline_depth = config.pipeline_depth;
+  return RunTimedLoad(options, num_threads, duration_ns, 0);
+}
+
+// 在一格上预热后重复压测repetitions次，并采集服务器在测量期间的CPU时间
+// 和内存；预热的结果丢弃，每次测量的QPS、p99和每请求CPU时间作为样本
+CellResult RunCell(const ServerSpec& server, const ServerProcess& process,
+                   const CellConfig& config, const std::string& path,
+                   int num_threads, double warmup_seconds,
+                   double duration_seconds, int repetitions) {
+  Scenario scenario("127.0.0.1", process.GetPort(), path);
+  if (warmup_seconds > 0) {
+    RunLoad(scenario, process.GetPort(), config, num_threads,
+            static_cast<uint64_t>(warmup_seconds * 1e9));
+  }
+
+  CellResult result;
+  result.server = server.name;
+  result.config = config;
+  result.server_cpu_seconds = 0;
+  std::unique_ptr<WorkerStats> total;
+  ProcessSample after = {};
+  for (int i = 0; i < repetitions; ++i) {
+    ProcessSample before = {};
+    ReadProcessSample(process.GetPid(), &before);
+    LoadResult load = RunLoad(scenario, process.GetPort(), config,
+                              num_threads,
+                              static_cast<uint64_t>(duration_seconds * 1e9));
+    ReadProcessSample(process.GetPid(), &after);
+
+    const WorkerStats& stats = *load.stats;
+    double cpu_seconds = (after.cpu_ns - before.cpu_ns) / 1e9;
+    result.server_cpu_seconds += cpu_seconds;
+    result.qps_samples.push_back(
+        load.seconds > 0 ? stats.success / load.seconds : 0);
+    result.p99_samples.push_back(
+        static_cast<double>(stats.latency.GetPercentile(99)));
+    result.cpu_samples.push_back(
+        stats.success > 0 ? cpu_seconds * 1e6 / stats.success : 0);
+    if (total) {
+      total->Merge(stats);
+    } else {
+      total = std::move(load.stats);
+    }
+  }
+
+  result.requests = total->success;
+  result.failures = total->fail;
+  result.non_2xx = total->non_2xx;
+  result.p50_ns = total->latency.GetPercentile(50);
+  result.p90_ns = total->latency.GetPercentile(90);
+  result.p99_ns = total->latency.GetPercentile(99);
+  result.p999_ns = total->latency.GetPercentile(99.9);
+  result.max_ns = total->latency.GetMax();
+  result.rss_kb = after.rss_kb;
+  result.peak_rss_kb = after.peak_kb;
+  SummarizeSamples(&result);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  // 默认在构建目录中找两个服务器
+  std::string build_dir = GetProgramDir() + "/..";
+  std::vector<ServerSpec> servers = {
+      {"epoll", build_dir + "/epoll/http_server_epoll"},
+      {"io_uring", build_dir + "/io_uring/http_server_io_uring"}};
+
+  // 测试矩阵，流水线只在长连接上测试
+  std::vector<int> connections = {10, 100, 1000};
+  std::vector<int> keep_alive = {1, 0};
+  std::vector<int> pipeline_depths = {1, 16};
+  std::vector<int> payloads = {0, 16384};
+
+  int num_threads = 4;
+  double duration_seconds = 3;
+  double warmup_seconds = 1;
+  std::string output = "comparison";
+  std::string baseline_file;
+  std::string current_file;
+  double threshold_percent = 5;
+
+  // 重复次数：置换检验在每方5次时最小的p值约为0.008，少于4次时永远不显著
+  int repetitions = 5;
+  double alpha = 0.05;
+
+  // 服务器和客户端绑定的CPU，为空时不绑定
+  std::string server_cpu_list;
+  std::string client_cpu_list;
+
+  // 解析命令行参数
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) {
+      break;
+    }
+    std::string arg = argv[i];
+    std::string value = argv[i + 1];
+    bool ok = true;
+    if (arg == "--epoll") {
+      servers[0].binary = value;
+    } else if (arg == "--io-uring") {
+      servers[1].binary = value;
+    } else if (arg == "--connections" || arg == "-c") {
+      ok = ParseIntList(value, &connections);
+    } else if (arg == "--keep-alive") {
+      // on、off或on,off
+      keep_alive.clear();
+      std::istringstream in(value);
+      std::string item;
+      while (ok && std::getline(in, item, ',')) {
+        ok = item == "on" || item == "off";
+        keep_alive.push_back(item == "on");
+      }
+      ok = ok && !keep_alive.empty();
+    } else if (arg == "--pipeline-depth") {
+      ok = ParseIntList(value, &pipeline_depths);
+    } else if (arg == "--payload") {
+      ok = ParseIntList(value, &payloads);
+    } else if (arg == "--threads" || arg == "-t") {
+      num_threads = std::stoi(value);
+    } else if (arg == "--duration" || arg == "-d") {
+      duration_seconds = std::stod(value);
+    } else if (arg == "--warmup") {
+      warmup_seconds = std::stod(value);
+    } else if (arg == "--output" || arg == "-o") {
+      output = value;
+    } else if (arg == "--baseline") {
+      baseline_file = value;
+    } else if (arg == "--current") {
+      current_file = value;
+    } else if (arg == "--threshold") {
+      threshold_percent = std::stod(value);
+    } else if (arg == "--repetitions" || arg == "-n") {
+      repetitions = std::stoi(value);
+      ok = repetitions > 0;
+    } else if (arg == "--alpha") {
+      alpha = std::stod(value);
+      ok = alpha > 0 && alpha < 1;
+    } else if (arg == "--server-cpus") {
+      server_cpu_list = value;
+    } else if (arg == "--client-cpus") {
+      client_cpu_list = value;
+    } else {
+      std::cerr << "未知的参数: " << arg << std::endl;
+      return 1;
+    }
+    if (!ok) {
+      std::cerr << "参数值无效: " << arg << " " << value << std::endl;
+      return 1;
+    }
+  }
+
+  // 指定--current时不运行测试，只对比两个结果文件
+  std::vector<CellResult> results;
+  std::string error;
+  if (!current_file.empty()) {
+    if (!ReadCsv(current_file, &results, &error)) {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+  } else {
+    // 服务器默认使用本进程原来可用的全部CPU，绑定客户端后fork的服务器
+    // 不会继承客户端的绑定
+    cpu_set_t server_cpus;
+    cpu_set_t client_cpus;
+    bool pin_server = !server_cpu_list.empty() || !client_cpu_list.empty();
+    sched_getaffinity(0, sizeof(server_cpus), &server_cpus);
+    if (!server_cpu_list.empty() &&
+        !ParseCpuList(server_cpu_list, &server_cpus)) {
+      std::cerr << "CPU列表无效: " << server_cpu_list << std::endl;
+      return 1;
+    }
+    if (!client_cpu_list.empty()) {
+      if (!ParseCpuList(client_cpu_list, &client_cpus)) {
+        std::cerr << "CPU列表无效: " << client_cpu_list << std::endl;
+        return 1;
+      }
+      if (!PinToCpus(0, client_cpus, &error)) {
+        std::cerr << error << std::endl;
+        return 1;
+      }
+      if (CpuSetsOverlap(server_cpus, client_cpus)) {
+        std::cerr << "警告: 服务器与客户端的CPU有重叠，测量会互相干扰"
+                  << std::endl;
+      }
+    }
+
+    int max_connections =
+        *std::max_element(connections.begin(), connections.end());
+    rlim_t needed = max_connections + 64;
+    if (RaiseFileLimit(needed) < needed) {
+      std::cerr << "警告: 打开文件数限制不足以建立 " << max_connections
+                << " 个连接" << std::endl;
+    }
+
+    for (const ServerSpec& server : servers) {
+      // 每种响应体大小启动一次服务器：0用最小的静态响应/hello，
+      // 其余生成对应大小的文件作为/asset
+      for (int payload : payloads) {
+        std::string asset;
+        std::vector<std::string> args;
+        if (payload > 0) {
+          asset = CreateAsset(payload);
+          if (asset.empty()) {
+            std::cerr << "无法生成 " << payload << " 字节的静态资源文件"
+                      << std::endl;
+            return 1;
+          }
+          args.push_back(asset);
+        }
+
+        ServerProcess process;
+        if (pin_server) {
+          process.SetCpus(server_cpus);
+        }
+        if (!process.Start(server.binary, args, &error)) {
+          std::cerr << "跳过 " << server.name << ": " << error << std::endl;
+          if (!asset.empty()) {
+            unlink(asset.c_str());
+          }
+          break;
+        }
+
+        for (int count : connections) {
+          for (int keep : keep_alive) {
+            for (int depth : pipeline_depths) {
+              if (!keep && depth > 1) {
+                continue;
+              }
+              CellConfig config = {count, keep != 0, depth,
+                                   static_cast<size_t>(payload)};
+              std::cout << server.name << "  连接数 " << count << "  "
+                        << (keep ? "长连接" : "短连接") << "  流水线 " << depth
+                        << "  响应体 " << payload << " 字节 ..." << std::flush;
+              CellResult result = RunCell(
+                  server, process, config, payload > 0 ? "/asset" : "/hello",
+                  num_threads, warmup_seconds, duration_seconds, repetitions);
+              std::cout << " QPS中位数 " << static_cast<uint64_t>(result.qps)
+                        << "（" << static_cast<uint64_t>(result.qps_low) << "~"
+                        << static_cast<uint64_t>(result.qps_high)
+                        << "），失败 " << result.failures << std::endl;
+              results.push_back(result);
+            }
+          }
+        }
+
+        process.Stop();
+        if (!asset.empty()) {
+          unlink(asset.c_str());
+        }
+      }
+    }
+
+    RunInfo info = {duration_seconds, warmup_seconds, num_threads,
+                    repetitions, server_cpu_list, client_cpu_list};
+    if (!WriteJson(output + ".json", info, results) ||
+        !WriteCsv(output + ".csv", results)) {
+      std::cerr << "无法写出结果文件: " << output << ".json/.csv"
+                << std::endl;
+      return 1;
+    }
+    std::cout << "结果已写入 " << output << ".json 和 " << output << ".csv"
+              << std::endl;
+  }
+
+  PrintSummary(results);
+
+  if (!baseline_file.empty()) {
+    std::vector<CellResult> baseline;
+    if (!ReadCsv(baseline_file, &baseline, &error)) {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+    if (PrintDiff(baseline, results, threshold_percent, alpha) > 0) {
+      return 2;
+    }
+  }
+  return 0;
+}
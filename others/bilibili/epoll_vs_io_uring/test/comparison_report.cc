@@ -0,0 +1,482 @@
+// 服务器对比测试的结果和报告实现
+#include "comparison_report.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "report_format.h"
+#include "statistics.h"
+
+namespace {
+
+// CSV的列，顺序即写出的顺序
+const char* const kCsvColumns[] = {
+    "server", "connections", "keep_alive", "pipeline_depth",
+    "payload_bytes", "requests", "failures", "non_2xx", "qps",
+    "p50_ns", "p90_ns", "p99_ns", "p999_ns", "max_ns",
+    "server_cpu_seconds", "cpu_us_per_request", "rss_kb", "peak_rss_kb",
+    "repetitions", "qps_ci_low", "qps_ci_high", "p99_ci_low_ns",
+    "p99_ci_high_ns", "qps_samples", "p99_samples", "cpu_samples"};
+
+// 从这一列开始是加入重复测量后才有的列，旧文件中可以没有
+const size_t kFirstRepetitionColumn = 18;
+
+// 置信区间的置信度和自助法的重抽样次数
+const double kConfidence = 0.95;
+const int kBootstrapResamples = 10000;
+
+// 置换检验最多尝试的分组数
+const int kMaxPermutations = 20000;
+
+// 重抽样和随机分组的种子，同样的数据每次得到同样的结果
+const uint64_t kStatisticsSeed = 1;
+
+// 格式化浮点数，去掉多余的零
+std::string FormatNumber(double value) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.6g", value);
+  return text;
+}
+
+// 把样本写成一列，以分号分隔
+std::string FormatSamples(const std::vector<double>& samples) {
+  std::string text;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    text += (i == 0 ? "" : ";") + FormatNumber(samples[i]);
+  }
+  return text;
+}
+
+// 解析以分号分隔的样本，格式错误时抛出异常
+std::vector<double> ParseSamples(const std::string& text) {
+  std::vector<double> samples;
+  std::istringstream in(text);
+  std::string item;
+  while (std::getline(in, item, ';')) {
+    samples.push_back(std::stod(item));
+  }
+  return samples;
+}
+
+// 一个结果各列的值，顺序与kCsvColumns相同
+std::vector<std::string> GetFields(const CellResult& result) {
+  return {result.server,
+          std::to_string(result.config.connections),
+          result.config.keep_alive ? "1" : "0",
+          std::to_string(result.config.pipeline_depth),
+          std::to_string(result.config.payload),
+          std::to_string(result.requests),
+          std::to_string(result.failures),
+          std::to_string(result.non_2xx),
+          FormatNumber(result.qps),
+          std::to_string(result.p50_ns),
+          std::to_string(result.p90_ns),
+          std::to_string(result.p99_ns),
+          std::to_string(result.p999_ns),
+          std::to_string(result.max_ns),
+          FormatNumber(result.server_cpu_seconds),
+          FormatNumber(result.cpu_us_per_request),
+          std::to_string(result.rss_kb),
+          std::to_string(result.peak_rss_kb),
+          std::to_string(result.repetitions),
+          FormatNumber(result.qps_low),
+          FormatNumber(result.qps_high),
+          std::to_string(result.p99_low_ns),
+          std::to_string(result.p99_high_ns),
+          FormatSamples(result.qps_samples),
+          FormatSamples(result.p99_samples),
+          FormatSamples(result.cpu_samples)};
+}
+
+// 按逗号拆分一行，其他工具写出的文件可能以\r\n换行
+std::vector<std::string> SplitCsvLine(std::string line) {
+  if (!line.empty() && line.back() == '\r') {
+    line.pop_back();
+  }
+  std::vector<std::string> fields;
+  std::istringstream in(line);
+  std::string field;
+  while (std::getline(in, field, ',')) {
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+// 描述一格的参数的四列
+std::string FormatConfig(const CellConfig& config) {
+  return PadLeft(std::to_string(config.connections), 8) +
+         PadLeft(config.keep_alive ? "是" : "否", 8) +
+         PadLeft(std::to_string(config.pipeline_depth), 8) +
+         PadLeft(std::to_string(config.payload), 10);
+}
+
+// 表头中参数的四列
+std::string FormatConfigHeader() {
+  return PadLeft("连接数", 8) + PadLeft("长连接", 8) + PadLeft("流水线", 8) +
+         PadLeft("响应体", 10);
+}
+
+// 相对变化的百分比，基线为0时返回0
+double PercentChange(double baseline, double current) {
+  return baseline > 0 ? (current - baseline) / baseline * 100.0 : 0.0;
+}
+
+// 格式化相对变化，带正负号，significant为真时加星号
+std::string FormatChange(double percent, bool significant) {
+  char text[32];
+  snprintf(text, sizeof(text), "%+.1f%%%s", percent, significant ? "*" : "");
+  return text;
+}
+
+// 格式化p值，无法检验时为-
+std::string FormatPValue(const std::vector<double>& a,
+                         const std::vector<double>& b, double p) {
+  if (a.size() < 2 || b.size() < 2) {
+    return "-";
+  }
+  char text[32];
+  snprintf(text, sizeof(text), "%.3f", p);
+  return text;
+}
+
+// 置信区间半宽相对中位数的百分比，只测量一次时为-
+std::string FormatSpread(const CellResult& result) {
+  if (result.repetitions < 2 || result.qps <= 0) {
+    return "-";
+  }
+  char text[32];
+  snprintf(text, sizeof(text), "±%.1f%%",
+           (result.qps_high - result.qps_low) / 2 / result.qps * 100);
+  return text;
+}
+
+}  // namespace
+
+bool CellConfig::operator==(const CellConfig& other) const {
+  return connections == other.connections &&
+         keep_alive == other.keep_alive &&
+         pipeline_depth == other.pipeline_depth && payload == other.payload;
+}
+
+void SummarizeSamples(CellResult* result) {
+  result->repetitions = static_cast<int>(
+      std::max({result->qps_samples.size(), result->p99_samples.size(),
+                result->cpu_samples.size()}));
+  if (!result->qps_samples.empty()) {
+    result->qps = Median(result->qps_samples);
+    Interval interval = BootstrapMedianInterval(
+        result->qps_samples, kConfidence, kBootstrapResamples,
+        kStatisticsSeed);
+    result->qps_low = interval.low;
+    result->qps_high = interval.high;
+  }
+  if (!result->p99_samples.empty()) {
+    result->p99_ns = static_cast<uint64_t>(Median(result->p99_samples));
+    Interval interval = BootstrapMedianInterval(
+        result->p99_samples, kConfidence, kBootstrapResamples,
+        kStatisticsSeed);
+    result->p99_low_ns = static_cast<uint64_t>(interval.low);
+    result->p99_high_ns = static_cast<uint64_t>(interval.high);
+  }
+  if (!result->cpu_samples.empty()) {
+    result->cpu_us_per_request = Median(result->cpu_samples);
+  }
+}
+
+bool WriteJson(const std::string& path, const RunInfo& info,
+               const std::vector<CellResult>& results) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+
+  // 服务器名只来自命令行，不含需要转义的字符
+  out << "{\n";
+  out << "  \"duration_seconds\": " << FormatNumber(info.duration_seconds)
+      << ",\n";
+  out << "  \"warmup_seconds\": " << FormatNumber(info.warmup_seconds)
+      << ",\n";
+  out << "  \"client_threads\": " << info.client_threads << ",\n";
+  out << "  \"repetitions\": " << info.repetitions << ",\n";
+  out << "  \"server_cpus\": \"" << info.server_cpus << "\",\n";
+  out << "  \"client_cpus\": \"" << info.client_cpus << "\",\n";
+  out << "  \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    std::vector<std::string> fields = GetFields(results[i]);
+    out << (i == 0 ? "\n" : ",\n") << "    {";
+    for (size_t j = 0; j < fields.size(); ++j) {
+      std::string column = kCsvColumns[j];
+      out << (j == 0 ? "" : ", ") << "\"" << column << "\": ";
+      if (j == 0) {
+        out << "\"" << fields[j] << "\"";
+      } else if (j == 2) {
+        out << (results[i].config.keep_alive ? "true" : "false");
+      } else if (column.size() > 8 &&
+                 column.compare(column.size() - 8, 8, "_samples") == 0) {
+        // 样本写成数组
+        std::string samples = fields[j];
+        std::replace(samples.begin(), samples.end(), ';', ',');
+        out << "[" << samples << "]";
+      } else {
+        out << fields[j];
+      }
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+  return static_cast<bool>(out);
+}
+
+bool WriteCsv(const std::string& path, const std::vector<CellResult>& results) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  for (size_t i = 0; i < sizeof(kCsvColumns) / sizeof(kCsvColumns[0]); ++i) {
+    out << (i == 0 ? "" : ",") << kCsvColumns[i];
+  }
+  out << "\n";
+  for (const CellResult& result : results) {
+    std::vector<std::string> fields = GetFields(result);
+    for (size_t i = 0; i < fields.size(); ++i) {
+      out << (i == 0 ? "" : ",") << fields[i];
+    }
+    out << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+bool ReadCsv(const std::string& path, std::vector<CellResult>* results,
+             std::string* error) {
+  std::ifstream in(path);
+  std::string line;
+  if (!in || !std::getline(in, line)) {
+    *error = "无法读取结果文件: " + path;
+    return false;
+  }
+
+  // 按表头定位各列，列的顺序变化或增加新列时旧文件仍然可读
+  std::map<std::string, size_t> index;
+  std::vector<std::string> header = SplitCsvLine(line);
+  for (size_t i = 0; i < header.size(); ++i) {
+    index[header[i]] = i;
+  }
+  for (size_t i = 0; i < kFirstRepetitionColumn; ++i) {
+    if (index.find(kCsvColumns[i]) == index.end()) {
+      *error = path + ": 缺少列 " + kCsvColumns[i];
+      return false;
+    }
+  }
+  bool has_samples = true;
+  for (size_t i = kFirstRepetitionColumn;
+       i < sizeof(kCsvColumns) / sizeof(kCsvColumns[0]); ++i) {
+    has_samples = has_samples && index.find(kCsvColumns[i]) != index.end();
+  }
+
+  int line_number = 1;
+  while (std::getline(in, line)) {
+    ++line_number;
+    if (line.empty()) {
+      continue;
+    }
+    std::vector<std::string> fields = SplitCsvLine(line);
+    if (fields.size() < header.size()) {
+      *error = path + ":" + std::to_string(line_number) + ": 列数不足";
+      return false;
+    }
+    auto get = [&](const char* column) -> const std::string& {
+      return fields[index[column]];
+    };
+
+    CellResult result;
+    try {
+      result.server = get("server");
+      result.config.connections = std::stoi(get("connections"));
+      result.config.keep_alive = get("keep_alive") == "1";
+      result.config.pipeline_depth = std::stoi(get("pipeline_depth"));
+      result.config.payload = std::stoull(get("payload_bytes"));
+      result.requests = std::stoull(get("requests"));
+      result.failures = std::stoull(get("failures"));
+      result.non_2xx = std::stoull(get("non_2xx"));
+      result.qps = std::stod(get("qps"));
+      result.p50_ns = std::stoull(get("p50_ns"));
+      result.p90_ns = std::stoull(get("p90_ns"));
+      result.p99_ns = std::stoull(get("p99_ns"));
+      result.p999_ns = std::stoull(get("p999_ns"));
+      result.max_ns = std::stoull(get("max_ns"));
+      result.server_cpu_seconds = std::stod(get("server_cpu_seconds"));
+      result.cpu_us_per_request = std::stod(get("cpu_us_per_request"));
+      result.rss_kb = std::stoull(get("rss_kb"));
+      result.peak_rss_kb = std::stoull(get("peak_rss_kb"));
+      if (has_samples) {
+        result.qps_samples = ParseSamples(get("qps_samples"));
+        result.p99_samples = ParseSamples(get("p99_samples"));
+        result.cpu_samples = ParseSamples(get("cpu_samples"));
+      } else {
+        result.qps_samples = {result.qps};
+        result.p99_samples = {static_cast<double>(result.p99_ns)};
+        result.cpu_samples = {result.cpu_us_per_request};
+      }
+    } catch (const std::exception&) {
+      *error = path + ":" + std::to_string(line_number) + ": 数值格式错误";
+      return false;
+    }
+
+    // 中位数和置信区间由样本重新计算，与写出时相同
+    SummarizeSamples(&result);
+    results->push_back(result);
+  }
+  return true;
+}
+
+void PrintSummary(const std::vector<CellResult>& results) {
+  // 按出现的顺序收集各格和各服务器
+  std::vector<CellConfig> configs;
+  std::vector<std::string> servers;
+  for (const CellResult& result : results) {
+    bool found = false;
+    for (const CellConfig& config : configs) {
+      found = found || config == result.config;
+    }
+    if (!found) {
+      configs.push_back(result.config);
+    }
+    found = false;
+    for (const std::string& server : servers) {
+      found = found || server == result.server;
+    }
+    if (!found) {
+      servers.push_back(result.server);
+    }
+  }
+
+  // QPS是各次的中位数，区间是置信区间的半宽
+  std::cout << "\n对比（QPS中位数及" << kConfidence * 100
+            << "%置信区间，p99毫秒，每请求CPU微秒）:" << std::endl;
+  std::cout << "  " << FormatConfigHeader();
+  for (const std::string& server : servers) {
+    std::cout << PadLeft(server, 12) << PadLeft("区间", 8)
+              << PadLeft("p99", 10) << PadLeft("CPU", 8);
+  }
+  if (servers.size() == 2) {
+    std::cout << PadLeft("QPS比", 8) << PadLeft("p值", 8);
+  }
+  std::cout << std::endl;
+
+  for (const CellConfig& config : configs) {
+    std::cout << "  " << FormatConfig(config);
+    const CellResult* pair[2] = {nullptr, nullptr};
+    for (size_t i = 0; i < servers.size(); ++i) {
+      const CellResult* found = nullptr;
+      for (const CellResult& result : results) {
+        if (result.server == servers[i] && result.config == config) {
+          found = &result;
+        }
+      }
+      if (found == nullptr) {
+        std::cout << PadLeft("-", 12) << PadLeft("-", 8) << PadLeft("-", 10)
+                  << PadLeft("-", 8);
+        continue;
+      }
+      char cpu[32];
+      snprintf(cpu, sizeof(cpu), "%.2f", found->cpu_us_per_request);
+      uint64_t rounded = static_cast<uint64_t>(found->qps);
+      std::cout << PadLeft(std::to_string(rounded), 12)
+                << PadLeft(FormatSpread(*found), 8)
+                << PadLeft(FormatMillis(found->p99_ns), 10)
+                << PadLeft(cpu, 8);
+      if (i < 2) {
+        pair[i] = found;
+      }
+    }
+    if (servers.size() == 2) {
+      std::string ratio = "-";
+      std::string p = "-";
+      if (pair[0] != nullptr && pair[1] != nullptr) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.2f",
+                 pair[0]->qps > 0 ? pair[1]->qps / pair[0]->qps : 0);
+        ratio = text;
+        p = FormatPValue(pair[0]->qps_samples, pair[1]->qps_samples,
+                         PermutationTest(pair[0]->qps_samples,
+                                         pair[1]->qps_samples,
+                                         kMaxPermutations, kStatisticsSeed));
+      }
+      std::cout << PadLeft(ratio, 8) << PadLeft(p, 8);
+    }
+    std::cout << std::endl;
+  }
+}
+
+int PrintDiff(const std::vector<CellResult>& baseline,
+              const std::vector<CellResult>& current,
+              double threshold_percent, double alpha) {
+  std::cout << "\n与基线对比（超过 " << threshold_percent
+            << "% 且差异显著的劣化记为回退）:" << std::endl;
+  std::cout << "  " << PadLeft("服务器", 12) << FormatConfigHeader()
+            << PadLeft("QPS", 9) << PadLeft("p99", 9) << PadLeft("CPU", 9)
+            << "  结论" << std::endl;
+
+  int regressions = 0;
+  bool untested = false;
+  for (const CellResult& result : current) {
+    const CellResult* base = nullptr;
+    for (const CellResult& candidate : baseline) {
+      if (candidate.server == result.server &&
+          candidate.config == result.config) {
+        base = &candidate;
+      }
+    }
+    std::cout << "  " << PadLeft(result.server, 12)
+              << FormatConfig(result.config);
+    if (base == nullptr) {
+      std::cout << "  基线中没有这一格" << std::endl;
+      continue;
+    }
+
+    // 三个指标各自检验，任一方少于2次测量时p值为1，视为无法检验
+    bool testable = base->qps_samples.size() >= 2 &&
+                    result.qps_samples.size() >= 2;
+    untested = untested || !testable;
+    auto significant = [&](const std::vector<double>& a,
+                           const std::vector<double>& b) {
+      return testable &&
+             PermutationTest(a, b, kMaxPermutations, kStatisticsSeed) < alpha;
+    };
+    double qps = PercentChange(base->qps, result.qps);
+    double p99 = PercentChange(base->p99_ns, result.p99_ns);
+    double cpu =
+        PercentChange(base->cpu_us_per_request, result.cpu_us_per_request);
+    bool qps_significant = significant(base->qps_samples, result.qps_samples);
+    bool p99_significant = significant(base->p99_samples, result.p99_samples);
+    bool cpu_significant = significant(base->cpu_samples, result.cpu_samples);
+
+    // 超过阈值但不显著的变化在噪声范围内，不算回退
+    bool exceeded = qps < -threshold_percent || p99 > threshold_percent ||
+                    cpu > threshold_percent;
+    bool regressed =
+        (qps < -threshold_percent && (qps_significant || !testable)) ||
+        (p99 > threshold_percent && (p99_significant || !testable)) ||
+        (cpu > threshold_percent && (cpu_significant || !testable));
+    if (regressed) {
+      ++regressions;
+    }
+    std::cout << PadLeft(FormatChange(qps, qps_significant), 9)
+              << PadLeft(FormatChange(p99, p99_significant), 9)
+              << PadLeft(FormatChange(cpu, cpu_significant), 9) << "  "
+              << (regressed ? "回退" : exceeded ? "不显著" : "正常")
+              << std::endl;
+  }
+  std::cout << "  *表示差异显著（置换检验 p < " << alpha << "）" << std::endl;
+  if (untested) {
+    std::cout << "  部分格测量次数少于2次，无法检验，只按阈值判断"
+              << std::endl;
+  }
+  std::cout << "回退数: " << regressions << std::endl;
+  return regressions;
+}
@@ -0,0 +1,88 @@
+// 服务器对比测试的结果和报告
+#ifndef COMPARISON_REPORT_H_
+#define COMPARISON_REPORT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// 测试矩阵中的一格
+struct CellConfig {
+  int connections;     // 并发连接数
+  bool keep_alive;     // 是否复用连接，否则每个请求新建连接
+  int pipeline_depth;  // 流水线深度
+  size_t payload;      // 响应体字节数，0表示最小的静态响应
+
+  // 两格参数相同时相等，用于对比不同服务器和不同次运行的结果
+  bool operator==(const CellConfig& other) const;
+};
+
+// 一个服务器在一格上的测试结果
+// 每格重复测量多次，QPS、p99和每请求CPU时间取各次的中位数，并给出
+// 中位数的置信区间；请求数和CPU时间是各次之和，其余延迟分位数取自
+// 所有次合并的延迟分布。
+struct CellResult {
+  std::string server;               // 服务器名
+  CellConfig config;                // 测试参数
+  uint64_t requests;                // 成功的请求数
+  uint64_t failures;                // 失败的请求数
+  uint64_t non_2xx;                 // 状态码不是2xx的响应数
+  double qps;                       // 每秒成功的请求数
+  uint64_t p50_ns;                  // 延迟的各个分位数
+  uint64_t p90_ns;
+  uint64_t p99_ns;
+  uint64_t p999_ns;
+  uint64_t max_ns;                  // 最大延迟
+  double server_cpu_seconds;        // 服务器在测量期间用掉的CPU时间
+  double cpu_us_per_request;        // 服务器每个请求的CPU时间，微秒
+  uint64_t rss_kb;                  // 测量结束时服务器的常驻内存
+  uint64_t peak_rss_kb;             // 服务器常驻内存的峰值
+  int repetitions;                  // 重复测量的次数
+  double qps_low;                   // QPS中位数的置信区间
+  double qps_high;
+  uint64_t p99_low_ns;              // p99中位数的置信区间
+  uint64_t p99_high_ns;
+  std::vector<double> qps_samples;  // 每次的QPS
+  std::vector<double> p99_samples;  // 每次的p99，纳秒
+  std::vector<double> cpu_samples;  // 每次的每请求CPU时间，微秒
+};
+
+// 一次运行的参数，写入JSON便于事后核对
+struct RunInfo {
+  double duration_seconds;  // 每次测量的时间
+  double warmup_seconds;    // 每格测量前的预热时间
+  int client_threads;       // 压测客户端的线程数
+  int repetitions;          // 每格重复测量的次数
+  std::string server_cpus;  // 服务器绑定的CPU，为空表示不绑定
+  std::string client_cpus;  // 压测客户端绑定的CPU，为空表示不绑定
+};
+
+// 由各次的样本计算repetitions、qps、p99_ns、cpu_us_per_request和
+// 置信区间，样本为空的指标保持原值
+void SummarizeSamples(CellResult* result);
+
+// 写出JSON结果，失败时返回false
+bool WriteJson(const std::string& path, const RunInfo& info,
+               const std::vector<CellResult>& results);
+
+// 写出CSV结果，一行一个结果，失败时返回false
+bool WriteCsv(const std::string& path, const std::vector<CellResult>& results);
+
+// 读取WriteCsv写出的结果，按表头取列，失败时输出原因到*error；
+// 没有重复测量各列的旧文件按只测量了一次读取
+bool ReadCsv(const std::string& path, std::vector<CellResult>* results,
+             std::string* error);
+
+// 输出对比表：每格一行，各服务器的QPS及其置信区间、p99和每请求CPU时间
+// 并列；只有两个服务器时另外给出QPS之比和两者QPS差异的p值
+void PrintSummary(const std::vector<CellResult>& results);
+
+// 输出与基线的差异，QPS下降、p99或每请求CPU时间上升超过threshold_percent
+// 并且置换检验的p值小于alpha的记为回退，返回回退的个数；
+// 任一方少于2次测量时无法检验，只按阈值判断
+int PrintDiff(const std::vector<CellResult>& baseline,
+              const std::vector<CellResult>& current,
+              double threshold_percent, double alpha);
+
+#endif  // COMPARISON_REPORT_H_
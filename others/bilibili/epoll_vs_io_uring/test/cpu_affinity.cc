@@ -0,0 +1,54 @@
+// 把进程绑定到指定的CPU实现
+#include "cpu_affinity.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <sstream>
+
+bool ParseCpuList(const std::string& text, cpu_set_t* cpus) {
+  CPU_ZERO(cpus);
+  std::istringstream in(text);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    // 单个编号或first-last的区间，每部分都必须完整地是数字
+    size_t dash = item.find('-');
+    std::string first_text = item.substr(0, dash);
+    std::string last_text =
+        dash == std::string::npos ? first_text : item.substr(dash + 1);
+    int first;
+    int last;
+    try {
+      size_t first_used;
+      size_t last_used;
+      first = std::stoi(first_text, &first_used);
+      last = std::stoi(last_text, &last_used);
+      if (first_used != first_text.size() || last_used != last_text.size()) {
+        return false;
+      }
+    } catch (const std::exception&) {
+      return false;
+    }
+    if (first < 0 || last < first || last >= CPU_SETSIZE) {
+      return false;
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      CPU_SET(cpu, cpus);
+    }
+  }
+  return CPU_COUNT(cpus) > 0;
+}
+
+bool CpuSetsOverlap(const cpu_set_t& a, const cpu_set_t& b) {
+  cpu_set_t both;
+  CPU_AND(&both, &a, &b);
+  return CPU_COUNT(&both) > 0;
+}
+
+bool PinToCpus(pid_t pid, const cpu_set_t& cpus, std::string* error) {
+  if (sched_setaffinity(pid, sizeof(cpus), &cpus) < 0) {
+    *error = std::string("无法绑定CPU: ") + strerror(errno);
+    return false;
+  }
+  return true;
+}
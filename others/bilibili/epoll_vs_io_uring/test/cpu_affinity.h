@@ -0,0 +1,21 @@
+// 把进程绑定到指定的CPU
+#ifndef CPU_AFFINITY_H_
+#define CPU_AFFINITY_H_
+
+#include <sched.h>
+#include <sys/types.h>
+
+#include <string>
+
+// 解析CPU列表，格式与taskset -c相同，如0-3,8,10-11；格式错误、
+// 编号超出范围或列表为空时返回false
+bool ParseCpuList(const std::string& text, cpu_set_t* cpus);
+
+// 两组CPU是否有重叠
+bool CpuSetsOverlap(const cpu_set_t& a, const cpu_set_t& b);
+
+// 把进程绑定到cpus，pid为0表示调用者所在的线程，之后创建的线程和
+// fork的子进程都继承这个设置；失败时输出原因到*error
+bool PinToCpus(pid_t pid, const cpu_set_t& cpus, std::string* error);
+
+#endif  // CPU_AFFINITY_H_
@@ -0,0 +1,444 @@
+// 基于epoll的事件驱动压测引擎实现
+#include "event_engine.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace {
+
+// 发送晚于计划这么久才算作晚发，排除定时器唤醒本身的误差
+const uint64_t kLateThresholdNs = 1000000;
+
+// 单调时钟，纳秒
+uint64_t NowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+}  // namespace
+
+EventEngine::EventEngine(const EngineOptions& options, WorkerStats* stats)
+    : options_(options),
+      epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      timer_fd_(-1),
+      timer_deadline_(0),
+      stats_(stats),
+      rng_(options.seed),
+      sequence_(0),
+      open_loop_(false),
+      active_(0) {
+  memset(&addr_, 0, sizeof(addr_));
+  addr_.sin_family = AF_INET;
+  addr_.sin_port = htons(options_.port);
+  inet_pton(AF_INET, options_.ip.c_str(), &addr_.sin_addr);
+
+  conns_.reserve(options_.connections);
+  for (int i = 0; i < options_.connections; ++i) {
+    conns_.push_back(std::make_unique<Connection>());
+    conns_.back()->parser.KeepBody(options_.scenario->HasSequence());
+  }
+}
+
+EventEngine::~EventEngine() {
+  for (auto& conn : conns_) {
+    CloseConnection(conn.get());
+  }
+  if (timer_fd_ >= 0) {
+    close(timer_fd_);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+void EventEngine::RunClosedLoop() {
+  open_loop_ = false;
+  active_ = 0;
+  for (auto& conn : conns_) {
+    conn->remaining = options_.requests_per_client;
+    ++active_;
+  }
+  for (auto& conn : conns_) {
+    OnIdle(conn.get());
+  }
+
+  while (active_ > 0) {
+    Poll(-1);
+  }
+}
+
+void EventEngine::RunOpenLoop(ArrivalSchedule schedule, uint64_t start_ns) {
+  open_loop_ = true;
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev);
+
+  // 连接在第一次被用到时才建立
+  for (auto& conn : conns_) {
+    idle_.push_back(conn.get());
+  }
+
+  uint64_t next;
+  bool has_next = schedule.Next(&next);
+  for (;;) {
+    // 到期的计划请求先排队，再交给空闲的连接
+    uint64_t now = NowNanos();
+    while (has_next && start_ns + next <= now) {
+      pending_.push_back(start_ns + next);
+      has_next = schedule.Next(&next);
+    }
+    while (!pending_.empty() && !idle_.empty()) {
+      Connection* conn = idle_.back();
+      idle_.pop_back();
+      OnIdle(conn);
+    }
+
+    if (!has_next && pending_.empty() && idle_.size() == conns_.size()) {
+      break;
+    }
+
+    // 定时器设到下一个计划时刻，到期前只处理连接上的事件
+    if (has_next && timer_deadline_ != start_ns + next) {
+      timer_deadline_ = start_ns + next;
+      struct itimerspec spec;
+      memset(&spec, 0, sizeof(spec));
+      spec.it_value.tv_sec = timer_deadline_ / 1000000000ULL;
+      spec.it_value.tv_nsec = timer_deadline_ % 1000000000ULL;
+      timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+    Poll(-1);
+  }
+}
+
+bool EventEngine::StartRequest(Connection* conn, uint64_t intended_ns,
+                               int count) {
+  conn->begin_ns = intended_ns;
+  conn->in_flight = count;
+  conn->received = 0;
+  conn->picked.clear();
+  if (intended_ns > 0 && NowNanos() - intended_ns > kLateThresholdNs) {
+    stats_->late++;
+  }
+
+  // 未连接时先建立连接，可写后再发送
+  if (conn->fd < 0) {
+    if (!Connect(conn)) {
+      stats_->fail += count;
+      return false;
+    }
+    conn->state = State::kConnecting;
+    return true;
+  }
+
+  if (!BeginSend(conn)) {
+    FinishRequest(conn, false);
+    return false;
+  }
+  return true;
+}
+
+bool EventEngine::Connect(Connection* conn) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  // 请求很小，不等待合并，立即发送
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if (connect(fd, (struct sockaddr*)&addr_, sizeof(addr_)) < 0 &&
+      errno != EINPROGRESS) {
+    close(fd);
+    return false;
+  }
+
+  // 边沿触发同时关注可读和可写，之后不再修改
+  struct epoll_event ev;
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.ptr = conn;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    close(fd);
+    return false;
+  }
+
+  conn->fd = fd;
+  conn->sent_on_connection = 0;
+  return true;
+}
+
+bool EventEngine::BeginSend(Connection* conn) {
+  // 达到复用次数或闭环模式下的最后一批请求要求服务器关闭连接
+  conn->sent_on_connection += conn->in_flight;
+  conn->last = (options_.requests_per_connection > 0 &&
+                conn->sent_on_connection >= options_.requests_per_connection) ||
+               (!open_loop_ && conn->remaining == 0);
+
+  // 按场景为这批请求逐个选择模板；单个不带序号的请求直接发送模板，
+  // 否则把这批请求拼在一起一次写出
+  conn->first_sequence = sequence_;
+  for (int i = 0; i < conn->in_flight; ++i) {
+    conn->picked.push_back(options_.scenario->Pick(&rng_));
+  }
+  const RequestTemplate& first = *conn->picked[0].request;
+  if (conn->in_flight == 1 && !first.HasSequence()) {
+    conn->request = &first.Get(!conn->last);
+  } else {
+    conn->batch.clear();
+    for (int i = 0; i < conn->in_flight; ++i) {
+      conn->picked[i].request->Append(
+          sequence_++, !(conn->last && i == conn->in_flight - 1),
+          &conn->batch);
+    }
+    conn->request = &conn->batch;
+  }
+  conn->sent = 0;
+  conn->parser.Reset();
+  conn->state = State::kSending;
+  if (conn->begin_ns == 0) {
+    conn->begin_ns = NowNanos();
+  }
+  return TrySend(conn);
+}
+
+void EventEngine::HandleEvent(Connection* conn, uint32_t events) {
+  bool readable = events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+  bool writable = events & (EPOLLOUT | EPOLLHUP | EPOLLERR);
+
+  switch (conn->state) {
+    case State::kIdle:
+      // 空闲连接可读说明服务器关闭了keep-alive连接，下次使用时重新连接
+      if (readable) {
+        CloseConnection(conn);
+      }
+      return;
+
+    case State::kConnecting: {
+      if (!writable) {
+        return;
+      }
+      int error = 0;
+      socklen_t len = sizeof(error);
+      getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+      if (error != 0) {
+        FinishRequest(conn, false);
+        OnIdle(conn);
+        return;
+      }
+      stats_->connections++;
+      if (!BeginSend(conn)) {
+        FinishRequest(conn, false);
+        OnIdle(conn);
+      }
+      return;
+    }
+
+    case State::kSending:
+    case State::kReceiving: {
+      // 流水线的一批请求较大时，服务器可能在请求发完之前就开始回答，
+      // 发送时也要读取响应，避免双方都因缓冲区满而停住
+      bool ok = true;
+      if (conn->state == State::kSending && writable) {
+        ok = TrySend(conn);
+      }
+      if (ok && readable) {
+        ok = TryReceive(conn);
+      }
+      if (!ok) {
+        FinishRequest(conn, false);
+        OnIdle(conn);
+      } else if (conn->received == conn->in_flight) {
+        FinishRequest(conn, true);
+        OnIdle(conn);
+      }
+      return;
+    }
+  }
+}
+
+bool EventEngine::TrySend(Connection* conn) {
+  const std::string& request = *conn->request;
+  while (conn->sent < request.size()) {
+    ssize_t n = write(conn->fd, request.data() + conn->sent,
+                      request.size() - conn->sent);
+    stats_->syscalls++;
+    if (n > 0) {
+      conn->sent += n;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else if (n < 0 && errno == EAGAIN) {
+      // 发送缓冲区满，等可写事件
+      return true;
+    } else {
+      return false;
+    }
+  }
+  conn->state = State::kReceiving;
+  return true;
+}
+
+bool EventEngine::TryReceive(Connection* conn) {
+  // 边沿触发，读到EAGAIN或这批响应收齐为止；一次读到的数据可能包含多个响应
+  while (conn->received < conn->in_flight) {
+    ssize_t n = read(conn->fd, buffer_, sizeof(buffer_));
+    stats_->syscalls++;
+    if (n == 0) {
+      // 对端关闭，没有长度的响应到此结束
+      conn->parser.OnEof();
+      CloseConnection(conn);
+      if (!conn->parser.IsComplete()) {
+        return false;
+      }
+      RecordResponse(conn);
+      return conn->received == conn->in_flight;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN;
+    }
+
+    size_t offset = 0;
+    while (offset < static_cast<size_t>(n)) {
+      offset += conn->parser.Feed(buffer_ + offset, n - offset);
+      if (conn->parser.HasError()) {
+        return false;
+      }
+      if (!conn->parser.IsComplete()) {
+        break;
+      }
+
+      // 最后一个响应之后不应再有数据，之前的响应不应要求关闭连接
+      RecordResponse(conn);
+      if (conn->received == conn->in_flight) {
+        return offset == static_cast<size_t>(n);
+      }
+      if (conn->parser.ShouldClose()) {
+        return false;
+      }
+      conn->parser.Reset();
+    }
+  }
+  return true;
+}
+
+void EventEngine::RecordResponse(Connection* conn) {
+  uint64_t end = NowNanos();
+  const PickedRequest& picked = conn->picked[conn->received];
+  int status = conn->parser.GetStatusCode();
+  stats_->RecordResponse(picked.entry, end, end - conn->begin_ns, status);
+
+  // 2xx响应体中应有对应请求的序号，否则说明响应与请求错位；
+  // 限速、过载等错误响应不回显路径，不检查
+  if (status >= 200 && status < 300 && picked.request->HasSequence() &&
+             conn->parser.GetBody().find(RequestTemplate::FormatSequence(
+                 conn->first_sequence + conn->received)) ==
+                 std::string::npos) {
+    stats_->misordered++;
+  }
+  ++conn->received;
+}
+
+void EventEngine::FinishRequest(Connection* conn, bool success) {
+  if (success) {
+    if (conn->last || conn->parser.ShouldClose()) {
+      CloseConnection(conn);
+    }
+  } else {
+    // 连接没有建立时还没有选择请求，只计入总的失败数
+    for (int i = conn->received; i < conn->in_flight; ++i) {
+      if (i < static_cast<int>(conn->picked.size())) {
+        stats_->RecordFailure(conn->picked[i].entry);
+      } else {
+        stats_->fail++;
+      }
+    }
+    CloseConnection(conn);
+  }
+  conn->state = State::kIdle;
+}
+
+void EventEngine::OnIdle(Connection* conn) {
+  // 请求在开始时就失败（连接失败等）时继续安排下一个，与阻塞客户端一致
+  for (;;) {
+    uint64_t intended = 0;
+    int count = 1;
+    if (open_loop_) {
+      if (pending_.empty()) {
+        idle_.push_back(conn);
+        return;
+      }
+      intended = pending_.front();
+      pending_.pop_front();
+    } else {
+      if (options_.stop_ns > 0 && NowNanos() >= options_.stop_ns) {
+        conn->remaining = 0;
+      }
+      if (conn->remaining == 0) {
+        CloseConnection(conn);
+        --active_;
+        return;
+      }
+      // 一批请求不超过流水线深度、剩余的请求数和连接剩余的复用次数
+      count = std::min(options_.pipeline_depth, conn->remaining);
+      if (options_.requests_per_connection > 0 && conn->fd >= 0) {
+        count = std::min(count, options_.requests_per_connection -
+                                    conn->sent_on_connection);
+      } else if (options_.requests_per_connection > 0) {
+        count = std::min(count, options_.requests_per_connection);
+      }
+      conn->remaining -= count;
+    }
+
+    if (StartRequest(conn, intended, count)) {
+      return;
+    }
+  }
+}
+
+void EventEngine::CloseConnection(Connection* conn) {
+  // 关闭描述符时内核自动把它从epoll中删除
+  if (conn->fd >= 0) {
+    close(conn->fd);
+    conn->fd = -1;
+  }
+}
+
+void EventEngine::Poll(int timeout_ms) {
+  struct epoll_event events[kMaxEvents];
+  int n = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+  for (int i = 0; i < n; ++i) {
+    if (events[i].data.ptr == nullptr) {
+      uint64_t expirations;
+      ssize_t ret = read(timer_fd_, &expirations, sizeof(expirations));
+      (void)ret;
+      continue;
+    }
+    HandleEvent(static_cast<Connection*>(events[i].data.ptr),
+                events[i].events);
+  }
+}
+
+rlim_t RaiseFileLimit(rlim_t needed) {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+    return 0;
+  }
+  if (limit.rlim_cur < needed) {
+    limit.rlim_cur = limit.rlim_max < needed ? limit.rlim_max : needed;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  return limit.rlim_cur;
+}
@@ -0,0 +1,142 @@
+// 基于epoll的事件驱动压测引擎
+#ifndef EVENT_ENGINE_H_
+#define EVENT_ENGINE_H_
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "load_profile.h"
+#include "response_parser.h"
+#include "scenario.h"
+#include "worker_stats.h"
+
+// 事件驱动引擎的参数
+struct EngineOptions {
+  std::string ip;                  // 服务器IP
+  int port;                        // 服务器端口
+  const Scenario* scenario;        // 压测场景
+  uint64_t seed;                   // 选择请求的随机数种子
+  int connections;                 // 本线程的并发连接数
+  int requests_per_connection;     // 每个连接发送多少个请求后重连，0表示不限
+  int requests_per_client;         // 闭环模式下每个连接发送的请求数
+  int pipeline_depth;              // 闭环模式下一次写出的请求数
+  uint64_t stop_ns;                // 闭环模式下停止发送新请求的时刻，0表示不限
+};
+
+// 把打开文件数的软限制提高到至少needed（不超过硬限制），返回提高后的值；
+// 引擎的每个连接占用一个描述符，大量连接前先调用
+rlim_t RaiseFileLimit(rlim_t needed);
+
+// 事件驱动的压测引擎
+// 一个线程用epoll同时驱动很多个非阻塞连接，每个连接是一个独立的状态机
+// （连接中、发送中、接收中、空闲），各自记录请求的开始时刻，一个线程就能
+// 模拟成千上万个并发客户端，客户端本身不再成为瓶颈。
+// 连接注册为边沿触发的可读可写事件，建立后不再修改关注的事件。
+// 引擎只在创建它的线程中使用。
+class EventEngine {
+ public:
+  EventEngine(const EngineOptions& options, WorkerStats* stats);
+  ~EventEngine();
+
+  EventEngine(const EventEngine&) = delete;
+  EventEngine& operator=(const EventEngine&) = delete;
+
+  // 闭环：每个连接收到响应后立即发送下一批请求，直到各自发完
+  // requests_per_client个请求或到达stop_ns；每批最多pipeline_depth个请求
+  // 一次写出，延迟从开始发送这一批请求算起
+  void RunClosedLoop();
+
+  // 开环：按调度的计划时刻发送请求，交给空闲的连接，没有空闲连接时排队；
+  // 延迟从计划时刻算起。start_ns为计划时刻的起点
+  void RunOpenLoop(ArrivalSchedule schedule, uint64_t start_ns);
+
+ private:
+  static const size_t kBufferSize = 64 * 1024;  // 读缓冲区大小
+  static const int kMaxEvents = 1024;           // 每次最多处理的事件数
+
+  // 连接的状态
+  enum class State {
+    kIdle,        // 没有请求，可能已连接也可能未连接
+    kConnecting,  // 正在建立连接，建立后发送请求
+    kSending,     // 正在发送一批请求
+    kReceiving,   // 正在接收这批请求的响应
+  };
+
+  // 一个客户端连接
+  struct Connection {
+    int fd = -1;                           // 套接字描述符，未连接时为-1
+    State state = State::kIdle;            // 当前状态
+    ResponseParser parser;                 // 响应解析器
+    const std::string* request = nullptr;  // 正在发送的请求数据
+    std::string batch;                     // 流水线或带序号时生成的请求数据
+    std::vector<PickedRequest> picked;     // 这批请求各自选中的模板
+    size_t sent = 0;                       // 请求数据已发送的字节数
+    uint64_t begin_ns = 0;                 // 请求的开始时刻，计算延迟的起点
+    uint64_t first_sequence = 0;           // 这批请求的第一个序号
+    int in_flight = 0;                     // 这批请求的个数
+    int received = 0;                      // 这批请求已收到的响应数
+    int sent_on_connection = 0;            // 当前连接上发送的请求数
+    int remaining = 0;                     // 闭环模式下还要发送的请求数
+    bool last = false;                     // 是否为连接上的最后一批请求
+  };
+
+  // 为连接开始count个请求，intended_ns为0时延迟从开始发送算起
+  // 连接或发送失败时记为失败并返回false
+  bool StartRequest(Connection* conn, uint64_t intended_ns, int count);
+
+  // 发起非阻塞连接
+  bool Connect(Connection* conn);
+
+  // 开始发送这批请求，决定是否是连接上的最后一批，出错时返回false
+  bool BeginSend(Connection* conn);
+
+  // 处理连接上的事件
+  void HandleEvent(Connection* conn, uint32_t events);
+
+  // 尽量发送剩余的请求数据，出错时返回false
+  bool TrySend(Connection* conn);
+
+  // 读取并依次解析这批请求的响应，出错、响应多于请求或服务器在
+  // 这批请求中途关闭连接时返回false
+  bool TryReceive(Connection* conn);
+
+  // 记录一个完整的响应
+  void RecordResponse(Connection* conn);
+
+  // 这批请求结束，没有收到响应的记为失败，连接回到空闲状态
+  void FinishRequest(Connection* conn, bool success);
+
+  // 连接空闲后的安排：闭环模式发送下一个请求，开环模式取排队的请求，
+  // 没有请求时开环模式放回空闲列表，闭环模式关闭连接
+  void OnIdle(Connection* conn);
+
+  // 关闭连接
+  void CloseConnection(Connection* conn);
+
+  // 等待事件并处理，timeout_ms同epoll_wait
+  void Poll(int timeout_ms);
+
+  EngineOptions options_;                           // 参数
+  int epoll_fd_;                                    // epoll描述符
+  int timer_fd_;                                    // 开环模式的定时器，未用时为-1
+  uint64_t timer_deadline_;                         // 定时器设定的到期时刻
+  struct sockaddr_in addr_;                         // 服务器地址
+  WorkerStats* stats_;                              // 本线程的统计
+  std::mt19937_64 rng_;                             // 按场景选择请求
+  std::vector<std::unique_ptr<Connection>> conns_;  // 所有连接
+  std::vector<Connection*> idle_;                   // 开环模式下的空闲连接
+  std::deque<uint64_t> pending_;                    // 排队等待连接的计划时刻
+  uint64_t sequence_;                               // 下一个请求的序号
+  bool open_loop_;                                  // 是否为开环模式
+  int active_;                                      // 闭环模式下未完成的连接数
+  char buffer_[kBufferSize];                        // 读缓冲区，所有连接共用
+};
+
+#endif  // EVENT_ENGINE_H_
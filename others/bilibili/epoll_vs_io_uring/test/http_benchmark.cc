@@ -1,86 +1,451 @@
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#include <sys/socket.h>
-#include <unistd.h>
+// HTTP压力测试客户端
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
 
-#include <atomic>
+#include <algorithm>
 #include <chrono>
-#include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
-// 原子计数器，用于统计成功的请求数
-std::atomic<int> success_count(0);
-std::atomic<int> fail_count(0);
+#include "cpu_affinity.h"
+#include "event_engine.h"
+#include "http_client.h"
+#include "idle_connections.h"
+#include "latency_histogram.h"
+#include "load_profile.h"
+#include "load_runner.h"
+#include "perf_counters.h"
+#include "process_stats.h"
+#include "report_format.h"
+#include "request_template.h"
+#include "scenario.h"
+#include "worker_stats.h"
 
-// 发送HTTP请求并接收响应
-bool SendHttpRequest(const std::string& ip, int port, const std::string& path) {
-  // 创建套接字
-  int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-  if (sockfd < 0) {
-    return false;
+// 单调时钟，纳秒
+uint64_t NowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// 睡眠到单调时钟的指定时刻
+void SleepUntil(uint64_t deadline_ns) {
+  struct timespec ts;
+  ts.tv_sec = deadline_ns / 1000000000ULL;
+  ts.tv_nsec = deadline_ns % 1000000000ULL;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
   }
+}
 
-  // 设置服务器地址
-  struct sockaddr_in server_addr;
-  memset(&server_addr, 0, sizeof(server_addr));
-  server_addr.sin_family = AF_INET;
-  server_addr.sin_port = htons(port);
-  inet_pton(AF_INET, ip.c_str(), &server_addr.sin_addr);
+// 工作线程函数
+// 每个连接发送requests_per_connection个请求后关闭，为0时整个线程只用一个连接；
+// 为1时每个请求新建连接，测量的主要是内核建立连接的开销。
+// pipeline_depth大于1时一次写出多个请求再依次读取响应，每个请求的延迟
+// 从写出这一批请求前算起。每个请求按场景的权重随机选择，seed为随机数种子
+void WorkerThread(const Scenario& scenario,
+                  uint64_t seed,
+                  const std::string& ip,
+                  int port,
+                  int requests_per_thread,
+                  int requests_per_connection,
+                  int pipeline_depth,
+                  WorkerStats* stats) {
+  HttpClient client(ip, port);
+  client.KeepBody(scenario.HasSequence());
+  std::mt19937_64 rng(seed);
 
-  // 连接服务器
-  if (connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr)) <
-      0) {
-    close(sockfd);
-    return false;
-  }
+  // 回调在循环外构造一次，通过引用读取当前批次的信息
+  std::string batch;
+  std::vector<PickedRequest> picked;
+  uint64_t sequence = 0;
+  uint64_t first_sequence = 0;
+  uint64_t begin = 0;
+  int received = 0;
+  HttpClient::ResponseCallback on_response =
+      [&](int index, const ResponseParser& response) {
+        uint64_t end = NowNanos();
+        int status = response.GetStatusCode();
+        stats->RecordResponse(picked[index].entry, end, end - begin, status);
+        ++received;
+
+        // 限速、过载等错误响应不回显路径，只检查2xx响应的顺序
+        if (status >= 200 && status < 300 &&
+            picked[index].request->HasSequence() &&
+                   response.GetBody().find(RequestTemplate::FormatSequence(
+                       first_sequence + index)) == std::string::npos) {
+          stats->misordered++;
+        }
+      };
+
+  int sent_on_connection = 0;
+  int remaining = requests_per_thread;
+  while (remaining > 0) {
+    // 连接被关闭（达到复用次数、服务器要求关闭或出错）时重新连接
+    if (!client.IsConnected()) {
+      if (!client.Connect()) {
+        stats->fail++;
+        --remaining;
+        continue;
+      }
+      stats->connections++;
+      sent_on_connection = 0;
+    }
+
+    // 一批请求不超过流水线深度、剩余的请求数和连接剩余的复用次数
+    int count = std::min(pipeline_depth, remaining);
+    if (requests_per_connection > 0) {
+      count = std::min(count, requests_per_connection - sent_on_connection);
+    }
+    sent_on_connection += count;
+    remaining -= count;
 
-  // 构造HTTP请求
-  std::string request = "GET " + path + " HTTP/1.1\r\n";
-  request += "Host: " + ip + ":" + std::to_string(port) + "\r\n";
-  request += "Connection: close\r\n";
-  request += "\r\n";
+    // 连接的最后一个请求告诉服务器关闭连接
+    bool last = remaining == 0 ||
+                (requests_per_connection > 0 &&
+                 sent_on_connection >= requests_per_connection);
+
+    batch.clear();
+    picked.clear();
+    first_sequence = sequence;
+    for (int i = 0; i < count; ++i) {
+      picked.push_back(scenario.Pick(&rng));
+      picked.back().request->Append(sequence++, !(last && i == count - 1),
+                                    &batch);
+    }
 
-  // 发送请求
-  if (write(sockfd, request.c_str(), request.size()) !=
-      static_cast<ssize_t>(request.size())) {
-    close(sockfd);
-    return false;
+    // 延迟从发送请求前开始计时，到读完整个响应为止
+    begin = NowNanos();
+    received = 0;
+    client.Pipeline(batch, count, on_response);
+    for (int i = received; i < count; ++i) {
+      stats->RecordFailure(picked[i].entry);
+    }
+
+    if (last) {
+      client.Close();
+    }
   }
+  stats->syscalls += client.GetSyscalls();
+}
 
-  // 接收响应
-  char buffer[4096];
-  ssize_t bytes_read = read(sockfd, buffer, sizeof(buffer) - 1);
+// 开环工作线程
+// 按调度的计划时刻发送请求，服务器变慢时不减少发送，延迟从计划时刻算起，
+// 包含请求在客户端等待发送的时间，能反映服务器排队造成的延迟。
+// 每个线程同一时刻只有一个请求在途，上一个请求还没完成时后面的请求
+// 晚于计划发送并计入late；线程数应足够覆盖目标速率乘以正常延迟。
+void OpenLoopWorker(const Scenario& scenario,
+                    uint64_t seed,
+                    const std::string& ip,
+                    int port,
+                    int requests_per_connection,
+                    ArrivalSchedule schedule,
+                    uint64_t start_ns,
+                    WorkerStats* stats) {
+  // 发送晚于计划这么久才算作晚发，排除定时器唤醒本身的误差
+  const uint64_t kLateThresholdNs = 1000000;
 
-  // 关闭套接字
-  close(sockfd);
+  HttpClient client(ip, port);
+  std::mt19937_64 rng(seed);
+  std::string batch;
+  int sent_on_connection = 0;
+  uint64_t sequence = 0;
+  uint64_t send_ns;
+  while (schedule.Next(&send_ns)) {
+    uint64_t intended = start_ns + send_ns;
+    uint64_t now = NowNanos();
+    if (now < intended) {
+      SleepUntil(intended);
+    } else if (now - intended > kLateThresholdNs) {
+      stats->late++;
+    }
+
+    if (!client.IsConnected()) {
+      if (!client.Connect()) {
+        stats->fail++;
+        continue;
+      }
+      stats->connections++;
+      sent_on_connection = 0;
+    }
+
+    ++sent_on_connection;
+    bool last = requests_per_connection > 0 &&
+                sent_on_connection >= requests_per_connection;
+    PickedRequest picked = scenario.Pick(&rng);
+    bool ok;
+    if (picked.request->HasSequence()) {
+      batch.clear();
+      picked.request->Append(sequence++, !last, &batch);
+      ok = client.RoundTrip(batch);
+    } else {
+      ok = client.RoundTrip(picked.request->Get(!last));
+    }
+    if (ok) {
+      uint64_t end = NowNanos();
+      stats->RecordResponse(picked.entry, end, end - intended,
+                            client.GetResponse().GetStatusCode());
+    } else {
+      stats->RecordFailure(picked.entry);
+    }
 
-  // 检查是否成功接收到响应
-  if (bytes_read <= 0) {
-    return false;
+    if (last) {
+      client.Close();
+    }
+  }
+  stats->syscalls += client.GetSyscalls();
+}
+
+// 事件驱动工作线程：一个线程用EventEngine同时驱动options.connections个连接
+void EventWorker(const EngineOptions& options,
+                 bool open_loop,
+                 ArrivalSchedule schedule,
+                 uint64_t start_ns,
+                 WorkerStats* stats) {
+  EventEngine engine(options, stats);
+  if (open_loop) {
+    engine.RunOpenLoop(schedule, start_ns);
+  } else {
+    engine.RunClosedLoop();
   }
+}
+
+// 输出服务器进程在压测期间的资源占用，按请求数归一化
+void PrintServerResources(int pid,
+                          const ProcessSample& begin,
+                          const ProcessSample& end,
+                          double seconds,
+                          uint64_t requests,
+                          const PerfCounters* perf,
+                          const PerfCounters::Reading& perf_begin,
+                          const PerfCounters::Reading& perf_end) {
+  double user = (end.user_ns - begin.user_ns) / 1e9;
+  double sys = (end.sys_ns - begin.sys_ns) / 1e9;
+  double per_request = requests > 0 ? 1e6 / requests : 0;
+  uint64_t voluntary = end.voluntary_switches - begin.voluntary_switches;
+  uint64_t involuntary = end.involuntary_switches - begin.involuntary_switches;
+  uint64_t switches = voluntary + involuntary;
+  char line[256];
 
-  // 确保响应以null结尾
-  buffer[bytes_read] = '\0';
+  std::cout << "\n服务器资源（进程 " << pid << "）:" << std::endl;
+  snprintf(line, sizeof(line),
+           "  CPU: 用户态 %.3f 秒，内核态 %.3f 秒，平均占用 %.1f%%", user, sys,
+           seconds > 0 ? (user + sys) / seconds * 100 : 0);
+  std::cout << line << std::endl;
+  snprintf(line, sizeof(line),
+           "  每请求CPU: %.2f 微秒（用户态 %.2f，内核态 %.2f）",
+           (user + sys) * per_request, user * per_request, sys * per_request);
+  std::cout << line << std::endl;
+  snprintf(line, sizeof(line),
+           "  上下文切换: 主动 %llu，被动 %llu，每请求 %.4f",
+           static_cast<unsigned long long>(voluntary),
+           static_cast<unsigned long long>(involuntary),
+           requests > 0 ? static_cast<double>(switches) / requests : 0);
+  std::cout << line << std::endl;
+  std::cout << "  常驻内存: " << end.rss_kb << " KB，峰值 " << end.peak_kb
+            << " KB，线程数 " << end.threads << std::endl;
 
-  // 检查是否是HTTP响应
-  return strstr(buffer, "HTTP/1.1") != nullptr;
+  if (perf == nullptr) {
+    return;
+  }
+  double counts[PerfCounters::kNumCounters];
+  for (int i = 0; i < PerfCounters::kNumCounters; ++i) {
+    PerfCounters::Counter counter = static_cast<PerfCounters::Counter>(i);
+    counts[i] = static_cast<double>(perf_end.values[i] - perf_begin.values[i]);
+    if (perf->IsAvailable(counter) && requests > 0) {
+      snprintf(line, sizeof(line), "  每请求%s: %.2f",
+               PerfCounters::GetName(counter), counts[i] / requests);
+      std::cout << line << std::endl;
+    }
+  }
+  if (perf->IsAvailable(PerfCounters::kInstructions) &&
+      perf->IsAvailable(PerfCounters::kCycles) &&
+      counts[PerfCounters::kCycles] > 0) {
+    snprintf(line, sizeof(line), "  每周期指令数: %.2f",
+             counts[PerfCounters::kInstructions] /
+                 counts[PerfCounters::kCycles]);
+    std::cout << line << std::endl;
+  }
+  if (perf->IsUserOnly()) {
+    std::cout << "  （没有权限统计内核态，硬件计数器只包含用户态）"
+              << std::endl;
+  }
+  if (!perf->GetError().empty()) {
+    std::cout << "  部分性能计数器不可用: " << perf->GetError() << std::endl;
+  }
 }
 
-// 工作线程函数
-void WorkerThread(const std::string& ip,
-                  int port,
-                  const std::string& path,
-                  int requests_per_thread) {
-  for (int i = 0; i < requests_per_thread; ++i) {
-    if (SendHttpRequest(ip, port, path)) {
-      success_count++;
-    } else {
-      fail_count++;
+// 空闲连接测试中的一档
+struct IdleStep {
+  int target;        // 目标空闲连接数
+  size_t open;       // 压测结束时仍然存活的空闲连接数
+  uint64_t rss_kb;   // 建立空闲连接后服务器的常驻内存，0表示未采样
+  double qps;        // 活跃连接的QPS
+  uint64_t p50_ns;   // 活跃请求的延迟分位数
+  uint64_t p99_ns;
+  uint64_t p999_ns;
+};
+
+// 空闲连接可扩展性测试
+// 逐档增加空闲的长连接（建立后可选地先完成一个请求，然后不再发送任何数据），
+// 每一档在保持这些连接的同时用active的参数闭环压测duration_ns，观察服务器
+// 的内存和活跃请求的延迟随空闲连接数的变化。空闲连接从127.0.0.2开始的
+// source_ips个源地址轮流发起，突破单个源地址的本地端口数限制
+int RunIdleTest(const EngineOptions& active, int num_threads,
+                uint64_t duration_ns, std::vector<int> targets,
+                int source_ips, bool warm_request, int server_pid) {
+  // 每个源地址约有28000个本地端口，按每个地址不超过25000个连接分配
+  const int kConnectionsPerSource = 25000;
+  // 建立一档空闲连接的超时
+  const int kGrowTimeoutMs = 60000;
+
+  std::sort(targets.begin(), targets.end());
+  int max_target = std::max(targets.back(), 0);
+  if (source_ips <= 0) {
+    source_ips = max_target / kConnectionsPerSource + 1;
+  }
+
+  // 空闲连接、活跃连接和正在建立的连接各占一个描述符
+  rlim_t needed = static_cast<rlim_t>(max_target) + active.connections +
+                  IdleConnectionPool::kMaxPending + 64;
+  rlim_t limit = RaiseFileLimit(needed);
+  if (limit < needed) {
+    std::cerr << "警告: 打开文件数限制为 " << limit << "，不足以保持 "
+              << max_target << " 个空闲连接" << std::endl;
+  }
+
+  std::string request;
+  if (warm_request) {
+    active.scenario->GetEntries()[0].templates[0].Append(0, true, &request);
+  }
+  IdleConnectionPool pool(active.ip, active.port, request, source_ips);
+
+  std::cout << "空闲连接测试: 源地址 " << source_ips << " 个，活跃连接 "
+            << active.connections << " 个，每档压测 " << duration_ns / 1e9
+            << " 秒" << std::endl;
+  std::cout << "空闲连接"
+            << (warm_request ? "建立后先完成一个请求再保持空闲"
+                             : "建立后不发送任何请求")
+            << std::endl;
+
+  // 基准内存在建立任何空闲连接之前读取
+  ProcessSample base = {};
+  if (server_pid > 0 && !ReadProcessSample(server_pid, &base)) {
+    std::cerr << "无法读取服务器进程 " << server_pid << " 的资源占用"
+              << std::endl;
+    return 1;
+  }
+
+  // 服务器默认的打开文件数限制往往只有1024，描述符用尽后连活跃连接也
+  // 无法建立，压测会一直等到超时，所以提前报错
+  rlim_t server_needed =
+      static_cast<rlim_t>(max_target) + active.connections + 64;
+  struct rlimit server_limit;
+  if (server_pid > 0 &&
+      prlimit(server_pid, RLIMIT_NOFILE, nullptr, &server_limit) == 0 &&
+      server_limit.rlim_cur < server_needed) {
+    std::cerr << "错误: 服务器的打开文件数限制为 " << server_limit.rlim_cur
+              << "，不足以保持 " << max_target << " 个空闲连接；"
+              << "请用 --max-open-files " << server_needed << " 启动服务器"
+              << std::endl;
+    return 1;
+  }
+
+  // 被503拒绝说明服务器开启了连接数上限，继续测下去测的只是拒绝的开销
+  auto rejected = [&pool]() {
+    if (pool.GetRejected() == 0) {
+      return false;
     }
+    std::cerr << "错误: 服务器以503拒绝了 " << pool.GetRejected()
+              << " 个空闲连接，已达到它的最大连接数；"
+              << "请不带 --max-connections 或用更大的值启动服务器"
+              << std::endl;
+    return true;
+  };
+
+  std::vector<IdleStep> steps;
+  for (int target : targets) {
+    IdleStep step = {};
+    step.target = target;
+    std::cout << "建立空闲连接到 " << target << " ..." << std::flush;
+    pool.Grow(std::max(target, 0), kGrowTimeoutMs);
+    std::cout << " 存活 " << pool.Check() << std::endl;
+    if (rejected()) {
+      return 1;
+    }
+
+    ProcessSample sample;
+    if (server_pid > 0 && ReadProcessSample(server_pid, &sample)) {
+      step.rss_kb = sample.rss_kb;
+    }
+
+    LoadResult load = RunTimedLoad(active, num_threads, duration_ns, 0);
+    const WorkerStats& stats = *load.stats;
+    step.open = pool.Check();
+    if (rejected()) {
+      return 1;
+    }
+    step.qps = load.seconds > 0 ? stats.success / load.seconds : 0;
+    step.p50_ns = stats.latency.GetPercentile(50);
+    step.p99_ns = stats.latency.GetPercentile(99);
+    step.p999_ns = stats.latency.GetPercentile(99.9);
+    steps.push_back(step);
   }
+
+  // 每连接字节数按建立空闲连接前后的常驻内存之差计算，不含内核中的
+  // 套接字缓冲区等内存；p99增幅相对第一档
+  std::cout << "\n空闲连接测试结果（延迟单位毫秒）:" << std::endl;
+  std::cout << "  " << PadLeft("目标", 8) << PadLeft("存活", 8)
+            << PadLeft("服务器RSS(KB)", 14) << PadLeft("每连接字节", 12)
+            << PadLeft("QPS", 10) << PadLeft("p50", 9) << PadLeft("p99", 9)
+            << PadLeft("p99.9", 9) << PadLeft("p99增幅", 9) << std::endl;
+  for (const IdleStep& step : steps) {
+    std::string rss = "-";
+    std::string per_connection = "-";
+    if (step.rss_kb > 0) {
+      rss = std::to_string(step.rss_kb);
+      if (step.open > 0 && step.rss_kb >= base.rss_kb) {
+        per_connection =
+            std::to_string((step.rss_kb - base.rss_kb) * 1024 / step.open);
+      }
+    }
+    char growth[16];
+    snprintf(growth, sizeof(growth), "%+.0f%%",
+             steps[0].p99_ns > 0
+                 ? (static_cast<double>(step.p99_ns) / steps[0].p99_ns - 1) *
+                       100
+                 : 0.0);
+    std::cout << "  " << PadLeft(std::to_string(step.target), 8)
+              << PadLeft(std::to_string(step.open), 8) << PadLeft(rss, 14)
+              << PadLeft(per_connection, 12)
+              << PadLeft(std::to_string(static_cast<uint64_t>(step.qps)), 10)
+              << PadLeft(FormatMillis(step.p50_ns), 9)
+              << PadLeft(FormatMillis(step.p99_ns), 9)
+              << PadLeft(FormatMillis(step.p999_ns), 9) << PadLeft(growth, 9)
+              << std::endl;
+  }
+  if (server_pid > 0) {
+    std::cout << "  建立空闲连接前服务器RSS: " << base.rss_kb << " KB"
+              << std::endl;
+  }
+
+  // 连接数超过服务器的准入上限或描述符限制时，多出的连接会被拒绝或关闭
+  std::cout << "建立失败的空闲连接: " << pool.GetFailed()
+            << "，被服务器关闭: " << pool.GetClosed() << std::endl;
+  if (pool.GetFailed() > 0 || pool.GetClosed() > 0) {
+    std::cout << "（检查服务器的打开文件数限制，可用 --max-open-files 提高）"
+              << std::endl;
+  }
+  return 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -88,8 +453,39 @@ int main(int argc, char* argv[]) {
   std::string ip = "127.0.0.1";
   int port = 8080;
   std::string path = "/";
+  std::string scenario_file;
   int num_threads = 10;
   int requests_per_thread = 100;
+  int requests_per_connection = 1;
+  int expected_interval_us = 0;
+  int series_interval_ms = 1000;
+  int pipeline_depth = 1;
+
+  // 被测服务器的进程号，指定时采样它的资源占用，perf为真时另外读取性能计数器
+  int server_pid = 0;
+  bool perf = false;
+
+  // 压测客户端绑定的CPU，为空时不绑定；应与服务器使用的CPU错开
+  std::string cpu_list;
+
+  // 事件驱动引擎的参数，connections为0时与线程数相同
+  bool event_engine = false;
+  int num_connections = 0;
+
+  // 空闲连接测试的各档连接数，不为空时只运行空闲连接测试；
+  // 源地址数为0时按连接数自动选择
+  std::vector<int> idle_targets;
+  int idle_source_ips = 0;
+  bool idle_request = true;
+
+  // 开环模式的参数，rate为0时使用闭环模式
+  LoadProfile profile;
+  profile.duration_seconds = 10;
+  ArrivalProcess arrival = ArrivalProcess::kConstant;
+
+  // 服务器关闭连接（如超过最大连接数）后再写入会收到SIGPIPE，
+  // 忽略它，让写入返回EPIPE按失败处理
+  signal(SIGPIPE, SIG_IGN);
 
   // 解析命令行参数
   for (int i = 1; i < argc; i += 2) {
@@ -101,19 +497,181 @@ int main(int argc, char* argv[]) {
         port = std::stoi(argv[i + 1]);
       } else if (arg == "--path") {
         path = argv[i + 1];
+      } else if (arg == "--scenario") {
+        scenario_file = argv[i + 1];
       } else if (arg == "--threads" || arg == "-t") {
         num_threads = std::stoi(argv[i + 1]);
       } else if (arg == "--requests" || arg == "-r") {
         requests_per_thread = std::stoi(argv[i + 1]);
+      } else if (arg == "--requests-per-connection" || arg == "-k") {
+        requests_per_connection = std::stoi(argv[i + 1]);
+      } else if (arg == "--pipeline-depth") {
+        pipeline_depth = std::max(1, std::stoi(argv[i + 1]));
+      } else if (arg == "--expected-interval-us") {
+        expected_interval_us = std::stoi(argv[i + 1]);
+      } else if (arg == "--series-interval-ms") {
+        series_interval_ms = std::stoi(argv[i + 1]);
+      } else if (arg == "--rate") {
+        profile.rate = std::stod(argv[i + 1]);
+      } else if (arg == "--ramp-to") {
+        profile.ramp_to = std::stod(argv[i + 1]);
+      } else if (arg == "--step") {
+        profile.step = std::stod(argv[i + 1]);
+      } else if (arg == "--step-seconds") {
+        profile.step_seconds = std::stod(argv[i + 1]);
+      } else if (arg == "--duration" || arg == "-d") {
+        profile.duration_seconds = std::stod(argv[i + 1]);
+      } else if (arg == "--engine") {
+        std::string engine = argv[i + 1];
+        if (engine != "blocking" && engine != "epoll") {
+          std::cerr << "未知的引擎: " << engine << "（可选 blocking、epoll）"
+                    << std::endl;
+          return 1;
+        }
+        event_engine = engine == "epoll";
+      } else if (arg == "--connections" || arg == "-c") {
+        num_connections = std::stoi(argv[i + 1]);
+      } else if (arg == "--server-pid") {
+        server_pid = std::stoi(argv[i + 1]);
+      } else if (arg == "--perf") {
+        perf = std::string(argv[i + 1]) == "on";
+      } else if (arg == "--cpus") {
+        cpu_list = argv[i + 1];
+      } else if (arg == "--idle-connections") {
+        // 逗号分隔的各档连接数，如0,10000,50000,100000
+        std::istringstream in(argv[i + 1]);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+          idle_targets.push_back(std::stoi(item));
+        }
+      } else if (arg == "--idle-source-ips") {
+        idle_source_ips = std::stoi(argv[i + 1]);
+      } else if (arg == "--idle-request") {
+        idle_request = std::string(argv[i + 1]) == "on";
+      } else if (arg == "--arrival") {
+        if (!ParseArrivalProcess(argv[i + 1], &arrival)) {
+          std::cerr << "未知的到达过程: " << argv[i + 1]
+                    << "（可选 constant、poisson）" << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+
+  // 在创建任何线程之前绑定，工作线程都继承
+  if (!cpu_list.empty()) {
+    cpu_set_t cpus;
+    std::string error;
+    if (!ParseCpuList(cpu_list, &cpus)) {
+      std::cerr << "CPU列表无效: " << cpu_list << std::endl;
+      return 1;
+    }
+    if (!PinToCpus(0, cpus, &error)) {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+    if (server_pid > 0) {
+      cpu_set_t server_cpus;
+      int ret = sched_getaffinity(server_pid, sizeof(server_cpus),
+                                  &server_cpus);
+      if (ret == 0 && CpuSetsOverlap(cpus, server_cpus)) {
+        std::cerr << "警告: 客户端与服务器进程 " << server_pid
+                  << " 可用的CPU有重叠，测量会互相干扰" << std::endl;
       }
     }
   }
 
+  // 所有线程共用的场景，未指定场景文件时只有一个对path的GET请求
+  std::unique_ptr<Scenario> scenario;
+  if (scenario_file.empty()) {
+    scenario = std::make_unique<Scenario>(ip, port, path);
+  } else {
+    std::string error;
+    scenario = Scenario::Load(scenario_file, ip, port, &error);
+    if (!scenario) {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+  }
+  const std::vector<Scenario::Entry>& entries = scenario->GetEntries();
+
+  // 空闲连接测试的活跃负载总是用事件驱动引擎，按时长闭环压测
+  if (!idle_targets.empty()) {
+    EngineOptions active;
+    active.ip = ip;
+    active.port = port;
+    active.scenario = scenario.get();
+    active.pipeline_depth = pipeline_depth;
+    active.connections = num_connections > 0 ? num_connections : num_threads;
+    active.requests_per_connection = requests_per_connection;
+    return RunIdleTest(active, num_threads,
+                       static_cast<uint64_t>(profile.duration_seconds * 1e9),
+                       idle_targets, idle_source_ips, idle_request,
+                       server_pid);
+  }
+
+  // 阻塞引擎每个线程就是一个客户端
+  if (!event_engine || num_connections <= 0) {
+    num_connections = num_threads;
+  }
+
   std::cout << "HTTP压力测试开始" << std::endl;
-  std::cout << "目标服务器: " << ip << ":" << port << path << std::endl;
+  if (scenario_file.empty()) {
+    std::cout << "目标服务器: " << ip << ":" << port << path << std::endl;
+  } else {
+    std::cout << "目标服务器: " << ip << ":" << port << std::endl;
+    std::cout << "场景: " << scenario_file << std::endl;
+    for (const Scenario::Entry& entry : entries) {
+      std::cout << "  " << entry.name << "  权重 " << entry.weight << "  "
+                << entry.templates.size() << " 个请求" << std::endl;
+    }
+  }
   std::cout << "线程数: " << num_threads << std::endl;
-  std::cout << "每线程请求数: " << requests_per_thread << std::endl;
-  std::cout << "总请求数: " << num_threads * requests_per_thread << std::endl;
+  if (event_engine) {
+    std::cout << "引擎: epoll，并发连接数 " << num_connections << std::endl;
+
+    // 每个连接一个描述符，另加epoll和定时器等少量描述符
+    rlim_t needed = num_connections + 64;
+    rlim_t limit = RaiseFileLimit(needed);
+    if (limit < needed) {
+      std::cerr << "警告: 打开文件数限制为 " << limit << "，不足以建立 "
+                << num_connections << " 个连接" << std::endl;
+    }
+  } else {
+    std::cout << "引擎: 阻塞，每线程一个连接" << std::endl;
+  }
+  bool open_loop = profile.rate > 0 || profile.ramp_to > 0;
+  if (open_loop) {
+    std::cout << "模式: 开环，"
+              << (arrival == ArrivalProcess::kPoisson ? "泊松到达"
+                                                      : "等间隔到达")
+              << std::endl;
+    std::cout << "目标速率: " << profile.Describe() << " 请求/秒" << std::endl;
+    std::cout << "持续时间: " << profile.duration_seconds << " 秒"
+              << std::endl;
+  } else {
+    std::cout << "模式: 闭环" << std::endl;
+    std::cout << "每客户端请求数: " << requests_per_thread << std::endl;
+    std::cout << "总请求数: "
+              << static_cast<uint64_t>(num_connections) * requests_per_thread
+              << std::endl;
+  }
+  if (requests_per_connection > 0) {
+    std::cout << "每连接请求数: " << requests_per_connection << std::endl;
+  } else {
+    std::cout << "每连接请求数: 不限（每客户端一个连接）" << std::endl;
+  }
+
+  // 开环模式的请求按计划时刻逐个发送，不组成流水线
+  if (open_loop) {
+    pipeline_depth = 1;
+  }
+  if (pipeline_depth > 1) {
+    std::cout << "流水线深度: " << pipeline_depth << std::endl;
+  }
+  if (server_pid > 0) {
+    std::cout << "服务器进程: " << server_pid << std::endl;
+  }
 
   // 创建线程
   std::vector<std::thread> threads;
@@ -121,9 +679,70 @@ int main(int argc, char* argv[]) {
   // 记录开始时间
   auto start_time = std::chrono::high_resolution_clock::now();
 
-  // 启动工作线程
+  // 每个线程一份统计，预先分配好，记录时不再分配
+  uint64_t start_ns = NowNanos();
+  uint64_t series_interval =
+      static_cast<uint64_t>(series_interval_ms) * 1000000;
+  std::vector<std::unique_ptr<WorkerStats>> worker_stats;
+  for (int i = 0; i < num_threads; ++i) {
+    worker_stats.push_back(
+        std::make_unique<WorkerStats>(start_ns, series_interval,
+                                      entries.size()));
+  }
+
+  // 服务器的资源占用：压测前后各读一次，期间按分段间隔在后台采样；
+  // 性能计数器在压测前打开，读数取前后之差
+  ProcessSample server_begin;
+  ProcessSample server_end;
+  bool server_sampled = false;
+  std::unique_ptr<PerfCounters> counters;
+  PerfCounters::Reading counters_begin = {};
+  PerfCounters::Reading counters_end = {};
+  std::unique_ptr<ProcessSampler> sampler;
+  if (server_pid > 0) {
+    if (!ReadProcessSample(server_pid, &server_begin)) {
+      std::cerr << "无法读取服务器进程 " << server_pid << " 的资源占用"
+                << std::endl;
+      return 1;
+    }
+    if (perf) {
+      counters = std::make_unique<PerfCounters>(server_pid);
+      counters_begin = counters->Read();
+    }
+    sampler = std::make_unique<ProcessSampler>(server_pid, start_ns,
+                                               series_interval);
+  }
+
+  // 启动工作线程，开环模式下各线程平分目标速率，
+  // 事件驱动引擎下各线程平分连接
   for (int i = 0; i < num_threads; ++i) {
-    threads.emplace_back(WorkerThread, ip, port, path, requests_per_thread);
+    // 选择请求的随机数种子与到达调度的种子错开，两者互不相关
+    uint64_t pick_seed = num_threads + i + 1;
+    if (event_engine) {
+      EngineOptions options;
+      options.ip = ip;
+      options.port = port;
+      options.scenario = scenario.get();
+      options.seed = pick_seed;
+      options.pipeline_depth = pipeline_depth;
+      options.stop_ns = 0;
+      options.connections = num_connections / num_threads +
+                            (i < num_connections % num_threads ? 1 : 0);
+      options.requests_per_connection = requests_per_connection;
+      options.requests_per_client = requests_per_thread;
+      ArrivalSchedule schedule(profile, arrival, 1.0 / num_threads, i + 1);
+      threads.emplace_back(EventWorker, options, open_loop, schedule,
+                           start_ns, worker_stats[i].get());
+    } else if (open_loop) {
+      ArrivalSchedule schedule(profile, arrival, 1.0 / num_threads, i + 1);
+      threads.emplace_back(OpenLoopWorker, std::cref(*scenario), pick_seed,
+                           ip, port, requests_per_connection, schedule,
+                           start_ns, worker_stats[i].get());
+    } else {
+      threads.emplace_back(WorkerThread, std::cref(*scenario), pick_seed, ip,
+                           port, requests_per_thread, requests_per_connection,
+                           pipeline_depth, worker_stats[i].get());
+    }
   }
 
   // 等待所有线程完成
@@ -135,11 +754,25 @@ int main(int argc, char* argv[]) {
   auto end_time = std::chrono::high_resolution_clock::now();
   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
       end_time - start_time);
+  uint64_t end_ns = NowNanos();
+  if (sampler) {
+    sampler->Stop();
+    server_sampled = ReadProcessSample(server_pid, &server_end);
+    if (counters) {
+      counters_end = counters->Read();
+    }
+  }
+
+  // 合并各线程的统计
+  WorkerStats total(start_ns, series_interval, entries.size());
+  for (const auto& stats : worker_stats) {
+    total.Merge(*stats);
+  }
 
   // 计算统计信息
-  int total_requests = num_threads * requests_per_thread;
-  int total_success = success_count.load();
-  int total_fail = fail_count.load();
+  uint64_t total_requests = total.success + total.fail;
+  uint64_t total_success = total.success;
+  uint64_t total_fail = total.fail;
   double success_rate =
       static_cast<double>(total_success) / total_requests * 100.0;
   double requests_per_second =
@@ -151,7 +784,174 @@ int main(int argc, char* argv[]) {
   std::cout << "成功请求: " << total_success << std::endl;
   std::cout << "失败请求: " << total_fail << std::endl;
   std::cout << "成功率: " << success_rate << "%" << std::endl;
+  std::cout << "非2xx响应数: " << total.non_2xx << std::endl;
   std::cout << "每秒请求数 (QPS): " << requests_per_second << std::endl;
 
+  // 连接复用率：不需要新建连接的请求所占的比例
+  uint64_t total_connections = total.connections;
+  double reuse_rate =
+      total_success > 0
+          ? (1.0 - static_cast<double>(total_connections) / total_success) *
+                100.0
+          : 0.0;
+  std::cout << "新建连接数: " << total_connections << std::endl;
+  std::cout << "连接复用率: " << (reuse_rate > 0 ? reuse_rate : 0.0) << "%"
+            << std::endl;
+
+  if (open_loop) {
+    std::cout << "晚于计划发送的请求数: " << total.late << std::endl;
+  }
+
+  // 不使用流水线时每个请求至少要一次写和一次读
+  if (total_requests > 0) {
+    std::cout << "每请求读写系统调用: "
+              << static_cast<double>(total.syscalls) / total_requests
+              << std::endl;
+  }
+  if (pipeline_depth > 1) {
+    uint64_t baseline = 2 * total_requests;
+    std::cout << "流水线节省的系统调用: "
+              << (baseline > total.syscalls ? baseline - total.syscalls : 0)
+              << "（相对每请求一次写一次读）" << std::endl;
+  }
+  if (scenario->HasSequence()) {
+    std::cout << "与请求对不上的响应数: " << total.misordered << std::endl;
+  }
+
+  if (server_sampled) {
+    PrintServerResources(server_pid, server_begin, server_end,
+                         (end_ns - start_ns) / 1e9, total_requests,
+                         counters.get(), counters_begin, counters_end);
+  } else if (server_pid > 0) {
+    std::cout << "\n服务器进程 " << server_pid << " 在压测期间退出"
+              << std::endl;
+  }
+
+  // 每列一个直方图，开环模式的延迟已从计划时刻算起，只有一列
+  const LatencyHistogram& raw = total.latency;
+  LatencyHistogram corrected;
+  std::vector<std::string> headers;
+  std::vector<const LatencyHistogram*> columns;
+  if (open_loop) {
+    std::cout << "\n延迟分布（毫秒，从计划发送时刻算起）:" << std::endl;
+    headers = {"延迟"};
+    columns = {&raw};
+  } else {
+    // 闭环压测中慢请求会推迟后续请求，修正时以期望间隔补记被推迟的请求；
+    // 未指定期望间隔时以原始延迟的中位数近似服务器正常时的单请求耗时
+    uint64_t expected_interval =
+        expected_interval_us > 0
+            ? static_cast<uint64_t>(expected_interval_us) * 1000
+            : raw.GetPercentile(50);
+    corrected = raw.CorrectedCopy(expected_interval);
+    std::cout << "\n延迟分布（毫秒，修正协调遗漏的期望间隔 "
+              << FormatMillis(expected_interval) << "）:" << std::endl;
+    headers = {"原始", "修正"};
+    columns = {&raw, &corrected};
+  }
+
+  std::cout << "  " << PadLeft("", 8);
+  for (const std::string& header : headers) {
+    std::cout << PadLeft(header, 12);
+  }
+  std::cout << std::endl;
+  const double kPercentiles[] = {50, 90, 99, 99.9};
+  for (double percentile : kPercentiles) {
+    char name[16];
+    snprintf(name, sizeof(name), "p%g", percentile);
+    std::cout << "  " << PadLeft(name, 8);
+    for (const LatencyHistogram* column : columns) {
+      std::cout << PadLeft(FormatMillis(column->GetPercentile(percentile)), 12);
+    }
+    std::cout << std::endl;
+  }
+  std::cout << "  " << PadLeft("最大", 8);
+  for (const LatencyHistogram* column : columns) {
+    std::cout << PadLeft(FormatMillis(column->GetMax()), 12);
+  }
+  std::cout << std::endl;
+  std::cout << "  " << PadLeft("平均", 8);
+  for (const LatencyHistogram* column : columns) {
+    std::cout << PadLeft(
+        FormatMillis(static_cast<uint64_t>(column->GetMean())), 12);
+  }
+  std::cout << std::endl;
+
+  // 场景有多个条目时分别列出，混合后的分布会掩盖某一类请求的问题；
+  // 建立连接失败的请求还没有选择条目，不计入各条目
+  if (entries.size() > 1) {
+    std::cout << "\n各条目（延迟单位毫秒）:" << std::endl;
+    std::cout << "  " << PadLeft("条目", 16) << PadLeft("成功", 10)
+              << PadLeft("失败", 8) << PadLeft("非2xx", 8)
+              << PadLeft("p50", 10) << PadLeft("p99", 10)
+              << PadLeft("最大", 10) << std::endl;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const EntryStats& stats = total.entries[i];
+      std::cout << "  " << PadLeft(entries[i].name, 16)
+                << PadLeft(std::to_string(stats.success), 10)
+                << PadLeft(std::to_string(stats.fail), 8)
+                << PadLeft(std::to_string(stats.non_2xx), 8)
+                << PadLeft(FormatMillis(stats.latency.GetPercentile(50)), 10)
+                << PadLeft(FormatMillis(stats.latency.GetPercentile(99)), 10)
+                << PadLeft(FormatMillis(stats.latency.GetMax()), 10)
+                << std::endl;
+    }
+  }
+
+  // 延迟随时间的变化，观察压测过程中的抖动和劣化；
+  // 开环模式同时对比目标速率和实际完成的速率，实际速率跟不上、
+  // 延迟开始上升的那一段就是饱和拐点
+  std::cout << "\n延迟随时间变化（毫秒，每段 " << series_interval_ms
+            << " 毫秒）:" << std::endl;
+  std::cout << "  " << PadLeft("时间(秒)", 10);
+  if (open_loop) {
+    std::cout << PadLeft("目标速率", 10) << PadLeft("实际速率", 10);
+  }
+  std::cout << PadLeft("请求数", 10) << PadLeft("p50", 10)
+            << PadLeft("p99", 10) << PadLeft("最大", 10);
+  if (server_sampled) {
+    std::cout << PadLeft("服务器CPU%", 12);
+  }
+  std::cout << std::endl;
+  const auto& intervals = total.series.GetIntervals();
+  for (size_t i = 0; i < intervals.size(); ++i) {
+    char offset[16];
+    snprintf(offset, sizeof(offset), "%.3f", i * series_interval_ms / 1000.0);
+    std::cout << "  " << PadLeft(offset, 10);
+    if (open_loop) {
+      // 目标速率取这一段中点的值
+      uint64_t middle = i * series_interval + series_interval / 2;
+      char target[32];
+      char actual[32];
+      snprintf(target, sizeof(target), "%.0f", profile.GetRate(middle));
+      snprintf(actual, sizeof(actual), "%.0f",
+               intervals[i].GetCount() * 1000.0 / series_interval_ms);
+      std::cout << PadLeft(target, 10) << PadLeft(actual, 10);
+    }
+    std::cout << PadLeft(std::to_string(intervals[i].GetCount()), 10)
+              << PadLeft(FormatMillis(intervals[i].GetPercentile(50)), 10)
+              << PadLeft(FormatMillis(intervals[i].GetPercentile(99)), 10)
+              << PadLeft(FormatMillis(intervals[i].GetMax()), 10);
+
+    // 这一段服务器用掉的CPU时间，最后一段到压测结束为止
+    if (server_sampled) {
+      const std::vector<ProcessSample>& samples = sampler->GetSamples();
+      std::string usage = "-";
+      uint64_t begin = start_ns + i * series_interval;
+      if (i + 1 < samples.size() || (i < samples.size() && end_ns > begin)) {
+        const ProcessSample& next =
+            i + 1 < samples.size() ? samples[i + 1] : server_end;
+        uint64_t span = i + 1 < samples.size() ? series_interval
+                                               : end_ns - begin;
+        char text[32];
+        snprintf(text, sizeof(text), "%.1f",
+                 (next.cpu_ns - samples[i].cpu_ns) * 100.0 / span);
+        usage = text;
+      }
+      std::cout << PadLeft(usage, 12);
+    }
+    std::cout << std::endl;
+  }
+
   return 0;
 }
\ No newline at end of file
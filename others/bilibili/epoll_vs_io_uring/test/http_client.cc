@@ -0,0 +1,149 @@
+// 基准测试用的阻塞HTTP客户端连接实现
+#include "http_client.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+HttpClient::HttpClient(const std::string& ip, int port)
+    : sockfd_(-1), syscalls_(0) {
+  memset(&addr_, 0, sizeof(addr_));
+  addr_.sin_family = AF_INET;
+  addr_.sin_port = htons(port);
+  inet_pton(AF_INET, ip.c_str(), &addr_.sin_addr);
+}
+
+HttpClient::~HttpClient() {
+  Close();
+}
+
+bool HttpClient::Connect() {
+  Close();
+
+  sockfd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (sockfd_ < 0) {
+    return false;
+  }
+  if (connect(sockfd_, (struct sockaddr*)&addr_, sizeof(addr_)) < 0) {
+    Close();
+    return false;
+  }
+
+  // 请求很小，不等待合并，立即发送
+  int one = 1;
+  setsockopt(sockfd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return true;
+}
+
+void HttpClient::Close() {
+  if (sockfd_ >= 0) {
+    close(sockfd_);
+    sockfd_ = -1;
+  }
+}
+
+bool HttpClient::IsConnected() const {
+  return sockfd_ >= 0;
+}
+
+bool HttpClient::RoundTrip(const std::string& request) {
+  return Pipeline(request, 1, nullptr);
+}
+
+bool HttpClient::Pipeline(const std::string& requests, int count,
+                          const ResponseCallback& on_response) {
+  parser_.Reset();
+  if (sockfd_ < 0 || !WriteAll(requests.data(), requests.size())) {
+    Close();
+    return false;
+  }
+
+  // 一次读到的数据可能包含多个响应，逐个解析，读满count个为止
+  int received = 0;
+  while (received < count) {
+    ssize_t n = read(sockfd_, buffer_, sizeof(buffer_));
+    ++syscalls_;
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      // 对端关闭，没有长度的响应到此结束
+      parser_.OnEof();
+      Close();
+      if (!parser_.IsComplete()) {
+        return false;
+      }
+      if (on_response) {
+        on_response(received, parser_);
+      }
+      return received + 1 == count;
+    }
+
+    size_t offset = 0;
+    while (offset < static_cast<size_t>(n)) {
+      offset += parser_.Feed(buffer_ + offset, n - offset);
+      if (parser_.HasError()) {
+        Close();
+        return false;
+      }
+      if (!parser_.IsComplete()) {
+        break;
+      }
+
+      if (on_response) {
+        on_response(received, parser_);
+      }
+      ++received;
+
+      // 最后一个响应之后不应再有数据，之前的响应不应要求关闭连接
+      if (received == count) {
+        if (offset < static_cast<size_t>(n)) {
+          Close();
+          return false;
+        }
+        break;
+      }
+      if (parser_.ShouldClose()) {
+        Close();
+        return false;
+      }
+      parser_.Reset();
+    }
+  }
+
+  if (parser_.ShouldClose()) {
+    Close();
+  }
+  return true;
+}
+
+const ResponseParser& HttpClient::GetResponse() const {
+  return parser_;
+}
+
+void HttpClient::KeepBody(bool keep) {
+  parser_.KeepBody(keep);
+}
+
+uint64_t HttpClient::GetSyscalls() const {
+  return syscalls_;
+}
+
+bool HttpClient::WriteAll(const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = write(sockfd_, data, size);
+    ++syscalls_;
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
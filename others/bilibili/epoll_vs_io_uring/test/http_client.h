@@ -0,0 +1,71 @@
+// 基准测试用的阻塞HTTP客户端连接
+#ifndef HTTP_CLIENT_H_
+#define HTTP_CLIENT_H_
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+#include "response_parser.h"
+
+// 阻塞的HTTP客户端连接
+// 一个连接可以依次发送多个请求（keep-alive），每个响应按长度读取完整，
+// 不依赖服务器关闭连接，也不会把下一个响应的数据当作本次的。
+// 也可以一次写出多个请求（流水线），再从同一个字节流中依次解析出各个响应。
+class HttpClient {
+ public:
+  // 一个响应完整时的回调，index为响应在这一批请求中的序号
+  using ResponseCallback =
+      std::function<void(int index, const ResponseParser& response)>;
+
+  HttpClient(const std::string& ip, int port);
+  ~HttpClient();
+
+  HttpClient(const HttpClient&) = delete;
+  HttpClient& operator=(const HttpClient&) = delete;
+
+  // 连接服务器
+  bool Connect();
+
+  // 关闭连接
+  void Close();
+
+  // 是否已连接
+  bool IsConnected() const;
+
+  // 发送一个请求并读取完整的响应，失败时关闭连接
+  // 服务器表示要关闭连接时，读完响应后关闭
+  bool RoundTrip(const std::string& request);
+
+  // 用一次写出requests中的count个流水线请求，按顺序读取count个响应，
+  // 每个响应完整时调用on_response（可以为空）
+  // 出错、响应多于请求或服务器中途关闭连接时关闭连接并返回false，
+  // 此前完整的响应已经回调过
+  bool Pipeline(const std::string& requests, int count,
+                const ResponseCallback& on_response);
+
+  // 是否保存响应体，用于检查响应内容
+  void KeepBody(bool keep);
+
+  // 读写系统调用的累计次数
+  uint64_t GetSyscalls() const;
+
+  // 获取最近一次的响应
+  const ResponseParser& GetResponse() const;
+
+ private:
+  static const size_t kBufferSize = 16 * 1024;  // 读缓冲区大小
+
+  // 写出全部数据
+  bool WriteAll(const char* data, size_t size);
+
+  int sockfd_;                     // 套接字描述符，未连接时为-1
+  struct sockaddr_in addr_;        // 服务器地址
+  ResponseParser parser_;          // 响应解析器
+  uint64_t syscalls_;              // 读写系统调用的次数
+  char buffer_[kBufferSize];       // 读缓冲区
+};
+
+#endif  // HTTP_CLIENT_H_
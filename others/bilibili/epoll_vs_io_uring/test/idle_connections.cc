@@ -0,0 +1,294 @@
+// 保持大量空闲的长连接实现
+#include "idle_connections.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace {
+
+// 单调时钟，毫秒
+uint64_t NowMillis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+}  // namespace
+
+IdleConnectionPool::IdleConnectionPool(const std::string& ip, int port,
+                                       const std::string& request,
+                                       int source_ips)
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      pending_epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      next_source_(0),
+      request_(request),
+      open_(0),
+      failed_(0),
+      closed_(0),
+      rejected_(0) {
+  memset(&server_, 0, sizeof(server_));
+  server_.sin_family = AF_INET;
+  server_.sin_port = htons(port);
+  inet_pton(AF_INET, ip.c_str(), &server_.sin_addr);
+
+  // 127.0.0.2、127.0.0.3……整个127.0.0.0/8都是回环地址，不需要配置
+  for (int i = 0; i < std::max(source_ips, 1); ++i) {
+    struct in_addr addr;
+    addr.s_addr = htonl(INADDR_LOOPBACK + 1 + i);
+    sources_.push_back(addr);
+  }
+
+  for (size_t i = 0; i < kMaxPending; ++i) {
+    pending_.push_back(std::make_unique<Pending>());
+    pending_.back()->slot = i;
+    free_slots_.push_back(kMaxPending - 1 - i);
+  }
+}
+
+IdleConnectionPool::~IdleConnectionPool() {
+  for (auto& pending : pending_) {
+    if (pending->fd >= 0) {
+      close(pending->fd);
+    }
+  }
+  for (int fd : idle_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  close(pending_epoll_fd_);
+  close(epoll_fd_);
+}
+
+size_t IdleConnectionPool::Grow(size_t target, int timeout_ms) {
+  // 同时建立的连接不超过kMaxPending，避免超出服务器的监听队列
+  uint64_t deadline = NowMillis() + timeout_ms;
+  size_t to_start = target > open_ ? target - open_ : 0;
+  size_t in_progress = 0;
+  struct epoll_event events[kMaxEvents];
+  while (to_start > 0 || in_progress > 0) {
+    while (to_start > 0 && !free_slots_.empty()) {
+      size_t slot = free_slots_.back();
+      --to_start;
+      if (!StartConnect(slot)) {
+        ++failed_;
+        continue;
+      }
+      free_slots_.pop_back();
+      ++in_progress;
+    }
+    if (in_progress == 0) {
+      break;
+    }
+
+    // 超时后放弃还没建立好的连接
+    uint64_t now = NowMillis();
+    if (now >= deadline) {
+      for (auto& pending : pending_) {
+        if (pending->fd >= 0) {
+          FinishPending(pending.get(), false);
+        }
+      }
+      failed_ += to_start;
+      break;
+    }
+
+    int n = epoll_wait(pending_epoll_fd_, events, kMaxEvents,
+                       static_cast<int>(deadline - now));
+    for (int i = 0; i < n; ++i) {
+      Pending* pending = static_cast<Pending*>(events[i].data.ptr);
+      if (HandlePending(pending, events[i].events)) {
+        --in_progress;
+      }
+    }
+  }
+  return open_;
+}
+
+size_t IdleConnectionPool::Check() {
+  // 空闲连接不应有任何数据，可读、对端关闭或出错都说明连接已被服务器关闭；
+  // 关闭描述符时内核把它从epoll中删除，循环到没有事件为止
+  struct epoll_event events[kMaxEvents];
+  for (;;) {
+    int n = epoll_wait(epoll_fd_, events, kMaxEvents, 0);
+    for (int i = 0; i < n; ++i) {
+      size_t index = events[i].data.u64;
+      if (IsRejection(idle_[index])) {
+        ++rejected_;
+      }
+      close(idle_[index]);
+      idle_[index] = -1;
+      --open_;
+      ++closed_;
+    }
+    if (n < kMaxEvents) {
+      break;
+    }
+  }
+  return open_;
+}
+
+size_t IdleConnectionPool::GetOpen() const {
+  return open_;
+}
+
+uint64_t IdleConnectionPool::GetFailed() const {
+  return failed_;
+}
+
+uint64_t IdleConnectionPool::GetClosed() const {
+  return closed_;
+}
+
+uint64_t IdleConnectionPool::GetRejected() const {
+  return rejected_;
+}
+
+bool IdleConnectionPool::IsRejection(int fd) {
+  // 只看状态行，"HTTP/1.1 503"
+  char head[12];
+  ssize_t n = recv(fd, head, sizeof(head), MSG_DONTWAIT);
+  return n == static_cast<ssize_t>(sizeof(head)) &&
+         memcmp(head, "HTTP/1.", 7) == 0 && memcmp(head + 8, " 503", 4) == 0;
+}
+
+bool IdleConnectionPool::StartConnect(size_t slot) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  // 绑定源地址但推迟到connect时再选端口，端口只需在四元组中唯一，
+  // 每个源地址都能用满本地端口范围
+  int one = 1;
+  setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  struct sockaddr_in source;
+  memset(&source, 0, sizeof(source));
+  source.sin_family = AF_INET;
+  source.sin_addr = sources_[next_source_];
+  next_source_ = (next_source_ + 1) % sources_.size();
+  if (bind(fd, (struct sockaddr*)&source, sizeof(source)) < 0 ||
+      (connect(fd, (struct sockaddr*)&server_, sizeof(server_)) < 0 &&
+       errno != EINPROGRESS)) {
+    close(fd);
+    return false;
+  }
+
+  Pending* pending = pending_[slot].get();
+  struct epoll_event ev;
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.ptr = pending;
+  if (epoll_ctl(pending_epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    close(fd);
+    return false;
+  }
+  pending->fd = fd;
+  pending->sent = false;
+  pending->parser.Reset();
+  return true;
+}
+
+bool IdleConnectionPool::HandlePending(Pending* pending, uint32_t events) {
+  if (!pending->sent) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+      FinishPending(pending, false);
+      return true;
+    }
+    if (!(events & EPOLLOUT)) {
+      return false;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(pending->fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 ||
+        error != 0) {
+      FinishPending(pending, false);
+      return true;
+    }
+    if (request_.empty()) {
+      FinishPending(pending, true);
+      return true;
+    }
+
+    // 请求很小，新连接的发送缓冲区足够一次写完
+    ssize_t n = write(pending->fd, request_.data(), request_.size());
+    if (n != static_cast<ssize_t>(request_.size())) {
+      FinishPending(pending, false);
+      return true;
+    }
+    pending->sent = true;
+  }
+
+  // 边沿触发，发送后立即尝试读取，响应可能在注册可读事件前就已到达
+  bool done = false;
+  if (!ReadResponse(pending, &done)) {
+    FinishPending(pending, false);
+    return true;
+  }
+  if (done) {
+    int status = pending->parser.GetStatusCode();
+    if (status == 503) {
+      ++rejected_;
+    }
+    FinishPending(pending, status >= 200 && status < 300 &&
+                               !pending->parser.ShouldClose());
+    return true;
+  }
+  return false;
+}
+
+bool IdleConnectionPool::ReadResponse(Pending* pending, bool* done) {
+  for (;;) {
+    ssize_t n = read(pending->fd, buffer_, sizeof(buffer_));
+    if (n == 0) {
+      pending->parser.OnEof();
+      return false;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN;
+    }
+    pending->parser.Feed(buffer_, n);
+    if (pending->parser.HasError()) {
+      return false;
+    }
+    if (pending->parser.IsComplete()) {
+      *done = true;
+      return true;
+    }
+  }
+}
+
+void IdleConnectionPool::FinishPending(Pending* pending, bool success) {
+  int fd = pending->fd;
+  pending->fd = -1;
+  free_slots_.push_back(pending->slot);
+  epoll_ctl(pending_epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  if (!success) {
+    close(fd);
+    ++failed_;
+    return;
+  }
+
+  // 转为空闲连接，水平触发只关注可读和对端关闭
+  struct epoll_event ev;
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  ev.data.u64 = idle_.size();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    close(fd);
+    ++failed_;
+    return;
+  }
+  idle_.push_back(fd);
+  ++open_;
+}
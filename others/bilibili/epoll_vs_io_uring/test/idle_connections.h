@@ -0,0 +1,97 @@
+// 保持大量空闲的长连接
+#ifndef IDLE_CONNECTIONS_H_
+#define IDLE_CONNECTIONS_H_
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "response_parser.h"
+
+// 空闲连接池
+// 建立并保持大量不再发送请求的长连接，用于测量服务器每个连接的内存开销
+// 和大量连接对活跃请求延迟的影响。一个源地址到同一服务器端口最多只有
+// 本地端口范围内的几万个连接，所以连接轮流绑定127.0.0.2起的多个回环
+// 源地址。每个连接建立后可以先发送一个请求并读完响应，让服务器为连接
+// 分配的缓冲区都被用到，与真实的长连接客户端一致。
+// 连接池只在创建它的线程中使用。
+class IdleConnectionPool {
+ public:
+  static const size_t kMaxPending = 1024;  // 同时建立中的连接数上限
+
+  // request为每个连接建立后发送的请求，为空时建立后直接空闲；
+  // source_ips为使用的回环源地址个数
+  IdleConnectionPool(const std::string& ip, int port,
+                     const std::string& request, int source_ips);
+  ~IdleConnectionPool();
+
+  IdleConnectionPool(const IdleConnectionPool&) = delete;
+  IdleConnectionPool& operator=(const IdleConnectionPool&) = delete;
+
+  // 把打开的连接增加到target个，最多等待timeout_ms，返回打开的连接数
+  size_t Grow(size_t target, int timeout_ms);
+
+  // 关闭已被服务器关闭的连接，返回仍然打开的连接数
+  size_t Check();
+
+  // 获取打开的连接数
+  size_t GetOpen() const;
+
+  // 获取建立失败的连接数，包括请求没有得到2xx响应的
+  uint64_t GetFailed() const;
+
+  // 获取空闲期间被服务器关闭的连接数
+  uint64_t GetClosed() const;
+
+  // 获取被服务器以503拒绝的连接数，已计入GetFailed()或GetClosed()；
+  // 服务器超过最大连接数时会先回答503再关闭连接
+  uint64_t GetRejected() const;
+
+ private:
+  static const size_t kBufferSize = 16384;  // 读缓冲区大小
+  static const int kMaxEvents = 1024;       // 每次最多处理的事件数
+
+  // 正在建立的连接
+  struct Pending {
+    size_t slot = 0;        // 槽位的下标
+    int fd = -1;            // 套接字描述符，槽位空闲时为-1
+    bool sent = false;      // 是否已发出请求
+    ResponseParser parser;  // 响应解析器
+  };
+
+  // 发起一个非阻塞连接并放入空闲的槽位，失败时返回false
+  bool StartConnect(size_t slot);
+
+  // 处理建立中的连接上的事件，返回连接是否结束（成功或失败）
+  bool HandlePending(Pending* pending, uint32_t events);
+
+  // 读取并解析请求的响应，出错时返回false，*done表示响应是否完整
+  bool ReadResponse(Pending* pending, bool* done);
+
+  // 建立中的连接结束，成功时转为空闲连接
+  void FinishPending(Pending* pending, bool success);
+
+  // 空闲连接上收到的数据是否是503响应
+  static bool IsRejection(int fd);
+
+  int epoll_fd_;                                   // 空闲连接的epoll描述符
+  int pending_epoll_fd_;                           // 建立中连接的epoll描述符
+  struct sockaddr_in server_;                      // 服务器地址
+  std::vector<struct in_addr> sources_;            // 回环源地址
+  size_t next_source_;                             // 下一个连接的源地址
+  std::string request_;                            // 建立后发送的请求
+  std::vector<std::unique_ptr<Pending>> pending_;  // 建立中的连接的槽位
+  std::vector<size_t> free_slots_;                 // 空闲的槽位
+  std::vector<int> idle_;                          // 空闲连接，关闭后为-1
+  size_t open_;                                    // 打开的空闲连接数
+  uint64_t failed_;                                // 建立失败的连接数
+  uint64_t closed_;                                // 被服务器关闭的连接数
+  uint64_t rejected_;                              // 被503拒绝的连接数
+  char buffer_[kBufferSize];                       // 读缓冲区
+};
+
+#endif  // IDLE_CONNECTIONS_H_
@@ -0,0 +1,183 @@
+// 对数-线性的延迟直方图实现
+#include "latency_histogram.h"
+
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram(int sub_bucket_bits)
+    : sub_bucket_bits_(sub_bucket_bits),
+      counts_((64 - __builtin_clzll(kMaxValue) - sub_bucket_bits + 1)
+              << sub_bucket_bits),
+      count_(0),
+      min_(UINT64_MAX),
+      max_(0),
+      sum_(0) {}
+
+LatencyHistogram::~LatencyHistogram() {}
+
+void LatencyHistogram::Record(uint64_t value) {
+  RecordCount(value, 1);
+}
+
+void LatencyHistogram::RecordCount(uint64_t value, uint64_t count) {
+  if (count == 0) {
+    return;
+  }
+  counts_[GetIndex(value)] += count;
+  count_ += count;
+  sum_ += static_cast<double>(value) * count;
+  if (value < min_) {
+    min_ = value;
+  }
+  if (value > max_) {
+    max_ = value;
+  }
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  if (other.min_ < min_) {
+    min_ = other.min_;
+  }
+  if (other.max_ > max_) {
+    max_ = other.max_;
+  }
+}
+
+LatencyHistogram LatencyHistogram::CorrectedCopy(
+    uint64_t expected_interval) const {
+  LatencyHistogram corrected(sub_bucket_bits_);
+  corrected.Merge(*this);
+  if (expected_interval == 0) {
+    return corrected;
+  }
+
+  // 同一个桶的样本按桶的上界补记，桶宽相对误差很小
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    if (counts_[i] == 0) {
+      continue;
+    }
+    uint64_t value = GetLowerBound(i) + GetWidth(i) - 1;
+    if (value > max_) {
+      value = max_;
+    }
+    for (uint64_t missing = value - expected_interval;
+         value > expected_interval && missing >= expected_interval;
+         missing -= expected_interval) {
+      corrected.RecordCount(missing, counts_[i]);
+    }
+  }
+  return corrected;
+}
+
+void LatencyHistogram::Reset() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  min_ = UINT64_MAX;
+  max_ = 0;
+  sum_ = 0;
+}
+
+uint64_t LatencyHistogram::GetCount() const {
+  return count_;
+}
+
+uint64_t LatencyHistogram::GetMin() const {
+  return count_ > 0 ? min_ : 0;
+}
+
+uint64_t LatencyHistogram::GetMax() const {
+  return max_;
+}
+
+double LatencyHistogram::GetMean() const {
+  return count_ > 0 ? sum_ / count_ : 0;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+
+  // 第rank个样本（从1开始）所在的桶
+  uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count_ + 0.5);
+  if (rank < 1) {
+    rank = 1;
+  }
+  if (rank > count_) {
+    rank = count_;
+  }
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      uint64_t upper = GetLowerBound(i) + GetWidth(i) - 1;
+      return upper < max_ ? upper : max_;
+    }
+  }
+  return max_;
+}
+
+size_t LatencyHistogram::GetIndex(uint64_t value) const {
+  uint64_t sub_bucket_count = 1ULL << sub_bucket_bits_;
+  if (value >= kMaxValue) {
+    return counts_.size() - 1;
+  }
+  if (value < sub_bucket_count) {
+    return value;
+  }
+
+  // 值在[2^k, 2^(k+1))时，去掉低shift位后落在[2^bits, 2^(bits+1))，
+  // 低bits位就是组内的线性桶号
+  int shift = 63 - __builtin_clzll(value) - sub_bucket_bits_;
+  uint64_t sub_bucket = (value >> shift) & (sub_bucket_count - 1);
+  return ((shift + 1) << sub_bucket_bits_) + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetLowerBound(size_t index) const {
+  size_t group = index >> sub_bucket_bits_;
+  uint64_t sub_bucket = index & ((1ULL << sub_bucket_bits_) - 1);
+  if (group == 0) {
+    return sub_bucket;
+  }
+  return ((1ULL << sub_bucket_bits_) + sub_bucket) << (group - 1);
+}
+
+uint64_t LatencyHistogram::GetWidth(size_t index) const {
+  size_t group = index >> sub_bucket_bits_;
+  return group == 0 ? 1 : 1ULL << (group - 1);
+}
+
+LatencyTimeSeries::LatencyTimeSeries(uint64_t start, uint64_t interval)
+    : start_(start), interval_(interval) {}
+
+LatencyTimeSeries::~LatencyTimeSeries() {}
+
+void LatencyTimeSeries::Record(uint64_t now, uint64_t latency) {
+  size_t index = now > start_ ? (now - start_) / interval_ : 0;
+  while (intervals_.size() <= index) {
+    intervals_.push_back(LatencyHistogram(kSubBucketBits));
+  }
+  intervals_[index].Record(latency);
+}
+
+void LatencyTimeSeries::Merge(const LatencyTimeSeries& other) {
+  while (intervals_.size() < other.intervals_.size()) {
+    intervals_.push_back(LatencyHistogram(kSubBucketBits));
+  }
+  for (size_t i = 0; i < other.intervals_.size(); ++i) {
+    intervals_[i].Merge(other.intervals_[i]);
+  }
+}
+
+uint64_t LatencyTimeSeries::GetInterval() const {
+  return interval_;
+}
+
+const std::vector<LatencyHistogram>& LatencyTimeSeries::GetIntervals() const {
+  return intervals_;
+}
@@ -0,0 +1,95 @@
+// 对数-线性的延迟直方图
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// 对数-线性（HDR风格）的延迟直方图
+// 值按2的幂分组，每组再线性分成2^sub_bucket_bits个桶，相对误差不超过
+// 2^-sub_bucket_bits，覆盖1纳秒到kMaxValue的范围，更大的值计入最后一个桶。
+// 桶在构造时一次分配，记录只是数组下标计算和自增，不加锁、不分配内存；
+// 每个线程各自记录，结束后合并。
+class LatencyHistogram {
+ public:
+  static const uint64_t kMaxValue = 1ULL << 36;  // 约68秒，纳秒
+
+  // sub_bucket_bits越大越精确，占用的内存也越多
+  explicit LatencyHistogram(int sub_bucket_bits = 7);
+  ~LatencyHistogram();
+
+  // 记录一个值
+  void Record(uint64_t value);
+
+  // 记录count个相同的值
+  void RecordCount(uint64_t value, uint64_t count);
+
+  // 合并另一个直方图，两者精度必须相同
+  void Merge(const LatencyHistogram& other);
+
+  // 修正协调遗漏后的副本
+  // 闭环压测中一个慢请求会推迟后续请求的发送，那段时间本应发出的请求
+  // 没有被记录。对超过expected_interval的每个值，补记值减去1倍、2倍……
+  // 期望间隔的样本，近似那些被推迟的请求本应测得的延迟。
+  LatencyHistogram CorrectedCopy(uint64_t expected_interval) const;
+
+  // 清空
+  void Reset();
+
+  // 记录的样本数
+  uint64_t GetCount() const;
+
+  // 最小值、最大值和平均值，没有样本时为0
+  uint64_t GetMin() const;
+  uint64_t GetMax() const;
+  double GetMean() const;
+
+  // 百分位数（0~100），返回所在桶的上界，不超过记录的最大值
+  uint64_t GetPercentile(double percentile) const;
+
+ private:
+  // 值所在的桶
+  size_t GetIndex(uint64_t value) const;
+
+  // 桶的下界和宽度
+  uint64_t GetLowerBound(size_t index) const;
+  uint64_t GetWidth(size_t index) const;
+
+  int sub_bucket_bits_;           // 每组桶数的对数
+  std::vector<uint64_t> counts_;  // 各个桶的样本数
+  uint64_t count_;                // 样本总数
+  uint64_t min_;                  // 最小值
+  uint64_t max_;                  // 最大值
+  double sum_;                    // 总和，用于计算平均值
+};
+
+// 按时间段分开的延迟直方图，用于观察延迟随时间的变化
+// 每个时间段一个低精度的直方图，只在进入新时间段时分配。
+class LatencyTimeSeries {
+ public:
+  static const int kSubBucketBits = 4;  // 每段直方图的精度，约6%
+
+  // start为压测开始的时刻，interval为时间段长度，都是纳秒
+  LatencyTimeSeries(uint64_t start, uint64_t interval);
+  ~LatencyTimeSeries();
+
+  // 记录一个在now时刻完成的请求的延迟
+  void Record(uint64_t now, uint64_t latency);
+
+  // 合并另一个时间序列，两者的起点和时间段长度必须相同
+  void Merge(const LatencyTimeSeries& other);
+
+  // 时间段长度
+  uint64_t GetInterval() const;
+
+  // 各个时间段的直方图
+  const std::vector<LatencyHistogram>& GetIntervals() const;
+
+ private:
+  uint64_t start_;                           // 压测开始的时刻
+  uint64_t interval_;                        // 时间段长度
+  std::vector<LatencyHistogram> intervals_;  // 各个时间段的直方图
+};
+
+#endif  // LATENCY_HISTOGRAM_H_
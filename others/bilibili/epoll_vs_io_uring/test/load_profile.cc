@@ -0,0 +1,97 @@
+// 开环压测的负载曲线和到达过程实现
+#include "load_profile.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+
+// 对速率积分的最大步长
+const uint64_t kMaxStepNs = 1000000;
+
+}  // namespace
+
+double LoadProfile::GetRate(uint64_t elapsed_ns) const {
+  double seconds = elapsed_ns / 1e9;
+  if (step > 0 && step_seconds > 0) {
+    return rate + step * floor(seconds / step_seconds);
+  }
+  if (ramp_to > 0 && duration_seconds > 0) {
+    double progress = seconds < duration_seconds ? seconds / duration_seconds
+                                                 : 1.0;
+    return rate + (ramp_to - rate) * progress;
+  }
+  return rate;
+}
+
+uint64_t LoadProfile::GetDuration() const {
+  return static_cast<uint64_t>(duration_seconds * 1e9);
+}
+
+std::string LoadProfile::Describe() const {
+  char text[128];
+  if (step > 0 && step_seconds > 0) {
+    snprintf(text, sizeof(text), "阶梯，从 %g 开始每 %g 秒增加 %g", rate,
+             step_seconds, step);
+  } else if (ramp_to > 0) {
+    snprintf(text, sizeof(text), "线性，从 %g 到 %g", rate, ramp_to);
+  } else {
+    snprintf(text, sizeof(text), "恒定 %g", rate);
+  }
+  return text;
+}
+
+bool ParseArrivalProcess(const std::string& name, ArrivalProcess* process) {
+  if (name == "constant") {
+    *process = ArrivalProcess::kConstant;
+    return true;
+  }
+  if (name == "poisson") {
+    *process = ArrivalProcess::kPoisson;
+    return true;
+  }
+  return false;
+}
+
+ArrivalSchedule::ArrivalSchedule(const LoadProfile& profile,
+                                 ArrivalProcess process, double share,
+                                 uint64_t seed)
+    : profile_(profile),
+      process_(process),
+      share_(share),
+      duration_ns_(profile.GetDuration()),
+      next_ns_(0),
+      rng_(seed),
+      exponential_(1.0) {
+  // 等间隔到达时各线程的起点随机错开，避免所有线程同时发送
+  if (process_ == ArrivalProcess::kConstant) {
+    Advance(std::uniform_real_distribution<double>(0, 1)(rng_));
+  } else {
+    Advance(exponential_(rng_));
+  }
+}
+
+bool ArrivalSchedule::Next(uint64_t* send_ns) {
+  if (next_ns_ >= duration_ns_) {
+    return false;
+  }
+
+  *send_ns = next_ns_;
+  Advance(process_ == ArrivalProcess::kPoisson ? exponential_(rng_) : 1.0);
+  return true;
+}
+
+void ArrivalSchedule::Advance(double requests) {
+  // 每次最多前进kMaxStepNs，速率变化时（包括从0开始线性增长）也不会
+  // 按某一时刻的低速率算出一个跨过整段曲线的间隔
+  while (next_ns_ < duration_ns_) {
+    double rate = profile_.GetRate(next_ns_) * share_;
+    double step_requests = rate * kMaxStepNs / 1e9;
+    if (step_requests > 0 && step_requests >= requests) {
+      next_ns_ += static_cast<uint64_t>(requests / rate * 1e9);
+      return;
+    }
+    requests -= step_requests;
+    next_ns_ += kMaxStepNs;
+  }
+}
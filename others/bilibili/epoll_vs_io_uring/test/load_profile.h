@@ -0,0 +1,63 @@
+// 开环压测的负载曲线和到达过程
+#ifndef LOAD_PROFILE_H_
+#define LOAD_PROFILE_H_
+
+#include <stdint.h>
+#include <random>
+#include <string>
+
+// 负载曲线：目标速率（每秒请求数）随时间的变化
+// 默认是恒定速率；ramp_to大于0时在整个时长内从rate线性变化到ramp_to；
+// step大于0时为阶梯，每隔step_seconds速率增加step，用来寻找饱和拐点。
+struct LoadProfile {
+  double rate = 0;              // 起始速率
+  double ramp_to = 0;           // 线性变化的终点速率，0表示不变化
+  double step = 0;              // 每一阶增加的速率，0表示不分阶
+  double step_seconds = 0;      // 每一阶的时长
+  double duration_seconds = 0;  // 总时长
+
+  // elapsed_ns时刻的目标速率
+  double GetRate(uint64_t elapsed_ns) const;
+
+  // 总时长，纳秒
+  uint64_t GetDuration() const;
+
+  // 描述曲线，用于输出
+  std::string Describe() const;
+};
+
+// 请求的到达过程
+enum class ArrivalProcess {
+  kConstant,  // 等间隔到达
+  kPoisson,   // 泊松到达，间隔服从指数分布
+};
+
+// 解析到达过程的名字（constant或poisson），不认识时返回false
+bool ParseArrivalProcess(const std::string& name, ArrivalProcess* process);
+
+// 按负载曲线生成计划发送时刻
+// 多个线程分摊同一条曲线时，每个线程的调度承担share比例的速率。
+// 计划时刻按速率对时间的积分生成：积分每累计1个（等间隔到达）或一个
+// 均值为1的指数分布随机数（泊松到达）就是下一个请求，速率为0的时段没有请求。
+class ArrivalSchedule {
+ public:
+  ArrivalSchedule(const LoadProfile& profile, ArrivalProcess process,
+                  double share, uint64_t seed);
+
+  // 输出下一个请求的计划发送时刻（相对开始时刻，纳秒），超出总时长时返回false
+  bool Next(uint64_t* send_ns);
+
+ private:
+  // 把下一个请求的计划时刻推后requests个请求的积分量
+  void Advance(double requests);
+
+  LoadProfile profile_;                                // 负载曲线
+  ArrivalProcess process_;                             // 到达过程
+  double share_;                                       // 承担的速率比例
+  uint64_t duration_ns_;                               // 总时长
+  uint64_t next_ns_;                                   // 下一个请求的计划时刻
+  std::mt19937_64 rng_;                                // 随机数发生器
+  std::exponential_distribution<double> exponential_;  // 均值为1的指数分布
+};
+
+#endif  // LOAD_PROFILE_H_
@@ -0,0 +1,62 @@
+// 按时长运行的闭环压测实现
+#include "load_runner.h"
+
+#include <limits.h>
+#include <time.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 单调时钟，纳秒
+uint64_t NowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+}  // namespace
+
+LoadResult RunTimedLoad(const EngineOptions& options, int num_threads,
+                        uint64_t duration_ns, uint64_t series_interval_ns) {
+  num_threads = std::max(1, std::min(num_threads, options.connections));
+  size_t entries = options.scenario->GetEntries().size();
+  uint64_t start_ns = NowNanos();
+  uint64_t series_interval =
+      series_interval_ns > 0 ? series_interval_ns : duration_ns + 1;
+  std::vector<std::unique_ptr<WorkerStats>> worker_stats;
+  for (int i = 0; i < num_threads; ++i) {
+    worker_stats.push_back(
+        std::make_unique<WorkerStats>(start_ns, series_interval, entries));
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    EngineOptions thread_options = options;
+    thread_options.seed = i + 1;
+    thread_options.connections =
+        options.connections / num_threads +
+        (i < options.connections % num_threads ? 1 : 0);
+    thread_options.requests_per_client = INT_MAX;
+    thread_options.stop_ns = start_ns + duration_ns;
+    WorkerStats* stats = worker_stats[i].get();
+    threads.emplace_back([thread_options, stats]() {
+      EventEngine engine(thread_options, stats);
+      engine.RunClosedLoop();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  LoadResult result;
+  result.seconds = (NowNanos() - start_ns) / 1e9;
+  result.stats =
+      std::make_unique<WorkerStats>(start_ns, series_interval, entries);
+  for (const auto& stats : worker_stats) {
+    result.stats->Merge(*stats);
+  }
+  return result;
+}
@@ -0,0 +1,24 @@
+// 按时长运行的闭环压测
+#ifndef LOAD_RUNNER_H_
+#define LOAD_RUNNER_H_
+
+#include <stdint.h>
+#include <memory>
+
+#include "event_engine.h"
+#include "worker_stats.h"
+
+// 一次压测的结果
+struct LoadResult {
+  std::unique_ptr<WorkerStats> stats;  // 合并后的统计
+  double seconds;                      // 从开始到所有连接结束的时间
+};
+
+// 用num_threads个线程的EventEngine闭环压测duration_ns，各线程平分
+// options.connections个连接；options中的connections、seed、stop_ns和
+// requests_per_client按线程设置，其余参数原样使用。
+// series_interval_ns为0时不分段
+LoadResult RunTimedLoad(const EngineOptions& options, int num_threads,
+                        uint64_t duration_ns, uint64_t series_interval_ns);
+
+#endif  // LOAD_RUNNER_H_
@@ -0,0 +1,99 @@
+// 发送队列的回归测试
+// 流式响应交替写入短的自有数据块（块头、块尾）和共享缓冲区，段数组在
+// 写入过程中扩容，部分发送后回收段轮转，取出的数据必须与chunked编码一致。
+#include <stdio.h>
+
+#include <string>
+
+#include "output_queue.h"
+
+namespace {
+
+int g_failures = 0;
+
+void Expect(bool condition, const char* what) {
+  if (!condition) {
+    fprintf(stderr, "失败: %s\n", what);
+    ++g_failures;
+  }
+}
+
+// 按GetSegments()取出队列中全部待发送数据
+std::string Drain(const OutputQueue& output) {
+  OutputSegment segments[64];
+  int count = output.GetSegments(segments, 64);
+  std::string data;
+  for (int i = 0; i < count; ++i) {
+    data.append(segments[i].data, segments[i].size);
+  }
+  return data;
+}
+
+// 期望的chunked编码
+void AppendChunk(std::string_view data, std::string* out) {
+  char header[24];
+  snprintf(header, sizeof(header), "%zx\r\n", data.size());
+  out->append(header);
+  out->append(data);
+  out->append("\r\n");
+}
+
+// 共享缓冲区与短的自有段交替，跨越段数组的多次扩容
+void TestSharedChunksAcrossGrowth() {
+  OutputQueue output(1 << 20, 1 << 16);
+  ChunkWriter writer(&output);
+  std::string expected;
+  for (int i = 0; i < 8; ++i) {
+    std::string body = "shared-" + std::to_string(i);
+    AppendChunk(body, &expected);
+    writer.Write(SharedBuffer::FromString(body));
+  }
+  writer.Finish();
+  expected += "0\r\n\r\n";
+
+  Expect(output.GetSize() == expected.size(), "待发送字节数");
+  Expect(Drain(output) == expected, "扩容后的段数据");
+}
+
+// 部分发送后继续写入，回收的段被轮转到数组末尾再复用
+void TestSegmentsRotatedAfterConsume() {
+  OutputQueue output(1 << 20, 1 << 16);
+  ChunkWriter writer(&output);
+  std::string expected;
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 6; ++i) {
+      std::string small = "s" + std::to_string(round * 10 + i);
+      std::string shared = "buffer-" + std::to_string(round * 10 + i);
+      AppendChunk(small, &expected);
+      AppendChunk(shared, &expected);
+      writer.Write(small);
+      writer.Write(SharedBuffer::FromString(shared));
+    }
+
+    // 发送一半，剩余数据仍应按原顺序取出
+    std::string pending = Drain(output);
+    Expect(pending == expected, "轮转前的段数据");
+    size_t sent = pending.size() / 2;
+    output.Consume(sent);
+    expected.erase(0, sent);
+    Expect(Drain(output) == expected, "部分发送后的段数据");
+  }
+  writer.Finish();
+  expected += "0\r\n\r\n";
+  Expect(Drain(output) == expected, "轮转后的段数据");
+
+  output.Consume(expected.size());
+  Expect(output.IsEmpty(), "全部发送后队列为空");
+}
+
+}  // namespace
+
+int main() {
+  TestSharedChunksAcrossGrowth();
+  TestSegmentsRotatedAfterConsume();
+  if (g_failures > 0) {
+    return 1;
+  }
+  printf("output_queue_test: 全部通过\n");
+  return 0;
+}
@@ -0,0 +1,509 @@
+// HTTP解析器基准测试：手写的HttpRequest::Parse 对比 llhttp
+#include <benchmark/benchmark.h>
+#include <llhttp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "http_request.h"
+
+// 统计堆分配次数，用于计算每个请求的分配次数
+static std::atomic<uint64_t> g_alloc_count(0);
+
+void* operator new(size_t size) {
+  g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+// 读取CPU周期计数，非x86平台退化为纳秒
+static uint64_t ReadCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// 测试语料
+// ---------------------------------------------------------------------------
+
+// 最小的GET请求
+static const std::string kTinyGet =
+    "GET / HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "\r\n";
+
+// 带请求体的POST请求
+static std::string MakePostWithBody() {
+  const std::string body =
+      "{\"name\": \"widget\", \"count\": 42, \"tags\": [\"a\", \"b\"]}";
+  return "POST /api/v1/items HTTP/1.1\r\n"
+         "Host: api.example.com\r\n"
+         "Content-Type: application/json\r\n"
+         "Content-Length: " +
+         std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+static const std::string kPostWithBody = MakePostWithBody();
+
+// 生成一个带有40个请求头的浏览器请求
+static std::string MakeBrowserRequest() {
+  std::string request =
+      "GET /static/js/app.bundle.min.js?v=20240611 HTTP/1.1\r\n"
+      "Host: www.example.com\r\n"
+      "Connection: keep-alive\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+      "(KHTML, like Gecko) Chrome/125.0.0.0 Safari/537.36\r\n"
+      "Accept: */*\r\n"
+      "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+      "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+      "Cache-Control: no-cache\r\n"
+      "Pragma: no-cache\r\n"
+      "Referer: https://www.example.com/index.html\r\n"
+      "Sec-Fetch-Dest: script\r\n"
+      "Sec-Fetch-Mode: no-cors\r\n"
+      "Sec-Fetch-Site: same-origin\r\n"
+      "Sec-Ch-Ua: \"Chromium\";v=\"125\", \"Not.A/Brand\";v=\"24\"\r\n"
+      "Sec-Ch-Ua-Mobile: ?0\r\n"
+      "Sec-Ch-Ua-Platform: \"Linux\"\r\n"
+      "Cookie: session=4f1c2a9b8e7d6c5b4a39281706f5e4d3; theme=dark; "
+      "lang=zh-CN; _ga=GA1.2.1234567890.1700000000\r\n";
+  // 补足到40个请求头
+  for (int i = 16; i < 40; ++i) {
+    request += "X-Custom-Header-" + std::to_string(i) +
+               ": value-" + std::to_string(i * 7919) + "\r\n";
+  }
+  request += "\r\n";
+  return request;
+}
+
+static const std::string kBrowserRequest = MakeBrowserRequest();
+
+// 流水线批量请求：同一个缓冲区中连续的多个请求
+static const int kPipelineDepth = 16;
+
+static std::string MakePipelinedBatch() {
+  std::string batch;
+  for (int i = 0; i < kPipelineDepth; ++i) {
+    batch += (i % 4 == 3) ? kPostWithBody : kTinyGet;
+  }
+  return batch;
+}
+
+static const std::string kPipelinedBatch = MakePipelinedBatch();
+
+// ---------------------------------------------------------------------------
+// llhttp 适配层，字段收集方式与 sample4/session.h 一致
+// ---------------------------------------------------------------------------
+
+struct LlhttpRequest {
+  std::string method;
+  std::string url;
+  std::string version;
+  std::unordered_map<std::string, std::string> headers;
+  std::string current_header_field;
+  std::string current_header_value;
+  std::string body;
+  bool in_header_value = false;
+  bool is_complete = false;
+
+  void Clear() {
+    method.clear();
+    url.clear();
+    version.clear();
+    headers.clear();
+    current_header_field.clear();
+    current_header_value.clear();
+    body.clear();
+    in_header_value = false;
+    is_complete = false;
+  }
+};
+
+class LlhttpParser {
+ public:
+  LlhttpParser() {
+    llhttp_settings_init(&settings_);
+    settings_.on_method = [](llhttp_t* parser, const char* at, size_t length) {
+      Get(parser)->method.append(at, length);
+      return 0;
+    };
+    settings_.on_url = [](llhttp_t* parser, const char* at, size_t length) {
+      Get(parser)->url.append(at, length);
+      return 0;
+    };
+    settings_.on_version = [](llhttp_t* parser, const char* at,
+                              size_t length) {
+      Get(parser)->version.append(at, length);
+      return 0;
+    };
+    // 请求头字段和值可能被分片回调，需要拼接
+    settings_.on_header_field = [](llhttp_t* parser, const char* at,
+                                   size_t length) {
+      auto* request = Get(parser);
+      if (request->in_header_value) {
+        FlushHeader(request);
+      }
+      request->current_header_field.append(at, length);
+      return 0;
+    };
+    settings_.on_header_value = [](llhttp_t* parser, const char* at,
+                                   size_t length) {
+      auto* request = Get(parser);
+      request->in_header_value = true;
+      request->current_header_value.append(at, length);
+      return 0;
+    };
+    settings_.on_headers_complete = [](llhttp_t* parser) {
+      auto* request = Get(parser);
+      if (request->in_header_value) {
+        FlushHeader(request);
+      }
+      return 0;
+    };
+    settings_.on_body = [](llhttp_t* parser, const char* at, size_t length) {
+      Get(parser)->body.append(at, length);
+      return 0;
+    };
+    // 每个请求完成后暂停，便于逐个取出流水线中的请求
+    settings_.on_message_complete = [](llhttp_t* parser) {
+      Get(parser)->is_complete = true;
+      return static_cast<int>(HPE_PAUSED);
+    };
+    llhttp_init(&parser_, HTTP_REQUEST, &settings_);
+    parser_.data = &request_;
+  }
+
+  // 解析数据，返回消费的字节数；请求完成时IsComplete()为true
+  size_t Execute(const char* data, size_t size) {
+    llhttp_errno_t err = llhttp_execute(&parser_, data, size);
+    if (err == HPE_PAUSED) {
+      size_t consumed = llhttp_get_error_pos(&parser_) - data;
+      llhttp_resume(&parser_);
+      return consumed;
+    }
+    if (err != HPE_OK) {
+      error_ = true;
+    }
+    return size;
+  }
+
+  bool IsComplete() const { return request_.is_complete; }
+  bool HasError() const { return error_; }
+  const LlhttpRequest& Request() const { return request_; }
+
+  void Reset() {
+    request_.Clear();
+    error_ = false;
+  }
+
+ private:
+  static LlhttpRequest* Get(llhttp_t* parser) {
+    return static_cast<LlhttpRequest*>(parser->data);
+  }
+
+  static void FlushHeader(LlhttpRequest* request) {
+    request->headers[request->current_header_field] =
+        request->current_header_value;
+    request->current_header_field.clear();
+    request->current_header_value.clear();
+    request->in_header_value = false;
+  }
+
+  llhttp_settings_t settings_;
+  llhttp_t parser_;
+  LlhttpRequest request_;
+  bool error_ = false;
+};
+
+// ---------------------------------------------------------------------------
+// 驱动函数：把一段输入按指定分片大小喂给解析器，返回解析出的请求数
+// ---------------------------------------------------------------------------
+
+// HttpRequest的Parse要求缓冲区始终从请求起始处开始，与连接的读缓冲区用法一致
+static int DriveHttpRequest(HttpRequest* request,
+                            const std::string& input,
+                            size_t fragment) {
+  int completed = 0;
+  size_t start = 0;    // 当前请求在input中的起始位置
+  size_t arrived = 0;  // 已到达的数据长度
+  while (arrived < input.size()) {
+    arrived = std::min(input.size(), arrived + fragment);
+    while (start < arrived &&
+           request->Parse(input.data() + start, arrived - start)) {
+      ++completed;
+      start += request->GetParsedBytes();
+      request->Reset();
+    }
+  }
+  return completed;
+}
+
+static int DriveLlhttp(LlhttpParser* parser,
+                       const std::string& input,
+                       size_t fragment) {
+  int completed = 0;
+  size_t offset = 0;
+  while (offset < input.size()) {
+    size_t chunk_end = std::min(input.size(), offset + fragment);
+    while (offset < chunk_end) {
+      offset += parser->Execute(input.data() + offset, chunk_end - offset);
+      if (parser->HasError()) {
+        return completed;
+      }
+      if (parser->IsComplete()) {
+        ++completed;
+        parser->Reset();
+      }
+    }
+  }
+  return completed;
+}
+
+// ---------------------------------------------------------------------------
+// 差异测试：两个解析器对同一输入必须给出相同的字段
+// ---------------------------------------------------------------------------
+
+static const char* MethodName(HttpMethod method) {
+  switch (method) {
+    case HttpMethod::kGet:
+      return "GET";
+    case HttpMethod::kPost:
+      return "POST";
+    case HttpMethod::kPut:
+      return "PUT";
+    case HttpMethod::kDelete:
+      return "DELETE";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+static bool SameFields(const HttpRequest& ours, const LlhttpRequest& theirs,
+                       std::string* diff) {
+  if (theirs.method != MethodName(ours.GetMethod())) {
+    *diff = "method: " + std::string(MethodName(ours.GetMethod())) +
+            " vs " + theirs.method;
+    return false;
+  }
+  std::string target = ours.GetPath();
+  if (!ours.GetQuery().empty()) {
+    target += "?" + ours.GetQuery();
+  }
+  if (theirs.url != target) {
+    *diff = "path: " + target + " vs " + theirs.url;
+    return false;
+  }
+  if ("HTTP/" + theirs.version != ours.GetVersion()) {
+    *diff = "version: " + ours.GetVersion() + " vs HTTP/" + theirs.version;
+    return false;
+  }
+  if (theirs.headers.size() != ours.GetHeaderCount()) {
+    *diff = "header count: " + std::to_string(ours.GetHeaderCount()) +
+            " vs " + std::to_string(theirs.headers.size());
+    return false;
+  }
+  for (const auto& header : theirs.headers) {
+    if (ours.GetHeader(header.first) != header.second) {
+      *diff = "header " + header.first + ": " +
+              ours.GetHeader(header.first) + " vs " + header.second;
+      return false;
+    }
+  }
+  if (theirs.body != ours.GetBody()) {
+    *diff = "body length: " + std::to_string(ours.GetBody().size()) +
+            " vs " + std::to_string(theirs.body.size());
+    return false;
+  }
+  return true;
+}
+
+// 逐个请求对比，返回不一致的用例数
+static int RunDifferentialCheck() {
+  struct Case {
+    const char* name;
+    const std::string* input;
+  };
+  const Case cases[] = {
+      {"tiny_get", &kTinyGet},
+      {"post_with_body", &kPostWithBody},
+      {"browser_40_headers", &kBrowserRequest},
+      {"pipelined_batch", &kPipelinedBatch},
+  };
+  const size_t fragments[] = {1, 7, 64, 1 << 20};
+
+  int failures = 0;
+  for (const Case& c : cases) {
+    for (size_t fragment : fragments) {
+      // 先用llhttp逐个取出请求，再用HttpRequest解析同样的数据逐个比对
+      HttpRequest ours;
+      LlhttpParser theirs;
+      std::string diff;
+      int index = 0;
+      size_t start = 0;
+      size_t arrived = 0;
+      size_t theirs_offset = 0;
+      bool ok = true;
+      while (ok && arrived < c.input->size()) {
+        arrived = std::min(c.input->size(), arrived + fragment);
+        while (ok && start < arrived &&
+               ours.Parse(c.input->data() + start, arrived - start)) {
+          // 让llhttp解析到同一个请求完成为止
+          while (!theirs.IsComplete() && !theirs.HasError() &&
+                 theirs_offset < c.input->size()) {
+            theirs_offset += theirs.Execute(c.input->data() + theirs_offset,
+                                            c.input->size() - theirs_offset);
+          }
+          if (!theirs.IsComplete()) {
+            diff = "llhttp did not complete the request";
+            ok = false;
+          } else if (!SameFields(ours, theirs.Request(), &diff)) {
+            ok = false;
+          }
+          start += ours.GetParsedBytes();
+          ours.Reset();
+          theirs.Reset();
+          ++index;
+        }
+      }
+      if (ok && start != c.input->size()) {
+        diff = "HttpRequest left " + std::to_string(c.input->size() - start) +
+               " unparsed bytes";
+        ok = false;
+      }
+      if (!ok) {
+        ++failures;
+        std::cerr << "差异测试失败: " << c.name << " fragment=" << fragment
+                  << " request#" << index << " " << diff << std::endl;
+      }
+    }
+  }
+  return failures;
+}
+
+// ---------------------------------------------------------------------------
+// 基准测试
+// ---------------------------------------------------------------------------
+
+// 统一输出 ns/请求、字节/周期 和 分配次数/请求
+static void ReportCounters(benchmark::State& state,
+                           const std::string& input,
+                           int requests_per_iteration,
+                           std::chrono::steady_clock::duration elapsed,
+                           uint64_t cycles,
+                           uint64_t allocs) {
+  double requests =
+      static_cast<double>(state.iterations()) * requests_per_iteration;
+  double bytes = static_cast<double>(state.iterations()) * input.size();
+  state.SetItemsProcessed(static_cast<int64_t>(requests));
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.counters["ns/req"] =
+      std::chrono::duration<double, std::nano>(elapsed).count() / requests;
+  state.counters["bytes/cycle"] = cycles ? bytes / cycles : 0.0;
+  state.counters["allocs/req"] = allocs / requests;
+}
+
+static void BM_HttpRequestParse(benchmark::State& state,
+                                const std::string* input,
+                                size_t fragment) {
+  HttpRequest request;
+  int per_iteration = DriveHttpRequest(&request, *input, fragment);
+
+  uint64_t allocs_before = g_alloc_count.load(std::memory_order_relaxed);
+  uint64_t cycles_before = ReadCycles();
+  auto start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    int completed = DriveHttpRequest(&request, *input, fragment);
+    benchmark::DoNotOptimize(completed);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  uint64_t cycles = ReadCycles() - cycles_before;
+  uint64_t allocs = g_alloc_count.load(std::memory_order_relaxed) -
+                    allocs_before;
+
+  ReportCounters(state, *input, per_iteration, elapsed, cycles, allocs);
+}
+
+static void BM_LlhttpParse(benchmark::State& state,
+                           const std::string* input,
+                           size_t fragment) {
+  LlhttpParser parser;
+  int per_iteration = DriveLlhttp(&parser, *input, fragment);
+
+  uint64_t allocs_before = g_alloc_count.load(std::memory_order_relaxed);
+  uint64_t cycles_before = ReadCycles();
+  auto start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    int completed = DriveLlhttp(&parser, *input, fragment);
+    benchmark::DoNotOptimize(completed);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  uint64_t cycles = ReadCycles() - cycles_before;
+  uint64_t allocs = g_alloc_count.load(std::memory_order_relaxed) -
+                    allocs_before;
+
+  ReportCounters(state, *input, per_iteration, elapsed, cycles, allocs);
+}
+
+// 整块到达
+BENCHMARK_CAPTURE(BM_HttpRequestParse, tiny_get, &kTinyGet, 1 << 20);
+BENCHMARK_CAPTURE(BM_LlhttpParse, tiny_get, &kTinyGet, 1 << 20);
+BENCHMARK_CAPTURE(BM_HttpRequestParse, browser_40_headers, &kBrowserRequest,
+                  1 << 20);
+BENCHMARK_CAPTURE(BM_LlhttpParse, browser_40_headers, &kBrowserRequest,
+                  1 << 20);
+BENCHMARK_CAPTURE(BM_HttpRequestParse, pipelined_batch, &kPipelinedBatch,
+                  1 << 20);
+BENCHMARK_CAPTURE(BM_LlhttpParse, pipelined_batch, &kPipelinedBatch, 1 << 20);
+
+// 逐字节到达
+BENCHMARK_CAPTURE(BM_HttpRequestParse, tiny_get_bytewise, &kTinyGet, 1);
+BENCHMARK_CAPTURE(BM_LlhttpParse, tiny_get_bytewise, &kTinyGet, 1);
+BENCHMARK_CAPTURE(BM_HttpRequestParse, browser_40_headers_bytewise,
+                  &kBrowserRequest, 1);
+BENCHMARK_CAPTURE(BM_LlhttpParse, browser_40_headers_bytewise,
+                  &kBrowserRequest, 1);
+
+int main(int argc, char** argv) {
+  // 先做差异测试，字段不一致时基准数据没有意义
+  int failures = RunDifferentialCheck();
+  if (failures > 0) {
+    std::cerr << "差异测试失败用例数: " << failures << std::endl;
+    return 1;
+  }
+  std::cout << "差异测试通过" << std::endl;
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
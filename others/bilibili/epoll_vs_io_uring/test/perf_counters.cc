@@ -0,0 +1,170 @@
+// 用perf_event_open统计另一个进程的系统调用和硬件事件实现
+#include "perf_counters.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <fstream>
+
+PerfCounters::PerfCounters(pid_t pid)
+    : syscall_tracepoint_(GetSyscallTracepoint()), user_only_(false) {
+  // 列出进程当前的线程
+  std::vector<pid_t> tids;
+  std::string dir = "/proc/" + std::to_string(pid) + "/task";
+  DIR* tasks = opendir(dir.c_str());
+  if (tasks != nullptr) {
+    while (struct dirent* entry = readdir(tasks)) {
+      if (entry->d_name[0] != '.') {
+        tids.push_back(static_cast<pid_t>(std::stol(entry->d_name)));
+      }
+    }
+    closedir(tasks);
+  }
+  if (tids.empty()) {
+    error_ = "无法读取进程 " + std::to_string(pid) + " 的线程";
+    return;
+  }
+
+  for (int counter = 0; counter < kNumCounters; ++counter) {
+    for (pid_t tid : tids) {
+      int fd = Open(static_cast<Counter>(counter), tid, user_only_);
+
+      // perf_event_paranoid较高时只允许统计用户态，硬件计数器退而求其次
+      if (fd < 0 && (errno == EACCES || errno == EPERM) &&
+          counter != kSyscalls && !user_only_) {
+        user_only_ = true;
+        fd = Open(static_cast<Counter>(counter), tid, true);
+      }
+      if (fd < 0) {
+        error_ += error_.empty() ? "" : "；";
+        if (counter == kSyscalls && syscall_tracepoint_ < 0) {
+          error_ += "找不到raw_syscalls跟踪点，tracefs可能未挂载";
+        } else {
+          error_ += std::string(GetName(static_cast<Counter>(counter))) +
+                    ": " + strerror(errno);
+        }
+        for (int opened : fds_[counter]) {
+          close(opened);
+        }
+        fds_[counter].clear();
+        break;
+      }
+      fds_[counter].push_back(fd);
+    }
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (int counter = 0; counter < kNumCounters; ++counter) {
+    for (int fd : fds_[counter]) {
+      close(fd);
+    }
+  }
+}
+
+bool PerfCounters::IsAvailable(Counter counter) const {
+  return !fds_[counter].empty();
+}
+
+bool PerfCounters::IsUserOnly() const {
+  return user_only_;
+}
+
+const std::string& PerfCounters::GetError() const {
+  return error_;
+}
+
+PerfCounters::Reading PerfCounters::Read() const {
+  Reading reading;
+  for (int counter = 0; counter < kNumCounters; ++counter) {
+    reading.values[counter] = 0;
+    for (int fd : fds_[counter]) {
+      // 读出的格式：计数值、启用时间、实际计数时间
+      uint64_t data[3];
+      if (read(fd, data, sizeof(data)) != sizeof(data)) {
+        continue;
+      }
+      uint64_t value = data[0];
+      if (data[2] > 0 && data[2] < data[1]) {
+        value = static_cast<uint64_t>(static_cast<double>(value) * data[1] /
+                                      data[2]);
+      }
+      reading.values[counter] += value;
+    }
+  }
+  return reading;
+}
+
+const char* PerfCounters::GetName(Counter counter) {
+  switch (counter) {
+    case kSyscalls:
+      return "系统调用";
+    case kInstructions:
+      return "指令";
+    case kCycles:
+      return "CPU周期";
+    case kCacheMisses:
+      return "缓存未命中";
+    case kNumCounters:
+      break;
+  }
+  return "";
+}
+
+int PerfCounters::Open(Counter counter, pid_t tid, bool user_only) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.inherit = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  switch (counter) {
+    case kSyscalls:
+      if (syscall_tracepoint_ < 0) {
+        errno = ENOENT;
+        return -1;
+      }
+      attr.type = PERF_TYPE_TRACEPOINT;
+      attr.config = syscall_tracepoint_;
+      break;
+    case kInstructions:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case kCycles:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case kCacheMisses:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case kNumCounters:
+      errno = EINVAL;
+      return -1;
+  }
+  attr.exclude_kernel = user_only ? 1 : 0;
+  attr.exclude_hv = 1;
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+int64_t PerfCounters::GetSyscallTracepoint() {
+  // tracefs可能挂在两个位置之一
+  const char* const kPaths[] = {
+      "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+      "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id",
+  };
+  for (const char* path : kPaths) {
+    std::ifstream in(path);
+    int64_t id;
+    if (in >> id) {
+      return id;
+    }
+  }
+  return -1;
+}
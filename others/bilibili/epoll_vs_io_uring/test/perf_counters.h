@@ -0,0 +1,66 @@
+// 用perf_event_open统计另一个进程的系统调用和硬件事件
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+// 进程的性能计数器
+// 为进程当前的每个线程各打开一组计数器，并设置inherit让之后创建的线程也被
+// 计入；计数器从打开起一直计数，取两次读数的差。某个计数器打不开
+// （内核不支持、没有权限、虚拟机没有硬件计数器等）时只是不可用，
+// 不影响其他计数器。
+class PerfCounters {
+ public:
+  // 计数器
+  enum Counter {
+    kSyscalls,      // 系统调用次数，raw_syscalls:sys_enter跟踪点
+    kInstructions,  // 执行的指令数
+    kCycles,        // CPU周期数
+    kCacheMisses,   // 缓存未命中数（最后一级缓存）
+    kNumCounters,
+  };
+
+  // 一次读数
+  struct Reading {
+    uint64_t values[kNumCounters];  // 各计数器的累计值，不可用时为0
+  };
+
+  explicit PerfCounters(pid_t pid);
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // 计数器是否可用
+  bool IsAvailable(Counter counter) const;
+
+  // 硬件计数器是否因为权限只统计了用户态
+  bool IsUserOnly() const;
+
+  // 打不开的计数器及原因，全部可用时为空
+  const std::string& GetError() const;
+
+  // 读取所有计数器，计数器被轮流调度时按实际计数的时间比例放大
+  Reading Read() const;
+
+  // 获取计数器的名字
+  static const char* GetName(Counter counter);
+
+ private:
+  // 为一个线程打开计数器，失败时返回-1并设置errno
+  int Open(Counter counter, pid_t tid, bool user_only);
+
+  // 读取raw_syscalls:sys_enter跟踪点的编号，失败时返回-1
+  static int64_t GetSyscallTracepoint();
+
+  std::vector<int> fds_[kNumCounters];  // 各计数器每个线程一个描述符
+  int64_t syscall_tracepoint_;          // sys_enter跟踪点的编号
+  bool user_only_;                      // 硬件计数器是否只统计用户态
+  std::string error_;                   // 打不开的计数器及原因
+};
+
+#endif  // PERF_COUNTERS_H_
@@ -0,0 +1,145 @@
+// 从/proc读取进程的资源占用实现
+#include "process_stats.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// 读取整个文件，失败时返回空
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+// 读取/proc/<pid>/status中的一个数值字段，kB等单位忽略，
+// 没有该字段时返回false
+bool ReadStatusField(const std::string& status, const char* name,
+                     uint64_t* value) {
+  std::string key = std::string("\n") + name + ":";
+  size_t pos = status.find(key);
+  if (pos == std::string::npos) {
+    return false;
+  }
+  unsigned long long number;
+  if (sscanf(status.c_str() + pos + key.size(), "%llu", &number) != 1) {
+    return false;
+  }
+  *value = number;
+  return true;
+}
+
+}  // namespace
+
+bool ReadProcessSample(pid_t pid, ProcessSample* sample) {
+  std::string dir = "/proc/" + std::to_string(pid);
+
+  // stat的第二个字段是括号中的进程名，可能含空格，从右括号之后开始解析；
+  // 之后的第12、13个字段是整个进程用户态和内核态的时钟滴答数
+  std::string line = ReadFile(dir + "/stat");
+  size_t paren = line.rfind(')');
+  if (paren == std::string::npos) {
+    return false;
+  }
+  std::istringstream fields(line.substr(paren + 1));
+  std::string field;
+  unsigned long long utime = 0;
+  unsigned long long stime = 0;
+  for (int i = 1; i <= 13 && fields >> field; ++i) {
+    if (i == 12) {
+      utime = std::stoull(field);
+    } else if (i == 13) {
+      stime = std::stoull(field);
+    }
+  }
+  if (!fields) {
+    return false;
+  }
+  long ticks = sysconf(_SC_CLK_TCK);
+  sample->user_ns = utime * 1000000000ULL / ticks;
+  sample->sys_ns = stime * 1000000000ULL / ticks;
+  sample->cpu_ns = sample->user_ns + sample->sys_ns;
+
+  std::string status = ReadFile(dir + "/status");
+  sample->rss_kb = 0;
+  sample->peak_kb = 0;
+  sample->threads = 0;
+  ReadStatusField(status, "VmRSS", &sample->rss_kb);
+  ReadStatusField(status, "VmHWM", &sample->peak_kb);
+  ReadStatusField(status, "Threads", &sample->threads);
+
+  sample->voluntary_switches = 0;
+  sample->involuntary_switches = 0;
+  DIR* tasks = opendir((dir + "/task").c_str());
+  if (tasks == nullptr) {
+    return true;
+  }
+  while (struct dirent* entry = readdir(tasks)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    std::string task = ReadFile(dir + "/task/" + entry->d_name + "/status");
+    uint64_t voluntary = 0;
+    uint64_t involuntary = 0;
+    ReadStatusField(task, "voluntary_ctxt_switches", &voluntary);
+    ReadStatusField(task, "nonvoluntary_ctxt_switches", &involuntary);
+    sample->voluntary_switches += voluntary;
+    sample->involuntary_switches += involuntary;
+  }
+  closedir(tasks);
+  return true;
+}
+
+ProcessSampler::ProcessSampler(pid_t pid, uint64_t start_ns,
+                               uint64_t interval_ns)
+    : pid_(pid),
+      start_ns_(start_ns),
+      interval_ns_(interval_ns),
+      stopping_(false),
+      thread_(&ProcessSampler::Run, this) {}
+
+ProcessSampler::~ProcessSampler() {
+  Stop();
+}
+
+void ProcessSampler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeup_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+const std::vector<ProcessSample>& ProcessSampler::GetSamples() const {
+  return samples_;
+}
+
+void ProcessSampler::Run() {
+  // steady_clock在Linux上就是CLOCK_MONOTONIC，与调用者的时刻可以直接比较
+  using Clock = std::chrono::steady_clock;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (uint64_t i = 0;; ++i) {
+    Clock::time_point deadline(
+        std::chrono::nanoseconds(start_ns_ + i * interval_ns_));
+    if (wakeup_.wait_until(lock, deadline, [this] { return stopping_; })) {
+      return;
+    }
+    ProcessSample sample;
+    if (!ReadProcessSample(pid_, &sample)) {
+      return;
+    }
+    samples_.push_back(sample);
+  }
+}
@@ -0,0 +1,61 @@
+// 从/proc读取进程的资源占用
+#ifndef PROCESS_STATS_H_
+#define PROCESS_STATS_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 进程在某一时刻的资源占用，累计值取两次采样的差
+struct ProcessSample {
+  uint64_t user_ns;               // 累计的用户态CPU时间
+  uint64_t sys_ns;                // 累计的内核态CPU时间
+  uint64_t cpu_ns;                // user_ns与sys_ns之和
+  uint64_t voluntary_switches;    // 所有线程累计的主动上下文切换
+  uint64_t involuntary_switches;  // 所有线程累计的被动上下文切换
+  uint64_t rss_kb;                // 常驻内存
+  uint64_t peak_kb;               // 常驻内存的峰值
+  uint64_t threads;               // 线程数
+};
+
+// 读取进程的资源占用，进程不存在或/proc不可读时返回false
+// 上下文切换在/proc/<pid>/status中只是主线程的，这里累加所有线程，
+// 已经退出的线程不再计入
+bool ReadProcessSample(pid_t pid, ProcessSample* sample);
+
+// 在后台线程中按固定间隔采样进程
+// 第i个采样在start_ns + i * interval_ns时刻（单调时钟）读取，
+// 与LatencyTimeSeries的分段对齐，相邻两个采样的差就是这一段的资源占用
+class ProcessSampler {
+ public:
+  ProcessSampler(pid_t pid, uint64_t start_ns, uint64_t interval_ns);
+  ~ProcessSampler();
+
+  ProcessSampler(const ProcessSampler&) = delete;
+  ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+  // 停止采样并等待后台线程退出，之后才能读取采样
+  void Stop();
+
+  // 获取所有采样，进程退出后不再采样
+  const std::vector<ProcessSample>& GetSamples() const;
+
+ private:
+  // 后台线程函数
+  void Run();
+
+  pid_t pid_;                           // 被采样的进程
+  uint64_t start_ns_;                   // 第一个采样的时刻
+  uint64_t interval_ns_;                // 采样间隔
+  std::vector<ProcessSample> samples_;  // 采样结果
+  std::mutex mutex_;                    // 保护stopping_
+  std::condition_variable wakeup_;      // 通知后台线程停止
+  bool stopping_;                       // 是否正在停止
+  std::thread thread_;                  // 后台线程
+};
+
+#endif  // PROCESS_STATS_H_
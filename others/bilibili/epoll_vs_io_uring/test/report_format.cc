@@ -0,0 +1,21 @@
+// 压测报告的格式化工具实现
+#include "report_format.h"
+
+#include <stdio.h>
+
+std::string FormatMillis(uint64_t ns) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.3f", ns / 1e6);
+  return text;
+}
+
+std::string PadLeft(const std::string& text, size_t width) {
+  size_t columns = 0;
+  for (unsigned char c : text) {
+    // 跳过UTF-8的后续字节，三字节及以上的字符按两列计算
+    if ((c & 0xC0) != 0x80) {
+      columns += c >= 0xE0 ? 2 : 1;
+    }
+  }
+  return columns < width ? std::string(width - columns, ' ') + text : text;
+}
@@ -0,0 +1,15 @@
+// 压测报告的格式化工具
+#ifndef REPORT_FORMAT_H_
+#define REPORT_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// 纳秒格式化为毫秒，保留三位小数
+std::string FormatMillis(uint64_t ns);
+
+// 左侧补空格到指定的显示宽度，中文字符按两列计算
+std::string PadLeft(const std::string& text, size_t width);
+
+#endif  // REPORT_FORMAT_H_
@@ -0,0 +1,62 @@
+// 压测请求的模板实现
+#include "request_template.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const char RequestTemplate::kSequencePlaceholder[] = "{seq}";
+
+RequestTemplate::RequestTemplate(const std::string& ip, int port,
+                                 const std::string& path)
+    : RequestTemplate("GET", path,
+                      "Host: " + ip + ":" + std::to_string(port) + "\r\n",
+                      "") {}
+
+RequestTemplate::RequestTemplate(const std::string& method,
+                                 const std::string& path,
+                                 const std::string& headers,
+                                 const std::string& body)
+    : has_sequence_(false) {
+  std::string head = method + " " + path + " HTTP/1.1\r\n";
+  std::string tail = headers;
+  if (!body.empty()) {
+    tail += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+  }
+
+  // 只替换第一个占位符，请求在占位符处分成前后两部分
+  size_t pos = head.find(kSequencePlaceholder);
+  if (pos != std::string::npos) {
+    has_sequence_ = true;
+    prefix_ = head.substr(0, pos);
+    head = head.substr(pos + strlen(kSequencePlaceholder));
+  }
+
+  keep_alive_request_ = head + tail + "Connection: keep-alive\r\n\r\n" + body;
+  close_request_ = head + tail + "Connection: close\r\n\r\n" + body;
+}
+
+RequestTemplate::~RequestTemplate() {}
+
+bool RequestTemplate::HasSequence() const {
+  return has_sequence_;
+}
+
+void RequestTemplate::Append(uint64_t sequence, bool keep_alive,
+                             std::string* out) const {
+  if (has_sequence_) {
+    out->append(prefix_);
+    out->append(FormatSequence(sequence));
+  }
+  out->append(keep_alive ? keep_alive_request_ : close_request_);
+}
+
+const std::string& RequestTemplate::Get(bool keep_alive) const {
+  return keep_alive ? keep_alive_request_ : close_request_;
+}
+
+std::string RequestTemplate::FormatSequence(uint64_t sequence) {
+  char text[32];
+  snprintf(text, sizeof(text), "s%012llu",
+           static_cast<unsigned long long>(sequence));
+  return text;
+}
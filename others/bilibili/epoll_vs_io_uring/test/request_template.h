@@ -0,0 +1,45 @@
+// 压测请求的模板
+#ifndef REQUEST_TEMPLATE_H_
+#define REQUEST_TEMPLATE_H_
+
+#include <stdint.h>
+#include <string>
+
+// 压测请求的模板
+// 没有占位符的请求预先生成保持连接和关闭连接两种，追加时直接复制。
+// 路径中的{seq}替换为每个请求唯一的序号（固定宽度，不会是另一个序号的
+// 子串），配合会回显路径的路由（如/users/{seq}），按响应体中是否包含
+// 序号检查流水线响应的顺序。
+class RequestTemplate {
+ public:
+  static const char kSequencePlaceholder[];  // 序号的占位符
+
+  // 不带请求体的GET请求
+  RequestTemplate(const std::string& ip, int port, const std::string& path);
+
+  // 任意请求，headers为完整的请求头行（含Host，每行以CRLF结尾，
+  // 不含Connection），body不为空时自动加上Content-Length
+  RequestTemplate(const std::string& method, const std::string& path,
+                  const std::string& headers, const std::string& body);
+  ~RequestTemplate();
+
+  // 路径中是否有序号占位符
+  bool HasSequence() const;
+
+  // 把一个请求追加到*out，keep_alive为false时要求服务器回答后关闭连接
+  void Append(uint64_t sequence, bool keep_alive, std::string* out) const;
+
+  // 获取没有占位符时的完整请求
+  const std::string& Get(bool keep_alive) const;
+
+  // 序号替换占位符后的文本，也是在响应体中查找的内容
+  static std::string FormatSequence(uint64_t sequence);
+
+ private:
+  std::string keep_alive_request_;  // 保持连接的请求（占位符之后的部分）
+  std::string close_request_;       // 关闭连接的请求（占位符之后的部分）
+  std::string prefix_;              // 占位符之前的部分，没有占位符时为空
+  bool has_sequence_;               // 路径中是否有序号占位符
+};
+
+#endif  // REQUEST_TEMPLATE_H_
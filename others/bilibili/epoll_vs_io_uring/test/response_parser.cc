@@ -0,0 +1,254 @@
+// 基准测试客户端的HTTP响应解析器实现
+#include "response_parser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+
+#include "ascii.h"
+
+namespace {
+
+// 不区分大小写查找
+bool ContainsIgnoreCase(std::string_view haystack, std::string_view needle) {
+  for (size_t i = 0; i + needle.size() <= haystack.size(); ++i) {
+    if (EqualsIgnoreCase(haystack.substr(i, needle.size()), needle)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+ResponseParser::ResponseParser() : keep_body_(false) {
+  Reset();
+}
+
+ResponseParser::~ResponseParser() {}
+
+size_t ResponseParser::Feed(const char* data, size_t size) {
+  size_t offset = 0;
+  while (offset < size && state_ != State::kComplete &&
+         state_ != State::kError) {
+    const char* p = data + offset;
+    size_t available = size - offset;
+    size_t consumed = 0;
+
+    switch (state_) {
+      case State::kHeaders:
+        if (ReadLine(p, available, "\r\n\r\n", &consumed)) {
+          ParseHeaders();
+        } else if (line_.size() > kMaxHeaderSize) {
+          state_ = State::kError;
+        }
+        break;
+
+      case State::kBody:
+      case State::kChunkData:
+        consumed = available < remaining_ ? available : remaining_;
+        remaining_ -= consumed;
+        body_size_ += consumed;
+        if (keep_body_) {
+          body_.append(p, consumed);
+        }
+        if (remaining_ == 0) {
+          state_ = state_ == State::kBody ? State::kComplete : State::kChunkEnd;
+        }
+        break;
+
+      case State::kChunkSize:
+        if (ReadLine(p, available, "\r\n", &consumed)) {
+          // chunk扩展（';'之后）忽略
+          size_t chunk = 0;
+          const char* begin = line_.data();
+          const char* end = begin + line_.size() - 2;
+          auto result = std::from_chars(begin, end, chunk, 16);
+          if (result.ptr == begin) {
+            state_ = State::kError;
+          } else if (chunk == 0) {
+            state_ = State::kTrailers;
+          } else {
+            remaining_ = chunk;
+            state_ = State::kChunkData;
+          }
+          line_.clear();
+        }
+        break;
+
+      case State::kChunkEnd:
+        if (ReadLine(p, available, "\r\n", &consumed)) {
+          state_ = line_.size() == 2 ? State::kChunkSize : State::kError;
+          line_.clear();
+        }
+        break;
+
+      case State::kTrailers:
+        // trailer逐行读取，空行结束
+        if (ReadLine(p, available, "\r\n", &consumed)) {
+          if (line_.size() == 2) {
+            state_ = State::kComplete;
+          }
+          line_.clear();
+        }
+        break;
+
+      case State::kUntilClose:
+        consumed = available;
+        body_size_ += consumed;
+        if (keep_body_) {
+          body_.append(p, consumed);
+        }
+        break;
+
+      case State::kComplete:
+      case State::kError:
+        break;
+    }
+    offset += consumed;
+  }
+  return offset;
+}
+
+void ResponseParser::OnEof() {
+  if (state_ == State::kUntilClose) {
+    state_ = State::kComplete;
+  } else if (state_ != State::kComplete) {
+    state_ = State::kError;
+  }
+}
+
+void ResponseParser::Reset() {
+  state_ = State::kHeaders;
+  line_.clear();
+  status_code_ = 0;
+  remaining_ = 0;
+  body_size_ = 0;
+  close_ = false;
+  body_.clear();
+}
+
+void ResponseParser::KeepBody(bool keep) {
+  keep_body_ = keep;
+}
+
+bool ResponseParser::IsComplete() const {
+  return state_ == State::kComplete;
+}
+
+bool ResponseParser::HasError() const {
+  return state_ == State::kError;
+}
+
+int ResponseParser::GetStatusCode() const {
+  return status_code_;
+}
+
+size_t ResponseParser::GetBodySize() const {
+  return body_size_;
+}
+
+bool ResponseParser::ShouldClose() const {
+  return close_;
+}
+
+const std::string& ResponseParser::GetBody() const {
+  return body_;
+}
+
+bool ResponseParser::ReadLine(const char* data, size_t size,
+                              const char* terminator, size_t* consumed) {
+  std::string_view end(terminator);
+
+  // 结束符可能跨两次读取，先在上次的末尾和这次的开头拼接处查找
+  if (!line_.empty()) {
+    size_t tail = std::min(line_.size(), end.size() - 1);
+    std::string joined = line_.substr(line_.size() - tail);
+    joined.append(data, std::min(size, end.size() - 1));
+    size_t pos = joined.find(end);
+    if (pos != std::string::npos) {
+      *consumed = pos + end.size() - tail;
+      line_.append(data, *consumed);
+      return true;
+    }
+  }
+
+  size_t pos = std::string_view(data, size).find(end);
+  *consumed = pos == std::string_view::npos ? size : pos + end.size();
+  line_.append(data, *consumed);
+  return pos != std::string_view::npos;
+}
+
+void ResponseParser::ParseHeaders() {
+  std::string_view headers = line_;
+
+  // 状态行：HTTP/1.x 200 OK
+  size_t line_end = headers.find("\r\n");
+  std::string_view status_line = headers.substr(0, line_end);
+  if (status_line.size() < 12 || status_line.compare(0, 5, "HTTP/") != 0) {
+    state_ = State::kError;
+    return;
+  }
+  bool http10 = status_line.compare(0, 8, "HTTP/1.0") == 0;
+  auto result = std::from_chars(status_line.data() + 9,
+                                status_line.data() + 12, status_code_);
+  if (result.ptr != status_line.data() + 12) {
+    state_ = State::kError;
+    return;
+  }
+
+  bool has_length = false;
+  bool chunked = false;
+  bool keep_alive = false;
+  size_t content_length = 0;
+
+  headers.remove_prefix(line_end + 2);
+  while (!headers.empty()) {
+    line_end = headers.find("\r\n");
+    std::string_view header = headers.substr(0, line_end);
+    headers.remove_prefix(line_end + 2);
+    if (header.empty()) {
+      break;
+    }
+
+    size_t colon = header.find(':');
+    if (colon == std::string_view::npos) {
+      continue;
+    }
+    std::string_view name = header.substr(0, colon);
+    std::string_view value = TrimSpaces(header.substr(colon + 1));
+
+    if (EqualsIgnoreCase(name, "Content-Length")) {
+      auto parsed = std::from_chars(value.data(), value.data() + value.size(),
+                                    content_length);
+      if (parsed.ptr != value.data() + value.size()) {
+        state_ = State::kError;
+        return;
+      }
+      has_length = true;
+    } else if (EqualsIgnoreCase(name, "Transfer-Encoding")) {
+      chunked = ContainsIgnoreCase(value, "chunked");
+    } else if (EqualsIgnoreCase(name, "Connection")) {
+      close_ = ContainsIgnoreCase(value, "close");
+      keep_alive = ContainsIgnoreCase(value, "keep-alive");
+    }
+  }
+  if (http10 && !keep_alive) {
+    close_ = true;
+  }
+  line_.clear();
+
+  // 1xx、204和304响应没有响应体
+  if ((status_code_ >= 100 && status_code_ < 200) || status_code_ == 204 ||
+      status_code_ == 304) {
+    state_ = State::kComplete;
+  } else if (chunked) {
+    state_ = State::kChunkSize;
+  } else if (has_length) {
+    remaining_ = content_length;
+    state_ = content_length > 0 ? State::kBody : State::kComplete;
+  } else {
+    close_ = true;
+    state_ = State::kUntilClose;
+  }
+}
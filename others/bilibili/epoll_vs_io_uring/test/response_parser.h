@@ -0,0 +1,81 @@
+// 基准测试客户端的HTTP响应解析器
+#ifndef RESPONSE_PARSER_H_
+#define RESPONSE_PARSER_H_
+
+#include <stddef.h>
+#include <string>
+
+// 增量解析HTTP/1.1响应
+// 响应可能分多次到达，每次把收到的数据交给Feed()，直到一个响应完整。
+// 响应体按Content-Length或chunked编码确定边界，默认只计数不保存；两者都没有时
+// 响应体以连接关闭结束。一个响应完整后调用Reset()，从剩余数据中继续解析
+// 同一连接上的下一个响应。
+class ResponseParser {
+ public:
+  static const size_t kMaxHeaderSize = 64 * 1024;  // 响应头的最大长度
+
+  ResponseParser();
+  ~ResponseParser();
+
+  // 解析data，返回消耗的字节数；响应完整或出错后不再消耗
+  size_t Feed(const char* data, size_t size);
+
+  // 连接被对端关闭，以关闭连接结束的响应到此完整，其余响应出错
+  void OnEof();
+
+  // 准备解析下一个响应
+  void Reset();
+
+  // 是否保存响应体，用于检查响应内容，设置在Reset()后保持
+  void KeepBody(bool keep);
+
+  // 响应是否已完整
+  bool IsComplete() const;
+
+  // 响应格式是否错误
+  bool HasError() const;
+
+  // 获取状态码
+  int GetStatusCode() const;
+
+  // 获取响应体长度（chunked编码时为解码后的长度）
+  size_t GetBodySize() const;
+
+  // 服务器是否会在这个响应后关闭连接
+  bool ShouldClose() const;
+
+  // 获取保存的响应体，未开启KeepBody()时为空
+  const std::string& GetBody() const;
+
+ private:
+  // 解析状态
+  enum class State {
+    kHeaders,     // 读取响应头
+    kBody,        // 按Content-Length读取响应体
+    kChunkSize,   // 读取chunk大小行
+    kChunkData,   // 读取chunk数据
+    kChunkEnd,    // 读取chunk数据后的CRLF
+    kTrailers,    // 读取结束块后的trailer
+    kUntilClose,  // 读取到连接关闭
+    kComplete,    // 响应完整
+    kError        // 格式错误
+  };
+
+  // 把data中到行尾（或空行）为止的数据追加到line_，完整时返回true
+  bool ReadLine(const char* data, size_t size, const char* terminator,
+                size_t* consumed);
+
+  // 解析line_中完整的响应头
+  void ParseHeaders();
+
+  State state_;         // 当前状态
+  std::string line_;    // 未解析完的响应头或chunk行
+  int status_code_;     // 状态码
+  size_t remaining_;    // 当前响应体或chunk剩余的字节数
+  size_t body_size_;    // 已读取的响应体长度
+  bool close_;          // 服务器是否会关闭连接
+  bool keep_body_;      // 是否保存响应体
+  std::string body_;    // 保存的响应体（chunked编码时为解码后的内容）
+};
+
+#endif  // RESPONSE_PARSER_H_
@@ -0,0 +1,278 @@
+// 压测场景实现
+#include "scenario.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string_view>
+
+namespace {
+
+// 请求体长度的分布
+struct BodySizes {
+  enum class Kind { kNone, kFixed, kUniform, kChoice };
+
+  Kind kind = Kind::kNone;
+  std::vector<size_t> values;  // 固定值、均匀分布的上下界或可选的长度
+
+  // 按分布取一个长度
+  size_t Sample(std::mt19937_64* rng) const {
+    switch (kind) {
+      case Kind::kNone:
+        return 0;
+      case Kind::kFixed:
+        return values[0];
+      case Kind::kUniform:
+        return std::uniform_int_distribution<size_t>(values[0],
+                                                     values[1])(*rng);
+      case Kind::kChoice:
+        return values[std::uniform_int_distribution<size_t>(
+            0, values.size() - 1)(*rng)];
+    }
+    return 0;
+  }
+};
+
+// 文件中的一个条目，生成请求前的原始内容
+struct EntrySpec {
+  std::string name;
+  uint32_t weight = 1;
+  std::string method = "GET";
+  std::vector<std::string> paths;
+  std::string headers;
+  BodySizes body_sizes;
+  int variants = 16;
+};
+
+// 去掉两端的空白
+std::string_view Trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t' ||
+                        s.front() == '\r')) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' ||
+                        s.back() == '\r')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+// 解析一个非负整数，整个字符串都必须是数字
+bool ParseNumber(std::string_view text, size_t* value) {
+  text = Trim(text);
+  auto result = std::from_chars(text.data(), text.data() + text.size(), *value);
+  return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// 解析请求体长度：N、A-B或A,B,C
+bool ParseBodySizes(std::string_view text, BodySizes* sizes) {
+  sizes->values.clear();
+  size_t dash = text.find('-');
+  if (dash != std::string_view::npos) {
+    size_t low;
+    size_t high;
+    if (!ParseNumber(text.substr(0, dash), &low) ||
+        !ParseNumber(text.substr(dash + 1), &high) || low > high) {
+      return false;
+    }
+    sizes->kind = BodySizes::Kind::kUniform;
+    sizes->values = {low, high};
+    return true;
+  }
+
+  while (!text.empty()) {
+    size_t comma = text.find(',');
+    size_t value;
+    if (!ParseNumber(text.substr(0, comma), &value)) {
+      return false;
+    }
+    sizes->values.push_back(value);
+    text = comma == std::string_view::npos ? std::string_view()
+                                           : text.substr(comma + 1);
+  }
+  if (sizes->values.empty()) {
+    return false;
+  }
+  sizes->kind = sizes->values.size() == 1 ? BodySizes::Kind::kFixed
+                                          : BodySizes::Kind::kChoice;
+  return true;
+}
+
+// 把请求头中的{bytes:N}替换为N个字符，用来构造大Cookie等请求头
+bool ExpandHeader(std::string_view header, std::string* out) {
+  const std::string_view kFiller = "{bytes:";
+  for (;;) {
+    size_t pos = header.find(kFiller);
+    if (pos == std::string_view::npos) {
+      out->append(header);
+      return true;
+    }
+    size_t end = header.find('}', pos);
+    size_t count;
+    if (end == std::string_view::npos ||
+        !ParseNumber(header.substr(pos + kFiller.size(),
+                                   end - pos - kFiller.size()),
+                     &count)) {
+      return false;
+    }
+    out->append(header.substr(0, pos));
+    out->append(count, 'a');
+    header.remove_prefix(end + 1);
+  }
+}
+
+}  // namespace
+
+Scenario::Scenario() : has_sequence_(false) {}
+
+Scenario::Scenario(const std::string& ip, int port, const std::string& path)
+    : has_sequence_(false) {
+  Entry entry;
+  entry.name = path;
+  entry.weight = 1;
+  entry.templates.emplace_back(ip, port, path);
+  AddEntry(std::move(entry));
+}
+
+Scenario::~Scenario() {}
+
+std::unique_ptr<Scenario> Scenario::Load(const std::string& file,
+                                         const std::string& ip, int port,
+                                         std::string* error) {
+  std::ifstream in(file);
+  if (!in) {
+    *error = "无法打开场景文件: " + file;
+    return nullptr;
+  }
+
+  // 先读出所有条目，再统一生成请求
+  std::vector<EntrySpec> specs;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    std::string_view text = Trim(line);
+    if (text.empty() || text.front() == '#') {
+      continue;
+    }
+
+    std::string where = file + ":" + std::to_string(line_number) + ": ";
+    if (text.front() == '[') {
+      if (text.back() != ']' || text.size() < 3) {
+        *error = where + "条目名格式错误";
+        return nullptr;
+      }
+      specs.emplace_back();
+      specs.back().name = std::string(text.substr(1, text.size() - 2));
+      continue;
+    }
+    if (specs.empty()) {
+      *error = where + "第一个条目之前不能有内容";
+      return nullptr;
+    }
+
+    EntrySpec& spec = specs.back();
+    size_t space = text.find_first_of(" \t");
+    std::string_view key = text.substr(0, space);
+    std::string_view value =
+        space == std::string_view::npos ? "" : Trim(text.substr(space));
+    size_t number;
+    bool ok = true;
+    if (key == "weight") {
+      ok = ParseNumber(value, &number) && number > 0 && number <= UINT32_MAX;
+      spec.weight = static_cast<uint32_t>(number);
+    } else if (key == "method") {
+      ok = !value.empty();
+      spec.method = std::string(value);
+    } else if (key == "path") {
+      ok = !value.empty() && value.front() == '/';
+      spec.paths.emplace_back(value);
+    } else if (key == "header") {
+      ok = value.find(':') != std::string_view::npos &&
+           ExpandHeader(value, &spec.headers);
+      spec.headers += "\r\n";
+    } else if (key == "body-size") {
+      ok = ParseBodySizes(value, &spec.body_sizes);
+    } else if (key == "variants") {
+      ok = ParseNumber(value, &number) && number > 0 && number <= 4096;
+      spec.variants = static_cast<int>(number);
+    } else {
+      *error = where + "未知的键: " + std::string(key);
+      return nullptr;
+    }
+    if (!ok) {
+      *error = where + "值无效: " + std::string(value);
+      return nullptr;
+    }
+  }
+
+  if (specs.empty()) {
+    *error = file + ": 没有任何条目";
+    return nullptr;
+  }
+
+  // 生成请求：每个路径按请求体长度分布取variants个样本，固定长度时只生成一个；
+  // 随机数种子固定，同一个场景文件每次生成的请求相同
+  std::unique_ptr<Scenario> scenario(new Scenario());
+  std::mt19937_64 rng(1);
+  std::string host = "Host: " + ip + ":" + std::to_string(port) + "\r\n";
+  for (EntrySpec& spec : specs) {
+    if (spec.paths.empty()) {
+      *error = file + ": 条目 " + spec.name + " 没有路径";
+      return nullptr;
+    }
+
+    bool varied = spec.body_sizes.kind == BodySizes::Kind::kUniform ||
+                  spec.body_sizes.kind == BodySizes::Kind::kChoice;
+    int variants = varied ? spec.variants : 1;
+
+    Entry entry;
+    entry.name = spec.name;
+    entry.weight = spec.weight;
+    for (const std::string& path : spec.paths) {
+      for (int i = 0; i < variants; ++i) {
+        std::string body(spec.body_sizes.Sample(&rng), 'x');
+        entry.templates.emplace_back(spec.method, path, host + spec.headers,
+                                     body);
+      }
+    }
+    scenario->AddEntry(std::move(entry));
+  }
+  return scenario;
+}
+
+PickedRequest Scenario::Pick(std::mt19937_64* rng) const {
+  // 只有一个请求时不消耗随机数
+  if (entries_.size() == 1 && entries_[0].templates.size() == 1) {
+    return {&entries_[0].templates[0], 0};
+  }
+
+  uint64_t point = std::uniform_int_distribution<uint64_t>(
+      0, cumulative_.back() - 1)(*rng);
+  size_t entry = std::upper_bound(cumulative_.begin(), cumulative_.end(),
+                                  point) -
+                 cumulative_.begin();
+  const std::vector<RequestTemplate>& templates = entries_[entry].templates;
+  size_t index = templates.size() == 1
+                     ? 0
+                     : std::uniform_int_distribution<size_t>(
+                           0, templates.size() - 1)(*rng);
+  return {&templates[index], entry};
+}
+
+const std::vector<Scenario::Entry>& Scenario::GetEntries() const {
+  return entries_;
+}
+
+bool Scenario::HasSequence() const {
+  return has_sequence_;
+}
+
+void Scenario::AddEntry(Entry entry) {
+  for (const RequestTemplate& request : entry.templates) {
+    has_sequence_ = has_sequence_ || request.HasSequence();
+  }
+  uint64_t total = cumulative_.empty() ? 0 : cumulative_.back();
+  cumulative_.push_back(total + entry.weight);
+  entries_.push_back(std::move(entry));
+}
@@ -0,0 +1,72 @@
+// 压测场景：按权重混合的请求模板
+#ifndef SCENARIO_H_
+#define SCENARIO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "request_template.h"
+
+// 选中的一个请求
+struct PickedRequest {
+  const RequestTemplate* request;  // 请求模板
+  size_t entry;                    // 所属条目的下标
+};
+
+// 压测场景
+// 由若干条目组成，每个条目是一类请求，按权重随机选择。场景文件逐行书写，
+// #开头的行是注释，[名字]开始一个条目，条目内的每行是“键 值”：
+//   weight 30                       权重，默认1
+//   method POST                     请求方法，默认GET
+//   path /users/{seq}               路径，可以写多行，每个请求随机取一个
+//   header Cookie: s={bytes:4096}   请求头，可以写多行，{bytes:N}替换为N个字符
+//   body-size 100-8192              请求体长度：N、A-B（均匀）或A,B,C（任取）
+//   variants 16                     每个路径按请求体长度分布预先生成的请求数
+// 所有请求在加载时就生成好完整的字节，压测期间选择请求只是查表，
+// 不再拼接字符串；只有路径中带{seq}时才在发送时填入序号。
+class Scenario {
+ public:
+  // 一个条目
+  struct Entry {
+    std::string name;                         // 名字
+    uint32_t weight;                          // 权重
+    std::vector<RequestTemplate> templates;   // 预先生成的请求
+  };
+
+  // 只有一个条目的场景：对path的GET请求
+  Scenario(const std::string& ip, int port, const std::string& path);
+  ~Scenario();
+
+  Scenario(const Scenario&) = delete;
+  Scenario& operator=(const Scenario&) = delete;
+
+  // 从文件加载场景，失败时返回空并输出原因到*error
+  static std::unique_ptr<Scenario> Load(const std::string& file,
+                                        const std::string& ip, int port,
+                                        std::string* error);
+
+  // 按权重随机选择一个请求
+  PickedRequest Pick(std::mt19937_64* rng) const;
+
+  // 获取所有条目
+  const std::vector<Entry>& GetEntries() const;
+
+  // 是否有请求的路径中带序号占位符
+  bool HasSequence() const;
+
+ private:
+  Scenario();
+
+  // 加入一个条目，计算累计权重
+  void AddEntry(Entry entry);
+
+  std::vector<Entry> entries_;        // 所有条目
+  std::vector<uint64_t> cumulative_;  // 累计权重，用于按权重选择
+  bool has_sequence_;                 // 是否有请求带序号占位符
+};
+
+#endif  // SCENARIO_H_
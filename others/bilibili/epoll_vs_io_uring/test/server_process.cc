@@ -0,0 +1,168 @@
+// 在子进程中启动被测服务器实现
+#include "server_process.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+namespace {
+
+// 本机回环地址
+struct sockaddr_in LoopbackAddress(int port) {
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return addr;
+}
+
+}  // namespace
+
+ServerProcess::ServerProcess() : pid_(-1), port_(0), pinned_(false) {
+  CPU_ZERO(&cpus_);
+}
+
+ServerProcess::~ServerProcess() {
+  Stop();
+}
+
+void ServerProcess::SetCpus(const cpu_set_t& cpus) {
+  cpus_ = cpus;
+  pinned_ = true;
+}
+
+bool ServerProcess::Start(const std::string& binary,
+                          const std::vector<std::string>& args,
+                          std::string* error) {
+  if (access(binary.c_str(), X_OK) < 0) {
+    *error = "无法执行服务器: " + binary;
+    return false;
+  }
+
+  port_ = FindFreePort();
+  if (port_ <= 0) {
+    *error = "找不到空闲端口";
+    return false;
+  }
+
+  // 参数在fork之前准备好，子进程中只调用exec前允许的函数
+  std::string port = std::to_string(port_);
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(binary.c_str()));
+  argv.push_back(const_cast<char*>(port.c_str()));
+  for (const std::string& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  pid_ = fork();
+  if (pid_ < 0) {
+    *error = std::string("fork失败: ") + strerror(errno);
+    return false;
+  }
+  if (pid_ == 0) {
+    // 绑定CPU在exec之前完成，服务器的所有线程都继承
+    if (pinned_ && sched_setaffinity(0, sizeof(cpus_), &cpus_) < 0) {
+      _exit(126);
+    }
+    int null_fd = open("/dev/null", O_RDWR);
+    if (null_fd >= 0) {
+      dup2(null_fd, STDOUT_FILENO);
+      dup2(null_fd, STDERR_FILENO);
+    }
+    execv(binary.c_str(), argv.data());
+    _exit(127);
+  }
+
+  // 轮询到端口可以连接，子进程提前退出说明启动失败
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(kStartTimeoutMs);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (IsListening()) {
+      return true;
+    }
+    if (WaitExit(0)) {
+      *error = "服务器启动后立即退出: " + binary;
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  *error = "服务器没有在端口 " + port + " 上监听: " + binary;
+  Stop();
+  return false;
+}
+
+void ServerProcess::Stop() {
+  if (pid_ <= 0) {
+    return;
+  }
+  kill(pid_, SIGINT);
+  if (!WaitExit(kStopTimeoutMs)) {
+    kill(pid_, SIGKILL);
+    WaitExit(-1);
+  }
+}
+
+pid_t ServerProcess::GetPid() const {
+  return pid_;
+}
+
+int ServerProcess::GetPort() const {
+  return port_;
+}
+
+int ServerProcess::FindFreePort() {
+  // 绑定0端口由内核分配，关闭后把这个端口交给服务器
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr = LoopbackAddress(0);
+  socklen_t len = sizeof(addr);
+  int port = -1;
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+      getsockname(fd, (struct sockaddr*)&addr, &len) == 0) {
+    port = ntohs(addr.sin_port);
+  }
+  close(fd);
+  return port;
+}
+
+bool ServerProcess::IsListening() const {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct sockaddr_in addr = LoopbackAddress(port_);
+  bool ok = connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+  close(fd);
+  return ok;
+}
+
+bool ServerProcess::WaitExit(int timeout_ms) {
+  // timeout_ms为负数时一直等待
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+  for (;;) {
+    int status;
+    pid_t ret = waitpid(pid_, &status, timeout_ms < 0 ? 0 : WNOHANG);
+    if (ret == pid_ || (ret < 0 && errno != EINTR)) {
+      pid_ = -1;
+      return true;
+    }
+    if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
@@ -0,0 +1,58 @@
+// 在子进程中启动被测服务器
+#ifndef SERVER_PROCESS_H_
+#define SERVER_PROCESS_H_
+
+#include <sched.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+// 被测服务器进程
+// 在本机找一个空闲端口，以“端口 [其他参数]”启动服务器，等到端口可以连接
+// 才算启动完成；析构时先发SIGINT让服务器正常退出，超时再强制结束。
+// 服务器的输出重定向到/dev/null，避免打印请求日志影响性能。
+class ServerProcess {
+ public:
+  ServerProcess();
+  ~ServerProcess();
+
+  ServerProcess(const ServerProcess&) = delete;
+  ServerProcess& operator=(const ServerProcess&) = delete;
+
+  // 启动时把服务器绑定到cpus，只影响之后的Start
+  void SetCpus(const cpu_set_t& cpus);
+
+  // 启动服务器，args为端口之后的参数，失败时输出原因到*error
+  bool Start(const std::string& binary, const std::vector<std::string>& args,
+             std::string* error);
+
+  // 停止服务器并回收子进程
+  void Stop();
+
+  // 获取进程号，未启动时为-1
+  pid_t GetPid() const;
+
+  // 获取监听端口
+  int GetPort() const;
+
+ private:
+  static constexpr int kStartTimeoutMs = 5000;  // 等待端口可连接的时间
+  static constexpr int kStopTimeoutMs = 5000;   // 等待正常退出的时间
+
+  // 找一个当前空闲的端口
+  static int FindFreePort();
+
+  // 端口是否已经可以连接
+  bool IsListening() const;
+
+  // 等待子进程退出，超时返回false
+  bool WaitExit(int timeout_ms);
+
+  pid_t pid_;       // 子进程号
+  int port_;        // 监听端口
+  cpu_set_t cpus_;  // 服务器绑定的CPU
+  bool pinned_;     // 是否绑定CPU
+};
+
+#endif  // SERVER_PROCESS_H_
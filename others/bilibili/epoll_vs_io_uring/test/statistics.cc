@@ -0,0 +1,124 @@
+// 重复测量的统计实现
+#include "statistics.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+// 按分组标记取两组的中位数之差，in_a[i]为真的样本属于第一组
+double MedianDifference(const std::vector<double>& pooled,
+                        const std::vector<char>& in_a,
+                        std::vector<double>* a, std::vector<double>* b) {
+  a->clear();
+  b->clear();
+  for (size_t i = 0; i < pooled.size(); ++i) {
+    (in_a[i] ? a : b)->push_back(pooled[i]);
+  }
+  return Median(*a) - Median(*b);
+}
+
+// 组合数，超过limit时返回limit + 1
+uint64_t Combinations(size_t n, size_t k, uint64_t limit) {
+  k = std::min(k, n - k);
+  uint64_t result = 1;
+  for (size_t i = 1; i <= k; ++i) {
+    result = result * (n - k + i) / i;
+    if (result > limit) {
+      return limit + 1;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+double Median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0;
+  }
+  size_t middle = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + middle, values.end());
+  if (values.size() % 2 == 1) {
+    return values[middle];
+  }
+  double upper = values[middle];
+  double lower = *std::max_element(values.begin(), values.begin() + middle);
+  return (lower + upper) / 2;
+}
+
+Interval BootstrapMedianInterval(const std::vector<double>& samples,
+                                 double confidence, int resamples,
+                                 uint64_t seed) {
+  if (samples.size() < 2 || resamples <= 0) {
+    double value = Median(samples);
+    return {value, value};
+  }
+
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+  std::vector<double> medians;
+  std::vector<double> resample(samples.size());
+  medians.reserve(resamples);
+  for (int i = 0; i < resamples; ++i) {
+    for (double& value : resample) {
+      value = samples[pick(rng)];
+    }
+    medians.push_back(Median(resample));
+  }
+
+  // 两侧各去掉(1 - confidence) / 2
+  std::sort(medians.begin(), medians.end());
+  double tail = (1 - confidence) / 2;
+  size_t low = static_cast<size_t>(floor(tail * (resamples - 1)));
+  size_t high = static_cast<size_t>(ceil((1 - tail) * (resamples - 1)));
+  return {medians[low], medians[std::min(high, medians.size() - 1)]};
+}
+
+double PermutationTest(const std::vector<double>& a,
+                       const std::vector<double>& b, int max_permutations,
+                       uint64_t seed) {
+  if (a.size() < 2 || b.size() < 2 || max_permutations <= 0) {
+    return 1;
+  }
+
+  std::vector<double> pooled(a);
+  pooled.insert(pooled.end(), b.begin(), b.end());
+  std::vector<char> in_a(pooled.size(), 0);
+  std::fill(in_a.begin(), in_a.begin() + a.size(), 1);
+  std::vector<double> group_a;
+  std::vector<double> group_b;
+
+  // 浮点误差不应让与实际分组等价的分组被算作更小
+  double observed = fabs(MedianDifference(pooled, in_a, &group_a, &group_b));
+  double tolerance = observed * 1e-9;
+
+  uint64_t total = Combinations(pooled.size(), a.size(), max_permutations);
+  uint64_t extreme = 0;
+  uint64_t count = 0;
+  if (total <= static_cast<uint64_t>(max_permutations)) {
+    // 标记的字典序排列恰好枚举每种分组一次，从最小的排列开始
+    std::sort(in_a.begin(), in_a.end());
+    do {
+      double difference = MedianDifference(pooled, in_a, &group_a, &group_b);
+      if (fabs(difference) >= observed - tolerance) {
+        ++extreme;
+      }
+      ++count;
+    } while (std::next_permutation(in_a.begin(), in_a.end()));
+    return static_cast<double>(extreme) / count;
+  }
+
+  // 随机分组时把实际分组也算进去，p值不会为0
+  std::mt19937_64 rng(seed);
+  for (int i = 0; i < max_permutations; ++i) {
+    std::shuffle(in_a.begin(), in_a.end(), rng);
+    double difference = MedianDifference(pooled, in_a, &group_a, &group_b);
+    if (fabs(difference) >= observed - tolerance) {
+      ++extreme;
+    }
+  }
+  return (extreme + 1.0) / (max_permutations + 1.0);
+}
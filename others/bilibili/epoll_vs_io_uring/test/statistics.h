@@ -0,0 +1,34 @@
+// 重复测量的统计：中位数、自助法置信区间和置换检验
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+#include <stdint.h>
+#include <vector>
+
+// 置信区间
+struct Interval {
+  double low;   // 下界
+  double high;  // 上界
+};
+
+// 中位数，偶数个时取中间两个的平均，为空时返回0
+double Median(std::vector<double> values);
+
+// 中位数的自助法置信区间
+// 有放回地重抽样resamples次，取各次中位数的百分位区间；只有一个样本时
+// 上下界都是它本身。样本很少时区间受样本本身的取值限制，偏窄，
+// 重复次数至少应有5次左右。seed固定时结果可以复现
+Interval BootstrapMedianInterval(const std::vector<double>& samples,
+                                 double confidence, int resamples,
+                                 uint64_t seed);
+
+// 两组样本中位数之差的双侧置换检验，返回p值
+// 把两组样本合在一起重新分组，统计中位数之差不小于实际差值的分组比例。
+// 分组方式不超过max_permutations种时逐一枚举，结果是精确的；否则随机抽取
+// max_permutations种。任一组少于2个样本时无法检验，返回1。
+// 每组5个样本时最小的p值约为0.008，每组3个时只有0.1，永远不会显著
+double PermutationTest(const std::vector<double>& a,
+                       const std::vector<double>& b, int max_permutations,
+                       uint64_t seed);
+
+#endif  // STATISTICS_H_
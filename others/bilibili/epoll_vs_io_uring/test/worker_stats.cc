@@ -0,0 +1,54 @@
+// 压测工作线程的统计实现
+#include "worker_stats.h"
+
+WorkerStats::WorkerStats(uint64_t start, uint64_t series_interval,
+                         size_t entries)
+    : success(0),
+      fail(0),
+      connections(0),
+      late(0),
+      non_2xx(0),
+      misordered(0),
+      syscalls(0),
+      series(start, series_interval),
+      entries(entries) {}
+
+void WorkerStats::RecordResponse(size_t entry, uint64_t end, uint64_t elapsed,
+                                 int status) {
+  latency.Record(elapsed);
+  series.Record(end, elapsed);
+  ++success;
+
+  EntryStats& stats = entries[entry];
+  stats.latency.Record(elapsed);
+  ++stats.success;
+
+  // 限速、过载等错误响应也算作成功的请求，单独计数
+  if (status < 200 || status >= 300) {
+    ++non_2xx;
+    ++stats.non_2xx;
+  }
+}
+
+void WorkerStats::RecordFailure(size_t entry) {
+  ++fail;
+  ++entries[entry].fail;
+}
+
+void WorkerStats::Merge(const WorkerStats& other) {
+  success += other.success;
+  fail += other.fail;
+  connections += other.connections;
+  late += other.late;
+  non_2xx += other.non_2xx;
+  misordered += other.misordered;
+  syscalls += other.syscalls;
+  latency.Merge(other.latency);
+  series.Merge(other.series);
+  for (size_t i = 0; i < entries.size() && i < other.entries.size(); ++i) {
+    entries[i].success += other.entries[i].success;
+    entries[i].fail += other.entries[i].fail;
+    entries[i].non_2xx += other.entries[i].non_2xx;
+    entries[i].latency.Merge(other.entries[i].latency);
+  }
+}
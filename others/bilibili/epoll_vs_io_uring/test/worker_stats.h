@@ -0,0 +1,48 @@
+// 压测工作线程的统计
+#ifndef WORKER_STATS_H_
+#define WORKER_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "latency_histogram.h"
+
+// 场景中一个条目的统计
+struct EntryStats {
+  EntryStats() : success(0), fail(0), non_2xx(0) {}
+
+  uint64_t success;           // 成功的请求数
+  uint64_t fail;              // 发出后失败的请求数
+  uint64_t non_2xx;           // 状态码不是2xx的响应数
+  LatencyHistogram latency;   // 成功请求的延迟
+};
+
+// 每个工作线程的统计，线程结束后再合并，记录期间线程之间不共享任何数据
+struct WorkerStats {
+  // entries为场景的条目数
+  WorkerStats(uint64_t start, uint64_t series_interval, size_t entries);
+
+  // 记录一个完整的响应，end为完成时刻，elapsed为延迟
+  void RecordResponse(size_t entry, uint64_t end, uint64_t elapsed,
+                      int status);
+
+  // 记录发出后失败（连接断开、响应格式错误等）的请求
+  void RecordFailure(size_t entry);
+
+  // 合并另一个线程的统计
+  void Merge(const WorkerStats& other);
+
+  uint64_t success;                 // 成功的请求数
+  uint64_t fail;                    // 失败的请求数，包括建立连接失败
+  uint64_t connections;             // 新建的连接数，用于确认连接复用的效果
+  uint64_t late;                    // 开环模式下晚于计划时刻发送的请求数
+  uint64_t non_2xx;                 // 状态码不是2xx的响应数，计入成功的请求
+  uint64_t misordered;              // 流水线中与请求对不上的2xx响应数
+  uint64_t syscalls;                // 读写系统调用的次数
+  LatencyHistogram latency;         // 成功请求的延迟
+  LatencyTimeSeries series;         // 按完成时间分段的延迟
+  std::vector<EntryStats> entries;  // 各条目的统计
+};
+
+#endif  // WORKER_STATS_H_